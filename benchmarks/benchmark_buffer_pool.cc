@@ -0,0 +1,80 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_buffer_pool.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/serialization_buffer_pool.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+// Small messages, where allocating the buffer is a large part of the cost
+template <typename Handler>
+void BM_serialize_small_message(benchmark::State& state) {
+  std::vector<int> message(state.range(0) / sizeof(int), 42);
+  std::size_t size = 0;
+  for(auto _ : state) {
+    auto buffer = Handler::serialize(message);
+    benchmark::DoNotOptimize(buffer.data());
+    size = buffer.capacity();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+  state.SetItemsProcessed(state.iterations());
+}
+
+using default_handler_t = SimpleSerializationHandler<>;
+using pooled_handler_t = SimpleSerializationHandler<PooledSerializationBufferAllocator<>>;
+
+} // end anonymous namespace
+
+BENCHMARK_TEMPLATE(BM_serialize_small_message, default_handler_t)
+  ->RangeMultiplier(4)->Range(8, 1 << 16);
+BENCHMARK_TEMPLATE(BM_serialize_small_message, pooled_handler_t)
+  ->RangeMultiplier(4)->Range(8, 1 << 16);
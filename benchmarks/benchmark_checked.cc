@@ -0,0 +1,102 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_checked.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+using handler_t = SimpleSerializationHandler<>;
+
+// One bulk read, which the checked archive checks once
+std::vector<double> make_doubles(std::size_t payload_bytes) {
+  return std::vector<double>(payload_bytes / sizeof(double) + 1, 1.5);
+}
+
+// A size prefix and a short raw read per string, each checked
+std::vector<std::string> make_strings(std::size_t payload_bytes) {
+  return std::vector<std::string>(payload_bytes / 24 + 1, std::string(16, 'x'));
+}
+
+template <typename T, T (*make)(std::size_t)>
+void BM_unchecked_deserialize(benchmark::State& state) {
+  auto buffer = handler_t::serialize(make(state.range(0)));
+  for(auto _ : state) {
+    auto output = handler_t::deserialize<T>(buffer);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.capacity());
+}
+
+template <typename T, T (*make)(std::size_t)>
+void BM_checked_deserialize(benchmark::State& state) {
+  auto buffer = handler_t::serialize(make(state.range(0)));
+  for(auto _ : state) {
+    std::error_code error;
+    auto output = handler_t::deserialize_checked<T>(buffer, error);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::DoNotOptimize(error);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.capacity());
+}
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_payload;
+using darma_serialization_benchmarks::sweep_node_payload;
+
+using doubles_t = std::vector<double>;
+using strings_t = std::vector<std::string>;
+
+BENCHMARK_TEMPLATE(BM_unchecked_deserialize, doubles_t, make_doubles)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_checked_deserialize, doubles_t, make_doubles)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_unchecked_deserialize, strings_t, make_strings)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_checked_deserialize, strings_t, make_strings)->Apply(sweep_node_payload);
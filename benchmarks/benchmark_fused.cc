@@ -0,0 +1,130 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_fused.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+#include <darma/serialization/fused.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+// Neither is directly serializable (they have a serialize() method), so a
+// vector of them is packed one member at a time
+struct Cell {
+  std::int32_t i = 1, j = 2, k = 3, level = 4;
+  double value = 0.5;
+};
+
+struct FusedCell : Cell {
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | fused(i, j, k, level, value); }
+};
+
+struct UnfusedCell : Cell {
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | i | j | k | level | value; }
+};
+
+using handler_t = SimpleSerializationHandler<>;
+
+template <typename CellT>
+void BM_serialize(benchmark::State& state) {
+  std::vector<CellT> input(state.range(0) / sizeof(Cell) + 1);
+  for(auto _ : state) {
+    auto buffer = handler_t::serialize(input);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+template <typename CellT>
+void BM_deserialize(benchmark::State& state) {
+  std::vector<CellT> input(state.range(0) / sizeof(Cell) + 1);
+  auto buffer = handler_t::serialize(input);
+  for(auto _ : state) {
+    auto output = handler_t::deserialize<std::vector<CellT>>(buffer);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Archives that check every write or read: fusing makes that one check per run
+template <typename CellT>
+void BM_serialize_single_pass(benchmark::State& state) {
+  std::vector<CellT> input(state.range(0) / sizeof(Cell) + 1);
+  for(auto _ : state) {
+    auto buffer = handler_t::serialize_single_pass(input);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+template <typename CellT>
+void BM_deserialize_checked(benchmark::State& state) {
+  std::vector<CellT> input(state.range(0) / sizeof(Cell) + 1);
+  auto buffer = handler_t::serialize(input);
+  for(auto _ : state) {
+    auto output = handler_t::deserialize_checked<std::vector<CellT>>(buffer);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_node_payload;
+
+BENCHMARK_TEMPLATE(BM_serialize, UnfusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_serialize, FusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_deserialize, UnfusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_deserialize, FusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_serialize_single_pass, UnfusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_serialize_single_pass, FusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_deserialize_checked, UnfusedCell)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_deserialize_checked, FusedCell)->Apply(sweep_node_payload);
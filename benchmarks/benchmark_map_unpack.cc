@@ -0,0 +1,125 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_map_unpack.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+using namespace darma::serialization;
+
+namespace {
+
+// Unhinted insertion, which is how std::map and std::set were unpacked before
+// taking advantage of the elements being packed in sorted order
+template <typename Container, typename Archive>
+void unhinted_unpack(void* allocated, Archive& ar) {
+  auto size = ar.template unpack_next_item_as<typename Container::size_type>();
+  auto& obj = *(new (allocated) Container());
+  for(typename Container::size_type i = 0; i < size; ++i) {
+    obj.emplace(ar.template unpack_next_item_as<typename Container::value_type>());
+  }
+}
+
+template <typename Container>
+Container make_container(std::size_t n);
+
+template <>
+std::map<int, int> make_container<std::map<int, int>>(std::size_t n) {
+  std::map<int, int> rv;
+  for(std::size_t i = 0; i < n; ++i) rv.emplace_hint(rv.end(), 3 * i, i);
+  return rv;
+}
+
+template <>
+std::set<int> make_container<std::set<int>>(std::size_t n) {
+  std::set<int> rv;
+  for(std::size_t i = 0; i < n; ++i) rv.emplace_hint(rv.end(), 3 * i);
+  return rv;
+}
+
+template <>
+std::map<std::string, double> make_container<std::map<std::string, double>>(std::size_t n) {
+  std::map<std::string, double> rv;
+  for(std::size_t i = 0; i < n; ++i) rv.emplace("key_" + std::to_string(i), i);
+  return rv;
+}
+
+template <typename Container, bool Hinted>
+void BM_unpack_sorted(benchmark::State& state) {
+  using handler_t = SimpleSerializationHandler<>;
+  auto input = make_container<Container>(state.range(0));
+  auto buffer = handler_t::serialize(input);
+  std::aligned_storage_t<sizeof(Container), alignof(Container)> storage;
+  for(auto _ : state) {
+    auto ar = handler_t::make_unpacking_archive(buffer);
+    if(Hinted) {
+      ar.template unpack_next_item_at<Container>(&storage);
+    }
+    else {
+      unhinted_unpack<Container>(&storage, ar);
+    }
+    auto* output = reinterpret_cast<Container*>(&storage);
+    benchmark::DoNotOptimize(output->size());
+    output->~Container();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.capacity());
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * input.size());
+}
+
+using map_int_int = std::map<int, int>;
+using set_int = std::set<int>;
+using map_string_double = std::map<std::string, double>;
+
+} // end anonymous namespace
+
+BENCHMARK_TEMPLATE(BM_unpack_sorted, map_int_int, false)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_unpack_sorted, map_int_int, true)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_unpack_sorted, set_int, false)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_unpack_sorted, set_int, true)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_unpack_sorted, map_string_double, false)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_unpack_sorted, map_string_double, true)->RangeMultiplier(10)->Range(1000, 1000000);
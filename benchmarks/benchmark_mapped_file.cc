@@ -0,0 +1,142 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_mapped_file.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#ifdef DARMA_SERIALIZATION_HAS_MMAP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace darma::serialization;
+
+namespace {
+
+std::string checkpoint_path() {
+  return "darma_serialization_benchmark_checkpoint." + std::to_string(::getpid());
+}
+
+// Checkpointing: serialize into a buffer and write() it, versus packing
+// straight into a mapping of the file
+void BM_checkpoint_write(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  auto path = checkpoint_path();
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize(input);
+    auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    benchmark::DoNotOptimize(::write(fd, buffer.data(), buffer.capacity()));
+    ::close(fd);
+  }
+  std::remove(path.c_str());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_checkpoint_mapped(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  auto path = checkpoint_path();
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize_to_file(
+      path, MappedFileHints{}, input
+    );
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  std::remove(path.c_str());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// Restarting (from the page cache): read() the file into a buffer and
+// deserialize it, versus deserializing from a mapping of the file
+void BM_restart_read(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  auto path = checkpoint_path();
+  SimpleSerializationHandler<>::serialize_to_file(path, MappedFileHints{}, input);
+  for(auto _ : state) {
+    auto fd = ::open(path.c_str(), O_RDONLY);
+    auto size = static_cast<size_t>(::lseek(fd, 0, SEEK_END));
+    ::lseek(fd, 0, SEEK_SET);
+    DynamicSerializationBuffer<> buffer(size);
+    for(size_t done = 0; done < size; ) {
+      auto n = ::read(fd, buffer.data() + done, size - done);
+      if(n <= 0) break;
+      done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    auto output = SimpleSerializationHandler<>::deserialize<std::vector<double>>(buffer);
+    benchmark::DoNotOptimize(output.data());
+  }
+  std::remove(path.c_str());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+void BM_restart_mapped(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  auto path = checkpoint_path();
+  SimpleSerializationHandler<>::serialize_to_file(path, MappedFileHints{}, input);
+  for(auto _ : state) {
+    auto output = SimpleSerializationHandler<>::deserialize_from_file<std::vector<double>>(path);
+    benchmark::DoNotOptimize(output.data());
+  }
+  std::remove(path.c_str());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+// The files have to fit on disk, so stop short of the largest payloads
+void sweep_file_payload(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(4096, 1 << 27);
+}
+
+} // end anonymous namespace
+
+BENCHMARK(BM_checkpoint_write)->Apply(sweep_file_payload);
+BENCHMARK(BM_checkpoint_mapped)->Apply(sweep_file_payload);
+BENCHMARK(BM_restart_read)->Apply(sweep_file_payload);
+BENCHMARK(BM_restart_mapped)->Apply(sweep_file_payload);
+
+#endif // DARMA_SERIALIZATION_HAS_MMAP
@@ -0,0 +1,344 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_polymorphic.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/allocators/monotonic_arena_allocator.h>
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/polymorphic/polymorphic_serialization_adapter.h>
+#include <darma/serialization/serializers/all.h>
+#include <darma/serialization/simple_handler.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <unordered_map>
+
+using namespace darma::serialization;
+
+namespace {
+
+struct Shape : PolymorphicSerializableObject<Shape> {
+  virtual ~Shape() = default;
+  virtual double area() const = 0;
+};
+
+struct Circle : PolymorphicSerializationAdapter<Circle, Shape> {
+  double radius = 0.0;
+  Circle() = default;
+  explicit Circle(double r) : radius(r) { }
+  double area() const override { return 3.0 * radius * radius; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | radius; }
+};
+
+struct Rectangle : PolymorphicSerializationAdapter<Rectangle, Shape> {
+  double width = 0.0, height = 0.0;
+  Rectangle() = default;
+  Rectangle(double w, double h) : width(w), height(h) { }
+  double area() const override { return width * height; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | width | height; }
+};
+
+struct Triangle : PolymorphicSerializationAdapter<Triangle, Shape> {
+  double base = 0.0, height = 0.0;
+  Triangle() = default;
+  Triangle(double b, double h) : base(b), height(h) { }
+  double area() const override { return 0.5 * base * height; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | base | height; }
+};
+
+struct Polygon : PolymorphicSerializationAdapter<Polygon, Shape> {
+  int n_sides = 0;
+  double side = 0.0;
+  Polygon() = default;
+  Polygon(int n, double s) : n_sides(n), side(s) { }
+  double area() const override { return n_sides * side * side; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | n_sides | side; }
+};
+
+// For comparison: std::function rather than plain function pointers, with the
+// concrete type ids looked up in a std::unordered_map rather than the
+// registry's flat open-addressing table, and with an unconditional linear
+// search through the bases table
+using reference_registry_t = std::unordered_map<
+  std::uint64_t, std::function<std::unique_ptr<Shape>(char const*&)>
+>;
+
+template <typename ConcreteT>
+void add_reference_entry(reference_registry_t& reg) {
+  auto id = detail::_impl::PolymorphicUnpackRegistrarWrapper<Shape, ConcreteT>::registrar.id;
+  reg[id] = [](char const*& buffer) {
+    return std::unique_ptr<Shape>(
+      ConcreteT::_darma_static_polymorphic_serializable_adapter_unpack(buffer, nullptr).release()
+    );
+  };
+}
+
+// Registered types whose unpack does no work other than skipping over their
+// payload, so that the dispatch itself can be measured without the heap
+// allocation of the unpacked object dominating
+template <int Which>
+struct DispatchOnly {
+  static std::unique_ptr<Shape> unpack(char const*& buffer) {
+    buffer += sizeof(int);
+    return nullptr;
+  }
+};
+
+template <int Which>
+void add_reference_dispatch_only_entry(reference_registry_t& reg) {
+  auto id = detail::_impl::PolymorphicUnpackRegistrarWrapper<Shape, DispatchOnly<Which>>::registrar.id;
+  reg[id] = [](char const*& buffer) {
+    return DispatchOnly<Which>::unpack(buffer);
+  };
+}
+
+reference_registry_t const& reference_registry() {
+  static auto reg = [] {
+    reference_registry_t rv;
+    add_reference_entry<Circle>(rv);
+    add_reference_entry<Rectangle>(rv);
+    add_reference_entry<Triangle>(rv);
+    add_reference_entry<Polygon>(rv);
+    add_reference_dispatch_only_entry<0>(rv);
+    add_reference_dispatch_only_entry<1>(rv);
+    add_reference_dispatch_only_entry<2>(rv);
+    add_reference_dispatch_only_entry<3>(rv);
+    return rv;
+  }();
+  return reg;
+}
+
+std::unique_ptr<Shape> reference_unpack(char const*& buffer) {
+  using header_t = detail::SerializedPolymorphicObjectHeader;
+  using entry_t = detail::PolymorphicAbstractBasesTableEntry;
+  static const std::uint64_t abstract_type_id = polymorphic_type_id<Shape>::value();
+  auto const& header = *reinterpret_cast<header_t const*>(buffer);
+  buffer += sizeof(header_t);
+  size_t i_base = 0;
+  std::uint64_t concrete_id = 0;
+  for(; i_base < header.n_bases; ++i_base) {
+    auto const& entry = *reinterpret_cast<entry_t const*>(buffer);
+    if(abstract_type_id == entry.abstract_id) {
+      concrete_id = entry.concrete_id;
+      break;
+    }
+    buffer += sizeof(entry_t);
+  }
+  buffer += sizeof(entry_t) * (header.n_bases - i_base);
+  return reference_registry().at(concrete_id)(buffer);
+}
+
+// n objects whose concrete types are drawn at random from the above
+std::vector<std::unique_ptr<Shape>> make_mixed_objects(std::size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> which(0, 3);
+  std::vector<std::unique_ptr<Shape>> rv;
+  rv.reserve(n);
+  for(std::size_t i = 0; i < n; ++i) {
+    switch(which(gen)) {
+      case 0: rv.emplace_back(new Circle(i)); break;
+      case 1: rv.emplace_back(new Rectangle(i, 2.0)); break;
+      case 2: rv.emplace_back(new Triangle(i, 3.0)); break;
+      default: rv.emplace_back(new Polygon(5, i)); break;
+    }
+  }
+  return rv;
+}
+
+// Packs each object with its own header, one after another
+std::vector<char> pack_individually(std::vector<std::unique_ptr<Shape>> const& objects) {
+  std::size_t size = 0;
+  for(auto const& obj : objects) size += obj->get_packed_size();
+  std::vector<char> rv(size);
+  char* spot = rv.data();
+  for(auto const& obj : objects) obj->pack(spot);
+  return rv;
+}
+
+std::vector<char> make_mixed_buffer(std::size_t n) {
+  return pack_individually(make_mixed_objects(n));
+}
+
+template <int Which, typename HeaderFormat>
+void add_dispatch_only_object(std::vector<char>& buffer) {
+  using details_t = typename detail::polymorphic_serialization_details<
+    DispatchOnly<Which>, HeaderFormat
+  >::template with_abstract_bases<Shape>;
+  auto offset = buffer.size();
+  buffer.resize(offset + details_t::registry_frontmatter_size + sizeof(int));
+  details_t::add_registry_frontmatter_in_place(buffer.data() + offset);
+}
+
+template <typename HeaderFormat>
+std::vector<char> make_dispatch_only_buffer(std::size_t n) {
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> which(0, 3);
+  std::vector<char> rv;
+  for(std::size_t i = 0; i < n; ++i) {
+    switch(which(gen)) {
+      case 0: add_dispatch_only_object<0, HeaderFormat>(rv); break;
+      case 1: add_dispatch_only_object<1, HeaderFormat>(rv); break;
+      case 2: add_dispatch_only_object<2, HeaderFormat>(rv); break;
+      default: add_dispatch_only_object<3, HeaderFormat>(rv); break;
+    }
+  }
+  return rv;
+}
+
+// The reference path only understands WidePolymorphicHeader
+template <bool FunctionPointerRegistry, typename HeaderFormat>
+void BM_polymorphic_dispatch_mixed(benchmark::State& state) {
+  std::size_t n = state.range(0);
+  auto buffer = make_dispatch_only_buffer<HeaderFormat>(n);
+  for(auto _ : state) {
+    char const* spot = buffer.data();
+    for(std::size_t i = 0; i < n; ++i) {
+      if(FunctionPointerRegistry) benchmark::DoNotOptimize(Shape::unpack(spot));
+      else benchmark::DoNotOptimize(reference_unpack(spot));
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.size());
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+  // Each object has 4 bytes of data; the rest is the header
+  state.counters["bytes_per_object"] = static_cast<double>(buffer.size()) / n;
+}
+
+template <bool FunctionPointerRegistry>
+void BM_polymorphic_unpack_mixed(benchmark::State& state) {
+  std::size_t n = state.range(0);
+  auto buffer = make_mixed_buffer(n);
+  std::vector<std::unique_ptr<Shape>> output;
+  output.reserve(n);
+  for(auto _ : state) {
+    char const* spot = buffer.data();
+    for(std::size_t i = 0; i < n; ++i) {
+      if(FunctionPointerRegistry) output.push_back(Shape::unpack(spot));
+      else output.push_back(reference_unpack(spot));
+    }
+    benchmark::DoNotOptimize(output.data());
+    state.PauseTiming();
+    output.clear();
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.size());
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+}
+
+// Allocating the unpacked objects from an arena through a MemoryResource
+// rather than with new
+void BM_polymorphic_unpack_mixed_arena(benchmark::State& state) {
+  std::size_t n = state.range(0);
+  auto buffer = make_mixed_buffer(n);
+  MonotonicArena arena;
+  AllocatorMemoryResource<MonotonicArenaAllocator<char>> resource{
+    MonotonicArenaAllocator<char>(arena)
+  };
+  std::vector<polymorphic_unique_ptr<Shape>> output;
+  output.reserve(n);
+  for(auto _ : state) {
+    char const* spot = buffer.data();
+    for(std::size_t i = 0; i < n; ++i) {
+      output.push_back(Shape::unpack(spot, resource));
+    }
+    benchmark::DoNotOptimize(output.data());
+    state.PauseTiming();
+    output.clear();
+    arena.release();
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.size());
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+}
+
+// Objects grouped by concrete type (as, e.g., particles of a few species
+// would be), unpacked as a std::vector<std::unique_ptr<Shape>>, which looks
+// up the unpack function once per run, versus each object packed with its own
+// header and dispatched on individually
+template <bool Grouped>
+void BM_polymorphic_unpack_vector_runs(benchmark::State& state) {
+  using vector_t = std::vector<std::unique_ptr<Shape>>;
+  std::size_t n = state.range(0);
+  auto objects = make_mixed_objects(n);
+  std::stable_sort(objects.begin(), objects.end(),
+    [](auto const& a, auto const& b) { return typeid(*a).before(typeid(*b)); }
+  );
+  auto grouped_buffer = SimpleSerializationHandler<>::serialize(objects);
+  auto buffer = pack_individually(objects);
+  std::size_t buffer_size = Grouped ? grouped_buffer.capacity() : buffer.size();
+  for(auto _ : state) {
+    vector_t output;
+    if(Grouped) {
+      output = SimpleSerializationHandler<>::deserialize<vector_t>(grouped_buffer);
+    }
+    else {
+      output.reserve(n);
+      char const* spot = buffer.data();
+      for(std::size_t i = 0; i < n; ++i) output.push_back(Shape::unpack(spot));
+    }
+    benchmark::DoNotOptimize(output.data());
+    state.PauseTiming();
+    output.clear();
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer_size);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * n);
+  state.counters["bytes_per_object"] = static_cast<double>(buffer_size) / n;
+}
+
+} // end anonymous namespace
+
+BENCHMARK(BM_polymorphic_unpack_mixed_arena)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_dispatch_mixed, false, WidePolymorphicHeader)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_dispatch_mixed, true, WidePolymorphicHeader)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_dispatch_mixed, true, CompactPolymorphicHeader)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_unpack_mixed, false)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_unpack_mixed, true)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_unpack_vector_runs, false)->RangeMultiplier(10)->Range(1000, 1000000);
+BENCHMARK_TEMPLATE(BM_polymorphic_unpack_vector_runs, true)->RangeMultiplier(10)->Range(1000, 1000000);
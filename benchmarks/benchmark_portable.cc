@@ -0,0 +1,88 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_portable.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+// Packing and unpacking arrays in the host's byte order (a memcpy each way,
+// whether through the default handler or a portable one whose wire order
+// matches) versus the opposite one (a byte swap each way)
+template <typename Handler, typename T>
+void BM_round_trip(benchmark::State& state) {
+  std::vector<T> input(state.range(0) / sizeof(T), T(3));
+  for(auto _ : state) {
+    auto buffer = Handler::serialize(input);
+    auto output = Handler::template deserialize<std::vector<T>>(buffer);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+using native_t = SimpleSerializationHandler<>;
+using host_order_t = PortableSerializationHandler<
+  std::conditional_t<detail::host_is_little_endian(), LittleEndianByteOrder, BigEndianByteOrder>
+>;
+using swapped_order_t = PortableSerializationHandler<
+  std::conditional_t<detail::host_is_little_endian(), BigEndianByteOrder, LittleEndianByteOrder>
+>;
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_payload;
+
+BENCHMARK_TEMPLATE(BM_round_trip, native_t, double)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_round_trip, host_order_t, double)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_round_trip, swapped_order_t, double)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_round_trip, native_t, std::uint32_t)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_round_trip, swapped_order_t, std::uint32_t)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_round_trip, native_t, std::uint16_t)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_round_trip, swapped_order_t, std::uint16_t)->Apply(sweep_payload);
@@ -0,0 +1,99 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_scatter_gather.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+using blocks_t = std::map<std::string, std::vector<double>>;
+
+// A handful of large arrays with small keys and headers between them
+blocks_t make_blocks(std::size_t payload_bytes) {
+  blocks_t rv;
+  for(int i = 0; i < 8; ++i) {
+    rv["block " + std::to_string(i)].assign(payload_bytes / 8 / sizeof(double), 3.14);
+  }
+  return rv;
+}
+
+// Packing into one contiguous buffer, which copies every element
+void BM_contiguous_serialize(benchmark::State& state) {
+  auto input = make_blocks(state.range(0));
+  std::size_t size = 0;
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize(input);
+    benchmark::DoNotOptimize(buffer.data());
+    size = buffer.capacity();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+// Packing into segments for vectored I/O, which only copies the headers
+void BM_scatter_gather_serialize(benchmark::State& state) {
+  auto input = make_blocks(state.range(0));
+  std::size_t size = 0, inline_size = 0;
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize_scatter_gather(input);
+    benchmark::DoNotOptimize(buffer.segments().data());
+    size = buffer.size();
+    inline_size = buffer.inline_size();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+  state.counters["inline_bytes"] = static_cast<double>(inline_size);
+}
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_payload;
+
+BENCHMARK(BM_contiguous_serialize)->Apply(sweep_payload);
+BENCHMARK(BM_scatter_gather_serialize)->Apply(sweep_payload);
@@ -0,0 +1,330 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_serialization_common.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_BENCHMARK_SERIALIZATION_COMMON_H
+#define DARMAFRONTEND_BENCHMARK_SERIALIZATION_COMMON_H
+
+#include <benchmark/benchmark.h>
+
+#include <darma/serialization/simple_handler.h>
+#include <darma/serialization/pointer_reference_handler.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef DARMA_SERIALIZATION_BENCHMARK_MAX_PAYLOAD
+#  define DARMA_SERIALIZATION_BENCHMARK_MAX_PAYLOAD (1ll << 30)
+#endif
+
+#ifndef DARMA_SERIALIZATION_BENCHMARK_MAX_NODE_PAYLOAD
+#  define DARMA_SERIALIZATION_BENCHMARK_MAX_NODE_PAYLOAD (1ll << 26)
+#endif
+
+namespace darma_serialization_benchmarks {
+
+//==============================================================================
+// <editor-fold desc="payload sweeps"> {{{1
+
+inline void sweep_payload(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(8, DARMA_SERIALIZATION_BENCHMARK_MAX_PAYLOAD);
+}
+
+inline void sweep_node_payload(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(8, DARMA_SERIALIZATION_BENCHMARK_MAX_NODE_PAYLOAD);
+}
+
+// </editor-fold> end payload sweeps }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="payload generation"> {{{1
+
+// Each benchmark serializes `count` objects of type T whose packed sizes add up
+// to (roughly) the requested payload.  Types with a fixed packed size (e.g.,
+// arithmetic types) get one object per sizeof(T) bytes; types with a dynamic
+// size get a single object that is as large as the payload.  Specialize
+// payload_traits to control how a given type fills the payload.
+template <typename T, typename Enable=void>
+struct payload_traits {
+  // The default is for types with a fixed packed size
+  static std::size_t count_for(std::size_t payload_bytes) {
+    return payload_bytes < sizeof(T) ? 1 : payload_bytes / sizeof(T);
+  }
+  static std::size_t element_bytes_for(std::size_t /* payload_bytes */) {
+    return sizeof(T);
+  }
+};
+
+template <typename T>
+T make_value(std::size_t i, std::size_t element_bytes);
+
+template <typename T>
+struct _make_value_impl;
+
+template <typename T>
+T make_value(std::size_t i, std::size_t element_bytes) {
+  return _make_value_impl<T>::make(i, element_bytes);
+}
+
+template <typename T>
+void fill_value(T& dest, std::size_t i, std::size_t element_bytes) {
+  // Destroy and reconstruct in place so that types with const members work
+  dest.~T();
+  new (&dest) T(make_value<T>(i, element_bytes));
+}
+
+template <typename T, std::size_t N>
+void fill_value(T (&dest)[N], std::size_t i, std::size_t element_bytes) {
+  for(std::size_t j = 0; j < N; ++j) {
+    fill_value(dest[j], i * N + j, element_bytes / N);
+  }
+}
+
+template <typename T>
+struct Payload {
+
+  explicit Payload(std::size_t payload_bytes)
+    : count(payload_traits<T>::count_for(payload_bytes)),
+      objects(new T[count])
+  {
+    auto element_bytes = payload_traits<T>::element_bytes_for(payload_bytes);
+    for(std::size_t i = 0; i < count; ++i) {
+      fill_value(objects[i], i, element_bytes);
+    }
+    auto ar = darma::serialization::SimpleSerializationHandler<>::make_sizing_archive();
+    for(std::size_t i = 0; i < count; ++i) {
+      ar | objects[i];
+    }
+    packed_size = darma::serialization::SimpleSerializationHandler<>::get_size(ar);
+  }
+
+  std::size_t count;
+  std::unique_ptr<T[]> objects;
+  std::size_t packed_size;
+};
+
+// Uninitialized, properly aligned storage for the objects being unpacked
+template <typename T>
+struct UnpackDestination {
+
+  explicit UnpackDestination(std::size_t count)
+    : count_(count),
+      storage_(static_cast<T*>(::operator new(sizeof(T) * count)))
+  { }
+
+  void* operator[](std::size_t i) { return storage_ + i; }
+
+  // Called once per iteration, after the objects have been unpacked
+  void destroy_all() {
+    _destroy_all(storage_, count_);
+  }
+
+  ~UnpackDestination() {
+    ::operator delete(storage_);
+  }
+
+  private:
+
+    template <typename U>
+    static void _destroy_all(U* begin, std::size_t n) {
+      for(std::size_t i = 0; i < n; ++i) begin[i].~U();
+    }
+
+    template <typename U, std::size_t N>
+    static void _destroy_all(U (*begin)[N], std::size_t n) {
+      for(std::size_t i = 0; i < n; ++i) _destroy_all(begin[i], N);
+    }
+
+    std::size_t count_;
+    T* storage_;
+};
+
+template <typename T>
+void set_counters(benchmark::State& state, Payload<T> const& payload) {
+  state.SetBytesProcessed(
+    static_cast<int64_t>(state.iterations()) * payload.packed_size
+  );
+  state.SetItemsProcessed(
+    static_cast<int64_t>(state.iterations()) * payload.count
+  );
+}
+
+// </editor-fold> end payload generation }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="SimpleSerializationHandler benchmarks"> {{{1
+
+template <typename T>
+void BM_simple_size(benchmark::State& state) {
+  using handler_t = darma::serialization::SimpleSerializationHandler<>;
+  Payload<T> payload(state.range(0));
+  for(auto _ : state) {
+    auto ar = handler_t::make_sizing_archive();
+    for(std::size_t i = 0; i < payload.count; ++i) {
+      ar | payload.objects[i];
+    }
+    benchmark::DoNotOptimize(handler_t::get_size(ar));
+  }
+  set_counters(state, payload);
+}
+
+template <typename T>
+void BM_simple_serialize(benchmark::State& state) {
+  using handler_t = darma::serialization::SimpleSerializationHandler<>;
+  Payload<T> payload(state.range(0));
+  for(auto _ : state) {
+    for(std::size_t i = 0; i < payload.count; ++i) {
+      auto buffer = handler_t::serialize(payload.objects[i]);
+      benchmark::DoNotOptimize(buffer.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  set_counters(state, payload);
+}
+
+template <typename T>
+void BM_simple_deserialize(benchmark::State& state) {
+  using handler_t = darma::serialization::SimpleSerializationHandler<>;
+  using buffer_t = decltype(handler_t::serialize(std::declval<T const&>()));
+  Payload<T> payload(state.range(0));
+  // deserialize() reads one object from the start of a buffer, so each object
+  // needs its own buffer; cycle through a bounded number of them so that small
+  // objects don't need one heap allocation apiece
+  std::size_t n_buffers = payload.count < 4096 ? payload.count : 4096;
+  std::vector<buffer_t> buffers;
+  buffers.reserve(n_buffers);
+  for(std::size_t i = 0; i < n_buffers; ++i) {
+    buffers.push_back(handler_t::serialize(payload.objects[i]));
+  }
+  UnpackDestination<T> dest(payload.count);
+  for(auto _ : state) {
+    for(std::size_t i = 0; i < payload.count; ++i) {
+      handler_t::template deserialize<T>(buffers[i % n_buffers], dest[i]);
+    }
+    benchmark::ClobberMemory();
+    dest.destroy_all();
+  }
+  set_counters(state, payload);
+}
+
+// </editor-fold> end SimpleSerializationHandler benchmarks }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="PointerReferenceSerializationHandler benchmarks"> {{{1
+
+// Sizing is inherited from the fallback handler, so only packing and
+// unpacking are measured here.
+
+template <typename T>
+void BM_pointer_reference_pack(benchmark::State& state) {
+  using handler_t = darma::serialization::PointerReferenceSerializationHandler<>;
+  Payload<T> payload(state.range(0));
+  std::unique_ptr<char[]> buffer(new char[payload.packed_size]);
+  for(auto _ : state) {
+    char* data = buffer.get();
+    auto ar = handler_t::make_packing_archive(data);
+    for(std::size_t i = 0; i < payload.count; ++i) {
+      ar | payload.objects[i];
+    }
+    benchmark::DoNotOptimize(data);
+    benchmark::ClobberMemory();
+  }
+  set_counters(state, payload);
+}
+
+template <typename T>
+void BM_pointer_reference_unpack(benchmark::State& state) {
+  using handler_t = darma::serialization::PointerReferenceSerializationHandler<>;
+  Payload<T> payload(state.range(0));
+  std::unique_ptr<char[]> buffer(new char[payload.packed_size]);
+  {
+    char* data = buffer.get();
+    auto ar = handler_t::make_packing_archive(data);
+    for(std::size_t i = 0; i < payload.count; ++i) {
+      ar | payload.objects[i];
+    }
+  }
+  UnpackDestination<T> dest(payload.count);
+  for(auto _ : state) {
+    char const* data = buffer.get();
+    auto ar = handler_t::make_unpacking_archive(data);
+    for(std::size_t i = 0; i < payload.count; ++i) {
+      ar.template unpack_next_item_at<T>(dest[i]);
+    }
+    benchmark::ClobberMemory();
+    dest.destroy_all();
+  }
+  set_counters(state, payload);
+}
+
+// </editor-fold> end PointerReferenceSerializationHandler benchmarks }}}1
+//==============================================================================
+
+} // end namespace darma_serialization_benchmarks
+
+// Register the full set of size/pack/unpack benchmarks for a type, over both
+// handlers.  `sweep` is one of the sweep_* functions above.  Must be used
+// somewhere the benchmark function names are visible unqualified.
+#define DARMA_SERIALIZATION_BENCHMARK_ALL(type, sweep) \
+  BENCHMARK_TEMPLATE(BM_simple_size, type)->Apply(sweep); \
+  BENCHMARK_TEMPLATE(BM_simple_serialize, type)->Apply(sweep); \
+  BENCHMARK_TEMPLATE(BM_simple_deserialize, type)->Apply(sweep); \
+  BENCHMARK_TEMPLATE(BM_pointer_reference_pack, type)->Apply(sweep); \
+  BENCHMARK_TEMPLATE(BM_pointer_reference_unpack, type)->Apply(sweep)
+
+// For types that can be packed but not unpacked (e.g., char const*)
+#define DARMA_SERIALIZATION_BENCHMARK_PACK_ONLY(type, sweep) \
+  BENCHMARK_TEMPLATE(BM_simple_size, type)->Apply(sweep); \
+  BENCHMARK_TEMPLATE(BM_simple_serialize, type)->Apply(sweep); \
+  BENCHMARK_TEMPLATE(BM_pointer_reference_pack, type)->Apply(sweep)
+
+#endif //DARMAFRONTEND_BENCHMARK_SERIALIZATION_COMMON_H
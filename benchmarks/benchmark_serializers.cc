@@ -0,0 +1,344 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_serializers.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using namespace darma_serialization_benchmarks;
+
+namespace darma_serialization_benchmarks {
+
+//==============================================================================
+// <editor-fold desc="payload_traits specializations"> {{{1
+
+// Containers and strings: one object as large as the whole payload
+template <typename T>
+struct single_object_payload_traits {
+  static std::size_t count_for(std::size_t) { return 1; }
+  static std::size_t element_bytes_for(std::size_t payload_bytes) {
+    return payload_bytes;
+  }
+};
+
+// Small composites with a dynamic member: many objects of around 64 bytes each
+template <typename T, std::size_t ElementBytes=64>
+struct small_object_payload_traits {
+  static std::size_t count_for(std::size_t payload_bytes) {
+    return payload_bytes < ElementBytes ? 1 : payload_bytes / ElementBytes;
+  }
+  static std::size_t element_bytes_for(std::size_t) { return ElementBytes; }
+};
+
+template <>
+struct payload_traits<std::string>
+  : single_object_payload_traits<std::string> { };
+template <typename T>
+struct payload_traits<std::vector<T>>
+  : single_object_payload_traits<std::vector<T>> { };
+template <typename T>
+struct payload_traits<std::list<T>>
+  : single_object_payload_traits<std::list<T>> { };
+template <typename K, typename V>
+struct payload_traits<std::map<K, V>>
+  : single_object_payload_traits<std::map<K, V>> { };
+template <typename T>
+struct payload_traits<std::set<T>>
+  : single_object_payload_traits<std::set<T>> { };
+template <typename K, typename V>
+struct payload_traits<std::unordered_map<K, V>>
+  : single_object_payload_traits<std::unordered_map<K, V>> { };
+template <typename T>
+struct payload_traits<std::unordered_set<T>>
+  : single_object_payload_traits<std::unordered_set<T>> { };
+template <typename T>
+struct payload_traits<std::unique_ptr<T>>
+  : single_object_payload_traits<std::unique_ptr<T>> { };
+template <typename T>
+struct payload_traits<std::shared_ptr<T>>
+  : single_object_payload_traits<std::shared_ptr<T>> { };
+
+template <typename T>
+struct payload_traits<std::pair<T, std::string>>
+  : small_object_payload_traits<std::pair<T, std::string>> { };
+template <typename T>
+struct payload_traits<std::tuple<T, std::string>>
+  : small_object_payload_traits<std::tuple<T, std::string>> { };
+template <std::size_t N>
+struct payload_traits<std::string[N]>
+  : small_object_payload_traits<std::string[N], 64*N> { };
+template <>
+struct payload_traits<char const*>
+  : small_object_payload_traits<char const*> { };
+
+// </editor-fold> end payload_traits specializations }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="value generation"> {{{1
+
+// Every dynamically-sized object packs its size as a std::size_t
+constexpr std::size_t size_prefix = sizeof(std::size_t);
+
+inline std::size_t n_elements(std::size_t bytes, std::size_t element_size) {
+  return bytes <= size_prefix ? 0 : (bytes - size_prefix) / element_size;
+}
+
+template <typename T>
+struct _make_value_impl {
+  static_assert(std::is_arithmetic<T>::value, "no payload generator for type");
+  static T make(std::size_t i, std::size_t) { return static_cast<T>(i % 127); }
+};
+
+template <>
+struct _make_value_impl<std::string> {
+  static std::string make(std::size_t i, std::size_t bytes) {
+    return std::string(n_elements(bytes, 1), static_cast<char>('a' + i % 26));
+  }
+};
+
+template <typename T, typename U>
+struct _make_value_impl<std::pair<T, U>> {
+  static std::pair<T, U> make(std::size_t i, std::size_t bytes) {
+    return std::pair<T, U>(
+      make_value<T>(i, sizeof(T)),
+      make_value<U>(i, bytes > sizeof(T) ? bytes - sizeof(T) : 0)
+    );
+  }
+};
+
+template <typename... Ts>
+struct _make_value_impl<std::tuple<Ts...>> {
+  // Everything but the last element is fixed-size; the last gets the rest
+  static std::tuple<Ts...> make(std::size_t i, std::size_t bytes) {
+    return _make(i, bytes, std::index_sequence_for<Ts...>{});
+  }
+  template <std::size_t... Idxs>
+  static std::tuple<Ts...>
+  _make(std::size_t i, std::size_t bytes, std::index_sequence<Idxs...>) {
+    constexpr std::size_t last = sizeof...(Ts) - 1;
+    std::size_t fixed = 0;
+    for(auto s : { (Idxs == last ? std::size_t(0) : sizeof(Ts))... }) fixed += s;
+    return std::tuple<Ts...>(
+      make_value<std::remove_const_t<Ts>>(
+        i, Idxs == last ? (bytes > fixed ? bytes - fixed : 0) : sizeof(Ts)
+      )...
+    );
+  }
+};
+
+template <typename T>
+struct _make_value_impl<std::vector<T>> {
+  static std::vector<T> make(std::size_t, std::size_t bytes) {
+    auto element_bytes = payload_traits<T>::element_bytes_for(64);
+    auto n = n_elements(bytes, element_bytes);
+    std::vector<T> rv;
+    rv.reserve(n);
+    for(std::size_t j = 0; j < n; ++j) {
+      rv.push_back(make_value<T>(j, element_bytes));
+    }
+    return rv;
+  }
+};
+
+template <typename T>
+struct _make_value_impl<std::list<T>> {
+  static std::list<T> make(std::size_t, std::size_t bytes) {
+    std::list<T> rv;
+    for(std::size_t j = 0, n = n_elements(bytes, sizeof(T)); j < n; ++j) {
+      rv.push_back(make_value<T>(j, sizeof(T)));
+    }
+    return rv;
+  }
+};
+
+template <typename K, typename V>
+struct _make_value_impl<std::map<K, V>> {
+  static std::map<K, V> make(std::size_t, std::size_t bytes) {
+    std::map<K, V> rv;
+    for(std::size_t j = 0, n = n_elements(bytes, sizeof(K) + sizeof(V)); j < n; ++j) {
+      rv.emplace_hint(rv.end(), static_cast<K>(j), make_value<V>(j, sizeof(V)));
+    }
+    return rv;
+  }
+};
+
+template <typename T>
+struct _make_value_impl<std::set<T>> {
+  static std::set<T> make(std::size_t, std::size_t bytes) {
+    std::set<T> rv;
+    for(std::size_t j = 0, n = n_elements(bytes, sizeof(T)); j < n; ++j) {
+      rv.emplace_hint(rv.end(), static_cast<T>(j));
+    }
+    return rv;
+  }
+};
+
+template <typename K, typename V>
+struct _make_value_impl<std::unordered_map<K, V>> {
+  static std::unordered_map<K, V> make(std::size_t, std::size_t bytes) {
+    // The bucket count and max load factor go on the wire too
+    auto n = n_elements(bytes, sizeof(K) + sizeof(V));
+    std::unordered_map<K, V> rv(n);
+    for(std::size_t j = 0; j < n; ++j) {
+      rv.emplace(static_cast<K>(j), make_value<V>(j, sizeof(V)));
+    }
+    return rv;
+  }
+};
+
+template <typename T>
+struct _make_value_impl<std::unordered_set<T>> {
+  static std::unordered_set<T> make(std::size_t, std::size_t bytes) {
+    auto n = n_elements(bytes, sizeof(T));
+    std::unordered_set<T> rv(n);
+    for(std::size_t j = 0; j < n; ++j) {
+      rv.emplace(static_cast<T>(j));
+    }
+    return rv;
+  }
+};
+
+// Owning pointers pack a tag (or flag) before the object they point to
+template <typename T>
+struct _make_value_impl<std::unique_ptr<T>> {
+  static std::unique_ptr<T> make(std::size_t i, std::size_t bytes) {
+    return std::unique_ptr<T>(
+      new T(make_value<T>(i, bytes > size_prefix ? bytes - size_prefix : 0))
+    );
+  }
+};
+
+template <typename T>
+struct _make_value_impl<std::shared_ptr<T>> {
+  static std::shared_ptr<T> make(std::size_t i, std::size_t bytes) {
+    return std::make_shared<T>(
+      make_value<T>(i, bytes > size_prefix ? bytes - size_prefix : 0)
+    );
+  }
+};
+
+template <typename T>
+struct _make_value_impl<std::vector<std::shared_ptr<T>>> {
+  // Each object is shared by this many consecutive elements, so that most of
+  // them are packed as references back to the first
+  static constexpr std::size_t pointers_per_object = 8;
+  static std::vector<std::shared_ptr<T>> make(std::size_t, std::size_t bytes) {
+    auto object_bytes = payload_traits<T>::element_bytes_for(64);
+    auto n_objects = n_elements(bytes, object_bytes + pointers_per_object * size_prefix);
+    std::vector<std::shared_ptr<T>> rv;
+    rv.reserve(n_objects * pointers_per_object);
+    for(std::size_t j = 0; j < n_objects; ++j) {
+      auto obj = std::make_shared<T>(make_value<T>(j, object_bytes));
+      for(std::size_t k = 0; k < pointers_per_object; ++k) rv.push_back(obj);
+    }
+    return rv;
+  }
+};
+
+template <>
+struct _make_value_impl<char const*> {
+  // The strings have to outlive the payload, so keep one per size around
+  static char const* make(std::size_t, std::size_t bytes) {
+    static std::unordered_map<std::size_t, std::string> strings;
+    auto& str = strings[bytes];
+    if(str.empty()) str = make_value<std::string>(0, bytes);
+    return str.c_str();
+  }
+};
+
+// </editor-fold> end value generation }}}1
+//==============================================================================
+
+} // end namespace darma_serialization_benchmarks
+
+// Fixed-size and directly serializable types
+DARMA_SERIALIZATION_BENCHMARK_ALL(double, sweep_payload);
+DARMA_SERIALIZATION_BENCHMARK_ALL(double[64], sweep_payload);
+typedef std::pair<int, double> pair_int_double;
+DARMA_SERIALIZATION_BENCHMARK_ALL(pair_int_double, sweep_payload);
+typedef std::tuple<int, double, char> tuple_int_double_char;
+DARMA_SERIALIZATION_BENCHMARK_ALL(tuple_int_double_char, sweep_payload);
+
+// Small objects with a dynamically-sized member
+typedef std::pair<int, std::string> pair_int_string;
+DARMA_SERIALIZATION_BENCHMARK_ALL(pair_int_string, sweep_payload);
+typedef std::tuple<int const, std::string> tuple_const_int_string;
+DARMA_SERIALIZATION_BENCHMARK_ALL(tuple_const_int_string, sweep_payload);
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::string[4], sweep_payload);
+DARMA_SERIALIZATION_BENCHMARK_PACK_ONLY(char const*, sweep_payload);
+
+// Contiguous containers
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::string, sweep_payload);
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::vector<double>, sweep_payload);
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::vector<std::string>, sweep_node_payload);
+
+// Node-based containers
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::list<double>, sweep_node_payload);
+typedef std::map<int, int> map_int_int;
+DARMA_SERIALIZATION_BENCHMARK_ALL(map_int_int, sweep_node_payload);
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::set<int>, sweep_node_payload);
+typedef std::unordered_map<int, int> unordered_map_int_int;
+DARMA_SERIALIZATION_BENCHMARK_ALL(unordered_map_int_int, sweep_node_payload);
+DARMA_SERIALIZATION_BENCHMARK_ALL(std::unordered_set<int>, sweep_node_payload);
+
+// Owning pointers
+typedef std::unique_ptr<std::vector<double>> unique_ptr_vector_double;
+DARMA_SERIALIZATION_BENCHMARK_ALL(unique_ptr_vector_double, sweep_payload);
+typedef std::shared_ptr<std::vector<double>> shared_ptr_vector_double;
+DARMA_SERIALIZATION_BENCHMARK_ALL(shared_ptr_vector_double, sweep_payload);
+// Mostly references back to shared objects packed earlier in the vector
+typedef std::vector<std::shared_ptr<std::vector<double>>> vector_shared_ptr_vector_double;
+DARMA_SERIALIZATION_BENCHMARK_ALL(vector_shared_ptr_vector_double, sweep_node_payload);
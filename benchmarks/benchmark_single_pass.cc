@@ -0,0 +1,120 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_single_pass.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+using nested_t = std::map<std::string, std::vector<std::string>>;
+
+// Roughly `payload_bytes` of packed data spread over many short strings, which
+// is the case where the sizing pass is most expensive relative to packing
+nested_t make_nested(std::size_t payload_bytes) {
+  nested_t rv;
+  std::size_t packed = sizeof(std::size_t);
+  for(std::size_t i = 0; packed < payload_bytes; ++i) {
+    auto& values = rv[std::to_string(i)];
+    packed += 3 * sizeof(std::size_t) + std::to_string(i).size();
+    for(std::size_t j = 0; j < 8; ++j) {
+      values.emplace_back(8 + (i + j) % 24, static_cast<char>('a' + j));
+      packed += sizeof(std::size_t) + values.back().size();
+    }
+  }
+  return rv;
+}
+
+template <typename T>
+T make_payload(std::size_t payload_bytes);
+
+template <>
+nested_t make_payload<nested_t>(std::size_t payload_bytes) {
+  return make_nested(payload_bytes);
+}
+
+template <>
+std::vector<double> make_payload<std::vector<double>>(std::size_t payload_bytes) {
+  return std::vector<double>(payload_bytes / sizeof(double), 3.14);
+}
+
+template <typename T>
+void BM_two_pass_serialize(benchmark::State& state) {
+  auto input = make_payload<T>(state.range(0));
+  std::size_t size = 0;
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize(input);
+    benchmark::DoNotOptimize(buffer.data());
+    size = buffer.capacity();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+template <typename T>
+void BM_single_pass_serialize(benchmark::State& state) {
+  auto input = make_payload<T>(state.range(0));
+  std::size_t size = 0;
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize_single_pass(input);
+    benchmark::DoNotOptimize(buffer.data());
+    size = buffer.size();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * size);
+}
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_node_payload;
+using darma_serialization_benchmarks::sweep_payload;
+
+BENCHMARK_TEMPLATE(BM_two_pass_serialize, nested_t)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_single_pass_serialize, nested_t)->Apply(sweep_node_payload);
+BENCHMARK_TEMPLATE(BM_two_pass_serialize, std::vector<double>)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_single_pass_serialize, std::vector<double>)->Apply(sweep_payload);
@@ -0,0 +1,137 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_streaming.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+#include <darma/serialization/streaming_handler.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+// The sink copies each chunk into one reused region, standing in for a write
+// to a file or socket, so that both versions copy the data the same number
+// of times
+void BM_contiguous_serialize(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  std::vector<char> destination(input.size() * sizeof(double) + sizeof(std::size_t));
+  for(auto _ : state) {
+    auto buffer = SimpleSerializationHandler<>::serialize(input);
+    std::memcpy(destination.data(), buffer.data(), buffer.capacity());
+    benchmark::DoNotOptimize(destination.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * destination.size());
+}
+
+template <std::size_t NChunks>
+void BM_streaming_serialize(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  std::vector<char> destination(input.size() * sizeof(double) + sizeof(std::size_t));
+  for(auto _ : state) {
+    char* spot = destination.data();
+    auto ar = StreamingSerializationHandler<>::make_streaming_packing_archive(
+      [&](char const* data, std::size_t size) {
+        std::memcpy(spot, data, size);
+        spot += size;
+      },
+      DARMA_SERIALIZATION_STREAMING_CHUNK_SIZE, NChunks
+    );
+    ar | input;
+    StreamingSerializationHandler<>::finish_streaming(std::move(ar));
+    benchmark::DoNotOptimize(destination.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * destination.size());
+  // Buffering used, regardless of the payload size
+  state.counters["buffered_bytes"] = DARMA_SERIALIZATION_STREAMING_CHUNK_SIZE * NChunks;
+}
+
+// Reading the whole message into memory and then unpacking it, versus
+// unpacking while reading it in 1 MiB pieces (each "read" is a memcpy from
+// the packed bytes)
+void BM_contiguous_deserialize(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  auto packed = SimpleSerializationHandler<>::serialize(input);
+  for(auto _ : state) {
+    std::vector<char> read_buffer(packed.capacity());
+    std::memcpy(read_buffer.data(), packed.data(), packed.capacity());
+    auto output = SimpleSerializationHandler<>::deserialize<std::vector<double>>(read_buffer);
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * packed.capacity());
+}
+
+void BM_streaming_deserialize(benchmark::State& state) {
+  std::vector<double> input(state.range(0) / sizeof(double), 3.14);
+  auto packed = SimpleSerializationHandler<>::serialize(input);
+  for(auto _ : state) {
+    std::size_t offset = 0;
+    auto output = StreamingSerializationHandler<>::deserialize_streaming<std::vector<double>>(
+      [&](char* dest, std::size_t size) {
+        auto n = std::min({ size, std::size_t(1 << 20), packed.capacity() - offset });
+        std::memcpy(dest, packed.data() + offset, n);
+        offset += n;
+        return n;
+      }
+    );
+    benchmark::DoNotOptimize(output.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * packed.capacity());
+}
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_payload;
+
+BENCHMARK(BM_contiguous_serialize)->Apply(sweep_payload);
+// Flushed on the packing thread
+BENCHMARK_TEMPLATE(BM_streaming_serialize, 1)->Apply(sweep_payload);
+// Flushed on a background thread
+BENCHMARK_TEMPLATE(BM_streaming_serialize, 4)->Apply(sweep_payload);
+BENCHMARK(BM_contiguous_deserialize)->Apply(sweep_payload);
+BENCHMARK(BM_streaming_deserialize)->Apply(sweep_payload);
@@ -0,0 +1,124 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_varint.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+// Many short strings and small vectors, where the size prefixes are a large
+// fraction of the message
+std::vector<std::string> make_short_strings(std::size_t n) {
+  std::vector<std::string> rv;
+  rv.reserve(n);
+  for(std::size_t i = 0; i < n; ++i) {
+    rv.emplace_back(4 + i % 12, static_cast<char>('a' + i % 26));
+  }
+  return rv;
+}
+
+std::map<int, std::vector<int>> make_small_vectors(std::size_t n) {
+  std::map<int, std::vector<int>> rv;
+  for(std::size_t i = 0; i < n; ++i) {
+    rv[static_cast<int>(i)] = std::vector<int>(i % 5, static_cast<int>(i));
+  }
+  return rv;
+}
+
+template <typename Handler, typename T>
+void _round_trip(benchmark::State& state, T const& input) {
+  std::size_t size = 0;
+  for(auto _ : state) {
+    auto buffer = Handler::serialize(input);
+    auto output = Handler::template deserialize<T>(buffer);
+    benchmark::DoNotOptimize(output);
+    size = buffer.capacity();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+  state.counters["bytes"] = static_cast<double>(size);
+}
+
+template <typename Handler>
+void BM_short_strings(benchmark::State& state) {
+  _round_trip<Handler>(state, make_short_strings(state.range(0)));
+}
+
+template <typename Handler>
+void BM_small_vectors(benchmark::State& state) {
+  _round_trip<Handler>(state, make_small_vectors(state.range(0)));
+}
+
+// Integers packed one at a time (a std::vector<long> would be copied raw):
+// the cost of encoding and decoding each one, versus a fixed-width copy
+template <typename Handler>
+void BM_integer_fields(benchmark::State& state) {
+  std::list<long> input;
+  for(long i = 0; i < state.range(0); ++i) {
+    input.push_back((i % 2 == 0 ? 1 : -1) * (i % 1000));
+  }
+  _round_trip<Handler>(state, input);
+}
+
+// Element counts rather than bytes
+void sweep_count(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(8)->Range(8, 1 << 18);
+}
+
+} // end anonymous namespace
+
+BENCHMARK_TEMPLATE(BM_short_strings, SimpleSerializationHandler<>)->Apply(sweep_count);
+BENCHMARK_TEMPLATE(BM_short_strings, VarintSerializationHandler<>)->Apply(sweep_count);
+BENCHMARK_TEMPLATE(BM_small_vectors, SimpleSerializationHandler<>)->Apply(sweep_count);
+BENCHMARK_TEMPLATE(BM_small_vectors, VarintSerializationHandler<>)->Apply(sweep_count);
+BENCHMARK_TEMPLATE(BM_integer_fields, SimpleSerializationHandler<>)->Apply(sweep_count);
+BENCHMARK_TEMPLATE(BM_integer_fields, VarintSerializationHandler<>)->Apply(sweep_count);
+BENCHMARK_TEMPLATE(BM_integer_fields, VarintSerializationHandler<VarintIntegers>)->Apply(sweep_count);
@@ -0,0 +1,112 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_vector_unpack.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+// The element-at-a-time unpack that std::vector used before unpacking in
+// place, kept here as a reference point
+template <typename T, typename Archive>
+void emplace_back_unpack(void* allocated, Archive& ar) {
+  auto size = ar.template unpack_next_item_as<typename std::vector<T>::size_type>();
+  auto& obj = *(new (allocated) std::vector<T>());
+  obj.reserve(size);
+  for(typename std::vector<T>::size_type i = 0; i < size; ++i) {
+    obj.emplace_back(ar.template unpack_next_item_as<T>());
+  }
+}
+
+std::vector<std::string> make_strings(std::size_t n, std::size_t length) {
+  std::vector<std::string> rv;
+  rv.reserve(n);
+  for(std::size_t i = 0; i < n; ++i) {
+    rv.emplace_back(length, static_cast<char>('a' + i % 26));
+  }
+  return rv;
+}
+
+template <bool InPlace>
+void BM_unpack_vector_of_strings(benchmark::State& state) {
+  using handler_t = SimpleSerializationHandler<>;
+  auto input = make_strings(state.range(0), state.range(1));
+  auto buffer = handler_t::serialize(input);
+  std::aligned_storage_t<sizeof(std::vector<std::string>)> storage;
+  for(auto _ : state) {
+    auto ar = handler_t::make_unpacking_archive(buffer);
+    if(InPlace) {
+      ar.unpack_next_item_at<std::vector<std::string>>(&storage);
+    }
+    else {
+      emplace_back_unpack<std::string>(&storage, ar);
+    }
+    auto* output = reinterpret_cast<std::vector<std::string>*>(&storage);
+    benchmark::DoNotOptimize(output->data());
+    output->~vector();
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.capacity());
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * input.size());
+}
+
+// Short strings fit in the small string buffer, so this is all construction;
+// long strings show how much of that is left once malloc is involved
+void string_counts_and_lengths(benchmark::internal::Benchmark* b) {
+  for(long length : {8, 64}) {
+    for(long n = 1 << 10; n <= 1 << 22; n *= 16) {
+      b->Args({n, length});
+    }
+  }
+}
+
+} // end anonymous namespace
+
+BENCHMARK_TEMPLATE(BM_unpack_vector_of_strings, false)->Apply(string_counts_and_lengths);
+BENCHMARK_TEMPLATE(BM_unpack_vector_of_strings, true)->Apply(string_counts_and_lengths);
@@ -0,0 +1,105 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      benchmark_views.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include "benchmark_serialization_common.h"
+
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+
+namespace {
+
+template <typename T>
+T make_payload(std::size_t payload_bytes);
+
+template <>
+std::vector<double> make_payload<std::vector<double>>(std::size_t payload_bytes) {
+  return std::vector<double>(payload_bytes / sizeof(double), 3.14);
+}
+
+template <>
+std::string make_payload<std::string>(std::size_t payload_bytes) {
+  return std::string(payload_bytes, 'x');
+}
+
+// Both read the first and last elements, so that neither can skip the data
+// entirely but the cost of actually traversing it isn't what gets measured
+
+template <typename T>
+void BM_deserialize_copy(benchmark::State& state) {
+  auto buffer = SimpleSerializationHandler<>::serialize(make_payload<T>(state.range(0)));
+  for(auto _ : state) {
+    auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+    if(not output.empty()) {
+      benchmark::DoNotOptimize(output.front());
+      benchmark::DoNotOptimize(output.back());
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.capacity());
+}
+
+template <typename T>
+void BM_deserialize_view(benchmark::State& state) {
+  auto buffer = SimpleSerializationHandler<>::serialize(make_payload<T>(state.range(0)));
+  for(auto _ : state) {
+    auto output = SimpleSerializationHandler<>::deserialize_view<T>(buffer);
+    if(not output.empty()) {
+      benchmark::DoNotOptimize(*output.begin());
+      benchmark::DoNotOptimize(*(output.end() - 1));
+    }
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * buffer.capacity());
+}
+
+} // end anonymous namespace
+
+using darma_serialization_benchmarks::sweep_payload;
+
+BENCHMARK_TEMPLATE(BM_deserialize_copy, std::vector<double>)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_deserialize_view, std::vector<double>)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_deserialize_copy, std::string)->Apply(sweep_payload);
+BENCHMARK_TEMPLATE(BM_deserialize_view, std::string)->Apply(sweep_payload);
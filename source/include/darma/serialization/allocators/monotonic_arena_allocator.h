@@ -0,0 +1,262 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      monotonic_arena_allocator.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_ALLOCATORS_MONOTONIC_ARENA_ALLOCATOR_H
+#define DARMAFRONTEND_SERIALIZATION_ALLOCATORS_MONOTONIC_ARENA_ALLOCATOR_H
+
+#include <darma/serialization/fatal_error.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifndef DARMA_SERIALIZATION_MONOTONIC_ARENA_INITIAL_BLOCK_SIZE
+#  define DARMA_SERIALIZATION_MONOTONIC_ARENA_INITIAL_BLOCK_SIZE 4096
+#endif
+
+namespace darma {
+namespace serialization {
+
+/// A region of memory that hands out allocations by bumping a pointer.
+/// Deallocation is a no-op; everything allocated from the arena is freed at
+/// once when it is released or destroyed.  Intended for things like a
+/// per-message arena that everything in a deserialized message is allocated
+/// from.  Not thread-safe.
+class MonotonicArena {
+  public:
+
+    explicit
+    MonotonicArena(
+      std::size_t initial_block_size = DARMA_SERIALIZATION_MONOTONIC_ARENA_INITIAL_BLOCK_SIZE
+    ) : first_block_size_(initial_block_size > 0 ? initial_block_size : 1),
+        next_block_size_(first_block_size_)
+    { }
+
+    /// Use the given buffer first, before allocating any blocks.  The arena
+    /// does not take ownership of the buffer.
+    MonotonicArena(
+      void* initial_buffer, std::size_t initial_buffer_size,
+      std::size_t next_block_size = DARMA_SERIALIZATION_MONOTONIC_ARENA_INITIAL_BLOCK_SIZE
+    ) : current_(static_cast<char*>(initial_buffer)),
+        end_(static_cast<char*>(initial_buffer) + initial_buffer_size),
+        initial_buffer_(static_cast<char*>(initial_buffer)),
+        initial_buffer_size_(initial_buffer_size),
+        first_block_size_(next_block_size > 0 ? next_block_size : 1),
+        next_block_size_(first_block_size_)
+    { }
+
+    // Allocators refer to the arena by address, so it can't be moved or copied
+    MonotonicArena(MonotonicArena const&) = delete;
+    MonotonicArena& operator=(MonotonicArena const&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment) {
+      auto* rv = _align_up(current_, alignment);
+      if(rv == nullptr or rv > end_ or static_cast<std::size_t>(end_ - rv) < size) {
+        return _allocate_from_new_block(size, alignment);
+      }
+      current_ = rv + size;
+      bytes_allocated_ += size;
+      return rv;
+    }
+
+    void deallocate(void*, std::size_t) noexcept { /* no-op until release() */ }
+
+    /// Free everything allocated from the arena, all at once.  Memory obtained
+    /// from the arena before this call must not be used after it.
+    void release() noexcept {
+      while(blocks_ != nullptr) {
+        auto* next = blocks_->next;
+        ::operator delete(static_cast<void*>(blocks_));
+        blocks_ = next;
+      }
+      current_ = initial_buffer_;
+      end_ = initial_buffer_ + initial_buffer_size_;
+      // Otherwise, an arena that is reused by releasing it would allocate
+      // bigger and bigger blocks indefinitely
+      next_block_size_ = first_block_size_;
+      bytes_allocated_ = 0;
+    }
+
+    /// The number of bytes handed out since construction or the last release()
+    std::size_t bytes_allocated() const { return bytes_allocated_; }
+
+    ~MonotonicArena() { release(); }
+
+  private:
+
+    template <typename>
+    friend class MonotonicArenaAllocator;
+
+    struct _block_header {
+      _block_header* next;
+    };
+
+    static char* _align_up(char* ptr, std::size_t alignment) {
+      if(ptr == nullptr) return nullptr;
+      auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+      auto aligned = (addr + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+      return ptr + (aligned - addr);
+    }
+
+    [[noreturn]] static void _block_too_large() {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      throw std::bad_alloc();
+#else
+      detail::_fatal_error("allocation from a MonotonicArena is too large");
+#endif
+    }
+
+    void* _allocate_from_new_block(std::size_t size, std::size_t alignment) {
+      // No block that big could be allocated anyway, and ruling it out here
+      // keeps the doubling below from overflowing
+      constexpr auto max_block_size = std::numeric_limits<std::size_t>::max() / 2;
+      if(size > max_block_size - sizeof(_block_header) - alignment) {
+        _block_too_large();
+      }
+      // Blocks grow geometrically so that the number of blocks stays
+      // logarithmic in the total size allocated
+      auto needed = sizeof(_block_header) + size + alignment;
+      auto block_size = std::min(next_block_size_, max_block_size);
+      while(block_size < needed) block_size *= 2;
+      next_block_size_ = block_size <= max_block_size ? block_size * 2 : block_size;
+
+      auto* block = static_cast<_block_header*>(::operator new(block_size));
+      block->next = blocks_;
+      blocks_ = block;
+
+      current_ = reinterpret_cast<char*>(block) + sizeof(_block_header);
+      end_ = reinterpret_cast<char*>(block) + block_size;
+      auto* rv = _align_up(current_, alignment);
+      current_ = rv + size;
+      bytes_allocated_ += size;
+      return rv;
+    }
+
+    char* current_ = nullptr;
+    char* end_ = nullptr;
+    _block_header* blocks_ = nullptr;
+    char* initial_buffer_ = nullptr;
+    std::size_t initial_buffer_size_ = 0;
+    std::size_t first_block_size_;
+    std::size_t next_block_size_;
+    std::size_t bytes_allocated_ = 0;
+};
+
+/// A standard library compatible allocator that allocates from a
+/// MonotonicArena.  Give it to SimpleSerializationHandler::deserialize() to
+/// have every std::string, std::vector, std::map, etc., in the unpacked object
+/// that uses a MonotonicArenaAllocator allocated from the same arena, e.g.:
+///
+///   using alloc_t = MonotonicArenaAllocator<char>;
+///   using string_t = std::basic_string<char, std::char_traits<char>, alloc_t>;
+///   MonotonicArena arena;
+///   auto value = SimpleSerializationHandler<alloc_t>::deserialize<
+///     std::vector<string_t, MonotonicArenaAllocator<string_t>>
+///   >(buffer, alloc_t(arena));
+///
+/// Containers that use some other allocator fall back to a default-constructed
+/// one (see detail::get_allocator_as()).
+template <typename T>
+class MonotonicArenaAllocator {
+  public:
+
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    explicit
+    MonotonicArenaAllocator(MonotonicArena& arena) noexcept
+      : arena_(&arena)
+    { }
+
+    template <typename U>
+    MonotonicArenaAllocator(MonotonicArenaAllocator<U> const& other) noexcept
+      : arena_(other.arena_)
+    { }
+
+    T* allocate(std::size_t n) {
+      // sizeof(T) * n would wrap around to a small, successful allocation
+      if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+        MonotonicArena::_block_too_large();
+      }
+      return static_cast<T*>(arena_->allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept {
+      // Nothing that big was ever handed out; deallocation is a no-op anyway
+      if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) return;
+      arena_->deallocate(ptr, sizeof(T) * n);
+    }
+
+    MonotonicArena& arena() const { return *arena_; }
+
+    template <typename U>
+    bool operator==(MonotonicArenaAllocator<U> const& other) const {
+      return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(MonotonicArenaAllocator<U> const& other) const {
+      return arena_ != other.arena_;
+    }
+
+  private:
+
+    template <typename>
+    friend class MonotonicArenaAllocator;
+
+    MonotonicArena* arena_;
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_ALLOCATORS_MONOTONIC_ARENA_ALLOCATOR_H
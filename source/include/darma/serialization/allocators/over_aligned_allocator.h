@@ -0,0 +1,118 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      over_aligned_allocator.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_ALLOCATORS_OVER_ALIGNED_ALLOCATOR_H
+#define DARMAFRONTEND_SERIALIZATION_ALLOCATORS_OVER_ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace darma {
+namespace serialization {
+
+/// A stateless allocator that returns memory aligned to (at least) Alignment
+/// bytes, e.g., for serialization buffers whose contents are packed with an
+/// AlignedLayout.  Each allocation is over-allocated from operator new by
+/// Alignment plus a pointer, which is used to remember the original address
+/// (aligned operator new is C++17 only).
+template <typename T, std::size_t Alignment>
+class OverAlignedAllocator {
+  public:
+
+    static_assert((Alignment & (Alignment - 1)) == 0,
+      "OverAlignedAllocator alignment must be a power of two"
+    );
+
+    using value_type = T;
+    using is_always_equal = std::true_type;
+
+    // allocator_traits can't rebind a template with a non-type parameter
+    template <typename U>
+    struct rebind { using other = OverAlignedAllocator<U, Alignment>; };
+
+    static constexpr std::size_t alignment =
+      Alignment > alignof(T)
+        ? (Alignment > alignof(void*) ? Alignment : alignof(void*))
+        : (alignof(T) > alignof(void*) ? alignof(T) : alignof(void*));
+
+    OverAlignedAllocator() noexcept = default;
+
+    template <typename U>
+    OverAlignedAllocator(OverAlignedAllocator<U, Alignment> const&) noexcept { }
+
+    T* allocate(std::size_t n) {
+      constexpr auto overhead = alignment + sizeof(void*);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      if(n > (std::numeric_limits<std::size_t>::max() - overhead) / sizeof(T)) {
+        throw std::bad_alloc();
+      }
+#endif
+      auto* raw = static_cast<char*>(::operator new(n * sizeof(T) + overhead));
+      auto addr = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+      auto* rv = reinterpret_cast<char*>(
+        (addr + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1)
+      );
+      // There's always at least a pointer's worth of space in front of rv
+      reinterpret_cast<void**>(rv)[-1] = raw;
+      return reinterpret_cast<T*>(rv);
+    }
+
+    void deallocate(T* ptr, std::size_t) noexcept {
+      ::operator delete(reinterpret_cast<void**>(ptr)[-1]);
+    }
+
+    template <typename U>
+    bool operator==(OverAlignedAllocator<U, Alignment> const&) const { return true; }
+
+    template <typename U>
+    bool operator!=(OverAlignedAllocator<U, Alignment> const&) const { return false; }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_ALLOCATORS_OVER_ALIGNED_ALLOCATOR_H
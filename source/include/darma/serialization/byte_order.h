@@ -0,0 +1,296 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      byte_order.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_BYTE_ORDER_H
+#define DARMAFRONTEND_SERIALIZATION_BYTE_ORDER_H
+
+#include <darma/serialization/wire_layout.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#  include <immintrin.h>
+#endif
+
+namespace darma {
+namespace serialization {
+
+/// Customization point for converting raw data between byte orders (see
+/// PortableLayout).  Specializations provide
+///
+///   static void copy_swapped(void* dest, void const* src, std::size_t n_items);
+///
+/// which copies n_items Ts from src to dest, reversing the byte order of each
+/// of their scalar parts.  Provided for arithmetic and enum types here, and for
+/// arrays, std::pair and std::tuple next to their serializers.  Directly
+/// serializable types without one can't be packed with a PortableLayout.
+template <typename T, typename Enable=void>
+struct byte_swap_traits;
+
+namespace detail {
+
+constexpr bool host_is_little_endian() {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return false;
+#else
+  return true;
+#endif
+}
+
+//==============================================================================
+// <editor-fold desc="byte swapping kernels"> {{{1
+
+inline std::uint16_t _byte_swap(std::uint16_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap16(v);
+#else
+  return static_cast<std::uint16_t>((v << 8) | (v >> 8));
+#endif
+}
+
+inline std::uint32_t _byte_swap(std::uint32_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap32(v);
+#else
+  return ((v & 0x000000ffu) << 24) | ((v & 0x0000ff00u) << 8)
+    | ((v & 0x00ff0000u) >> 8) | ((v & 0xff000000u) >> 24);
+#endif
+}
+
+inline std::uint64_t _byte_swap(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_bswap64(v);
+#else
+  return (std::uint64_t(_byte_swap(static_cast<std::uint32_t>(v))) << 32)
+    | _byte_swap(static_cast<std::uint32_t>(v >> 32));
+#endif
+}
+
+template <std::size_t Size> struct _unsigned_of_size { };
+template <> struct _unsigned_of_size<2> { using type = std::uint16_t; };
+template <> struct _unsigned_of_size<4> { using type = std::uint32_t; };
+template <> struct _unsigned_of_size<8> { using type = std::uint64_t; };
+
+template <std::size_t Size>
+void _byte_swap_copy_scalar(
+  char* dest, char const* src, std::size_t n_items,
+  std::true_type /* has a bswap instruction */
+) {
+  using word_t = typename _unsigned_of_size<Size>::type;
+  for(std::size_t i = 0; i < n_items; ++i) {
+    word_t word;
+    std::memcpy(&word, src + i * Size, Size);
+    word = _byte_swap(word);
+    std::memcpy(dest + i * Size, &word, Size);
+  }
+}
+
+template <std::size_t Size>
+void _byte_swap_copy_scalar(
+  char* dest, char const* src, std::size_t n_items,
+  std::false_type /* has a bswap instruction */
+) {
+  for(std::size_t i = 0; i < n_items; ++i) {
+    for(std::size_t j = 0; j < Size; ++j) {
+      dest[i * Size + j] = src[i * Size + Size - 1 - j];
+    }
+  }
+}
+
+template <std::size_t Size>
+using _has_vector_byte_swap = std::integral_constant<bool,
+  Size == 2 or Size == 4 or Size == 8
+>;
+
+// The shuffle that reverses each Size-byte item in a 16-byte lane
+template <std::size_t Size>
+void _byte_swap_shuffle_mask(char (&mask)[16]) {
+  for(std::size_t i = 0; i < 16; ++i) {
+    mask[i] = static_cast<char>((i / Size) * Size + (Size - 1 - i % Size));
+  }
+}
+
+// Swaps as many whole vectors' worth of items as it can with byte shuffles
+// and returns how many items that was; the rest are left for the scalar loop
+template <std::size_t Size>
+std::size_t _byte_swap_copy_vector(
+  char* dest, char const* src, std::size_t n_items,
+  std::true_type /* has vector byte swap */
+) {
+  std::size_t done = 0;
+#if defined(__AVX2__) || defined(__SSSE3__)
+  char mask_bytes[16];
+  _byte_swap_shuffle_mask<Size>(mask_bytes);
+  auto const n_bytes = n_items * Size;
+  std::size_t offset = 0;
+  auto const mask128 = _mm_loadu_si128(reinterpret_cast<__m128i const*>(mask_bytes));
+#  if defined(__AVX2__)
+  auto const mask256 = _mm256_broadcastsi128_si256(mask128);
+  for(; offset + 64 <= n_bytes; offset += 64) {
+    auto a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + offset));
+    auto b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(src + offset + 32));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + offset), _mm256_shuffle_epi8(a, mask256));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + offset + 32), _mm256_shuffle_epi8(b, mask256));
+  }
+#  endif
+  for(; offset + 16 <= n_bytes; offset += 16) {
+    auto a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + offset));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm_shuffle_epi8(a, mask128));
+  }
+  done = offset / Size;
+#else
+  (void)dest; (void)src; (void)n_items;
+#endif
+  return done;
+}
+
+template <std::size_t Size>
+std::size_t _byte_swap_copy_vector(
+  char*, char const*, std::size_t, std::false_type /* has vector byte swap */
+) {
+  return 0;
+}
+
+/// Copy n_items items of Size bytes each from src to dest, reversing the
+/// bytes of each.  Uses byte shuffles (with SSSE3 or AVX2) for the bulk of
+/// large arrays and bswap instructions for the rest.  src and dest must not
+/// overlap.
+template <std::size_t Size>
+void byte_swap_copy(void* dest, void const* src, std::size_t n_items) {
+  auto* d = static_cast<char*>(dest);
+  auto const* s = static_cast<char const*>(src);
+  if(Size == 1) {
+    std::memcpy(d, s, n_items);
+    return;
+  }
+  auto done = _byte_swap_copy_vector<Size>(d, s, n_items, _has_vector_byte_swap<Size>{});
+  _byte_swap_copy_scalar<Size>(d + done * Size, s + done * Size, n_items - done,
+    _has_vector_byte_swap<Size>{}
+  );
+}
+
+// </editor-fold> end byte swapping kernels }}}1
+//==============================================================================
+
+template <typename T>
+using _copy_swapped_archetype = decltype(
+  byte_swap_traits<T>::copy_swapped(
+    std::declval<void*>(), std::declval<void const*>(), std::size_t{}
+  )
+);
+
+/// Whether T has a byte_swap_traits specialization
+template <typename T>
+using is_byte_swappable = tinympl::is_detected<_copy_swapped_archetype, T>;
+
+template <typename ByteOrder>
+struct _byte_order_differs_from_host
+  : std::integral_constant<bool,
+      ByteOrder::is_little_endian != host_is_little_endian()
+    >
+{ };
+
+template <>
+struct _byte_order_differs_from_host<NativeByteOrder> : std::false_type { };
+
+template <typename T>
+void _copy_raw_data(
+  void* dest, void const* src, std::size_t n_items, std::false_type /* swap */
+) {
+  // empty containers may hand us null pointers, which memcpy doesn't allow
+  if(n_items == 0) return;
+  std::memcpy(dest, src, n_items * sizeof(T));
+}
+
+template <typename T>
+void _copy_raw_data(
+  void* dest, void const* src, std::size_t n_items, std::true_type /* swap */
+) {
+  byte_swap_traits<T>::copy_swapped(dest, src, n_items);
+}
+
+/// Whether raw data of type T has to be byte swapped to or from ByteOrder
+template <typename ByteOrder, typename T>
+using swaps_bytes = std::integral_constant<bool,
+  (sizeof(T) > 1) and _byte_order_differs_from_host<ByteOrder>::value
+>;
+
+/// Copy n_items Ts between the host's byte order and ByteOrder (either way,
+/// since a byte swap is its own inverse).  This is just a memcpy unless the
+/// byte orders differ.
+template <typename ByteOrder, typename T>
+void copy_raw_data(void* dest, void const* src, std::size_t n_items) {
+  static_assert(
+    std::is_same<ByteOrder, NativeByteOrder>::value or sizeof(T) == 1
+      or is_byte_swappable<T>::value,
+    "raw data packed with a portable byte order must have a byte_swap_traits"
+    " specialization (e.g., it must be made of arithmetic types)"
+  );
+  _copy_raw_data<T>(dest, src, n_items, swaps_bytes<ByteOrder, T>{});
+}
+
+} // end namespace detail
+
+template <typename T>
+struct byte_swap_traits<T,
+  std::enable_if_t<
+    (std::is_arithmetic<T>::value or std::is_enum<T>::value)
+      // The representation of long double isn't portable anyway
+      and not std::is_same<std::remove_cv_t<T>, long double>::value
+  >
+> {
+  static void copy_swapped(void* dest, void const* src, std::size_t n_items) {
+    detail::byte_swap_copy<sizeof(T)>(dest, src, n_items);
+  }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_BYTE_ORDER_H
@@ -0,0 +1,389 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      checked_archive.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_CHECKED_ARCHIVE_H
+#define DARMAFRONTEND_SERIALIZATION_CHECKED_ARCHIVE_H
+
+#include <darma/serialization/byte_order.h>
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/object_identity.h>
+#include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/simple_archive.h>
+#include <darma/serialization/simple_handler_fwd.h>
+#include <darma/serialization/varint.h>
+#include <darma/serialization/wire_layout.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <stdexcept>
+#endif
+
+namespace darma {
+namespace serialization {
+
+//==============================================================================
+// <editor-fold desc="unpacking error codes"> {{{1
+
+/// Errors a CheckedUnpackingArchive reports, as std::error_codes in
+/// unpacking_category()
+enum class unpacking_errc {
+  /// The buffer ended before everything in it was unpacked (e.g., a truncated
+  /// message, or a corrupt size prefix)
+  buffer_overrun = 1,
+  /// A shared pointer refers back to an object that wasn't unpacked before it
+  /// (or was unpacked as a different type, or is still being unpacked)
+  invalid_object_reference = 2,
+  /// A varint (see VarintLayout) is longer than ten bytes, or doesn't fit in
+  /// 64 bits
+  malformed_varint = 3
+};
+
+namespace detail {
+
+class UnpackingErrorCategory : public std::error_category {
+  public:
+
+    char const* name() const noexcept override {
+      return "darma serialization unpacking";
+    }
+
+    std::string message(int ev) const override {
+      switch(static_cast<unpacking_errc>(ev)) {
+        case unpacking_errc::buffer_overrun:
+          return "serialized data ended before unpacking finished";
+        case unpacking_errc::invalid_object_reference:
+          return "serialized data refers back to an object it doesn't contain";
+        case unpacking_errc::malformed_varint:
+          return "serialized data contains a malformed varint";
+      }
+      return "unknown unpacking error";
+    }
+};
+
+} // end namespace detail
+
+inline std::error_category const& unpacking_category() noexcept {
+  static detail::UnpackingErrorCategory const category;
+  return category;
+}
+
+inline std::error_code make_error_code(unpacking_errc e) noexcept {
+  return std::error_code(static_cast<int>(e), unpacking_category());
+}
+
+// </editor-fold> end unpacking error codes }}}1
+//==============================================================================
+
+} // end namespace serialization
+} // end namespace darma
+
+namespace std {
+
+template <>
+struct is_error_code_enum<darma::serialization::unpacking_errc> : true_type { };
+
+} // end namespace std
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+template <typename BufferT>
+using _buffer_size_archetype = decltype(std::declval<BufferT const&>().size());
+
+// The bytes of buffer that hold packed data.  Buffers that track how much of
+// them is in use (e.g., GrowableSerializationBuffer, or a std::string) can
+// have more capacity() than that, and the rest isn't initialized.
+template <typename BufferT>
+std::size_t _packed_bytes_in(BufferT const& buffer, std::true_type /* has size() */) {
+  return buffer.size();
+}
+
+template <typename BufferT>
+std::size_t _packed_bytes_in(BufferT const& buffer, std::false_type /* has size() */) {
+  return buffer.capacity();
+}
+
+template <typename BufferT>
+std::size_t _packed_bytes_in(BufferT const& buffer) {
+  return _packed_bytes_in(buffer,
+    typename tinympl::is_detected<_buffer_size_archetype, BufferT>::type{}
+  );
+}
+
+} // end namespace detail
+
+/// A SimpleUnpackingArchive that checks every read against the end of the
+/// buffer, for buffers that can't be trusted to have been packed correctly
+/// (e.g., messages from another process).  Raw data is checked once per
+/// unpack_data_raw() call, so a std::vector<double> costs one comparison no
+/// matter how long it is.  A read past the end of the buffer throws a
+/// std::system_error with unpacking_errc::buffer_overrun; if the archive was
+/// made not to throw (or exceptions are disabled), the error is recorded in
+/// error() instead, and that read and every one after it unpack zeros, so that
+/// whatever was being unpacked is still a valid (if meaningless) object.
+/// Container sizes are checked before anything is allocated for them, assuming
+/// that each element takes at least a byte (so containers of empty types can't
+/// be unpacked from it).  Views and polymorphic objects, which read from the
+/// buffer directly, can't be unpacked from it either.  The buffer has to know
+/// its size, so a ConstNonOwningSerializationBuffer made from just a pointer
+/// is rejected (with a std::invalid_argument, or an abort without
+/// exceptions).
+template <typename Allocator=std::allocator<char>, typename Layout=PackedLayout>
+class CheckedUnpackingArchive
+  : public detail::UnpackingArchiveMixin<
+      CheckedUnpackingArchive<Allocator, Layout>, Allocator
+    >
+{
+  public:
+
+    // Concept "shortcut" tag
+    using is_unpacking_archive_t = std::true_type;
+    using is_archive_t = std::true_type;
+
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+
+  protected:
+
+    darma::utility::compressed_pair<char const*, allocator_type> data_spot_;
+    // Padding is relative to the start of the buffer
+    char const* buffer_begin_;
+    char const* buffer_end_;
+    std::error_code error_;
+    bool throws_;
+    detail::LazyObjectIdentityTable<detail::UnpackingObjectIdentityTable> object_identities_;
+
+    template <typename BufferT>
+    CheckedUnpackingArchive(
+      BufferT const& buffer, allocator_type const& alloc, bool throws
+    ) : data_spot_(
+          std::piecewise_construct,
+          std::forward_as_tuple(buffer.data()),
+          std::forward_as_tuple(alloc)
+        ),
+        buffer_begin_(buffer.data()),
+        buffer_end_(buffer.data()),
+        throws_(throws)
+    {
+      auto const size = detail::_packed_bytes_in(buffer);
+      // The size a ConstNonOwningSerializationBuffer gets without one
+      if(size == std::numeric_limits<std::size_t>::max()) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+        throw std::invalid_argument(
+          "can't check unpacking against a buffer of unknown size"
+        );
+#else
+        detail::_fatal_error("can't check unpacking against a buffer of unknown size");
+#endif
+      }
+      buffer_end_ += size;
+    }
+
+    template <typename, typename>
+    friend struct SimpleSerializationHandler;
+
+    std::size_t _remaining() const {
+      return static_cast<std::size_t>(buffer_end_ - data_spot_.first());
+    }
+
+    // Nothing is left to read after an error, so later reads fail too
+    void _fail(unpacking_errc errc) {
+      data_spot_.first() = buffer_end_;
+      if(not error_) error_ = make_error_code(errc);
+      if(throws_) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+        throw std::system_error(error_);
+#else
+        detail::_fatal_error("unpacking untrusted data failed: " + error_.message());
+#endif
+      }
+    }
+
+    void _overrun() { _fail(unpacking_errc::buffer_overrun); }
+
+    // The padding before n_items of RawDataType, or -1 if they don't fit in the
+    // rest of the buffer (written so that n_items * sizeof(RawDataType) can't
+    // overflow)
+    template <typename RawDataType>
+    std::ptrdiff_t _padding_if_fits(std::size_t n_items) const {
+      auto const padding = Layout::template padding_for<RawDataType>(
+        data_spot_.first() - buffer_begin_, n_items
+      );
+      auto const remaining = _remaining();
+      if(padding <= remaining
+        and n_items <= (remaining - padding) / sizeof(RawDataType)
+      ) {
+        return static_cast<std::ptrdiff_t>(padding);
+      }
+      return -1;
+    }
+
+  private:
+
+    template <typename T>
+    inline auto& _ask_serializer_to_unpack(T& obj) & {
+      auto* buffer = static_cast<void*>(&obj);
+      using rebound_alloc = typename std::allocator_traits<allocator_type>::template rebind_alloc<T>;
+      rebound_alloc alloc{get_allocator()};
+      std::allocator_traits<rebound_alloc>::destroy(alloc, &obj);
+      darma_unpack(allocated_buffer_for<T>(buffer), *this);
+      return *this;
+    }
+
+  public:
+
+    using layout_type = Layout;
+
+    CheckedUnpackingArchive(CheckedUnpackingArchive&&) = default;
+
+    static constexpr bool is_sizing() { return false; }
+    static constexpr bool is_packing() { return false; }
+    static constexpr bool is_unpacking() { return true; }
+
+    template <typename RawDataType>
+    void unpack_data_raw(void* allocated_dest, size_t n_items = 1) {
+      using raw_t = std::remove_const_t<RawDataType>;
+      auto const padding = _padding_if_fits<raw_t>(n_items);
+      if(padding < 0) {
+        _overrun();
+        std::memset(allocated_dest, 0, n_items * sizeof(raw_t));
+        return;
+      }
+      data_spot_.first() += padding;
+      detail::copy_raw_data<layout_byte_order_t<Layout>, raw_t>(
+        allocated_dest, data_spot_.first(), n_items
+      );
+      data_spot_.first() += n_items * sizeof(raw_t);
+    }
+
+    /// n_items if that many RawDataType can be unpacked from the rest of the
+    /// buffer; otherwise the overrun is reported and the answer is 0 (see
+    /// checked_data_raw_count())
+    template <typename RawDataType>
+    std::size_t checked_data_raw_count(std::size_t n_items) {
+      if(_padding_if_fits<std::remove_const_t<RawDataType>>(n_items) < 0) {
+        _overrun();
+        return 0;
+      }
+      return n_items;
+    }
+
+    /// n_items if that many elements, each at least a byte, can be unpacked
+    /// from the rest of the buffer; otherwise the overrun is reported and the
+    /// answer is 0 (see checked_item_count())
+    std::size_t checked_item_count(std::size_t n_items) {
+      if(n_items > _remaining()) {
+        _overrun();
+        return 0;
+      }
+      return n_items;
+    }
+
+    std::uint64_t unpack_varint() {
+      std::uint64_t rv = 0;
+      switch(detail::decode_varint_checked(data_spot_.first(), _remaining(), rv)) {
+        case detail::varint_decode_result::ok:
+          return rv;
+        case detail::varint_decode_result::truncated:
+          _overrun();
+          break;
+        case detail::varint_decode_result::overlong:
+          _fail(unpacking_errc::malformed_varint);
+          break;
+      }
+      return 0;
+    }
+
+    template <typename T>
+    inline auto& operator|(T& obj) & {
+      return _ask_serializer_to_unpack(obj);
+    }
+
+    template <typename T>
+    inline auto& operator>>(T& obj) & {
+      return _ask_serializer_to_unpack(obj);
+    }
+
+    auto const& get_allocator() const {
+      return data_spot_.second();
+    }
+    auto& get_allocator() {
+      return data_spot_.second();
+    }
+
+    template <typename NeededAllocatorT>
+    NeededAllocatorT get_allocator_as() const {
+      return detail::get_allocator_as<NeededAllocatorT>(data_spot_.second());
+    }
+
+    /// The first error unpacking ran into, if any (only ever set without
+    /// throwing if the archive was made not to throw)
+    std::error_code const& error() const { return error_; }
+
+    /// Report a reference back to an object that isn't in object_identities()
+    /// (see Serializer<std::shared_ptr<T>>), like an overrun
+    void report_invalid_object_reference() {
+      _fail(unpacking_errc::invalid_object_reference);
+    }
+
+    /// Bytes of the buffer that haven't been unpacked yet
+    std::size_t bytes_remaining() const { return _remaining(); }
+
+    detail::UnpackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_CHECKED_ARCHIVE_H
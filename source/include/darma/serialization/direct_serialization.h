@@ -45,14 +45,50 @@
 #ifndef DARMAFRONTEND_DIRECT_SERIALIZATION_H
 #define DARMAFRONTEND_DIRECT_SERIALIZATION_H
 
+#include <darma/serialization/integer_encoding.h>
+#include <darma/serialization/raw_data_helpers.h>
 #include <darma/serialization/serialization_traits.h>
 #include <darma/serialization/nonintrusive.h>
 
+#include <cstdint>
+#include <new>
 #include <type_traits>
 
 namespace darma {
 namespace serialization {
 
+namespace detail {
+
+// Integers are varint encoded for layouts with VarintIntegers, except for
+// single bytes, which can't get any smaller
+template <typename T, typename Archive>
+using _is_varint_encoded_integer = std::integral_constant<bool,
+  std::is_integral<T>::value and (sizeof(T) > 1)
+    and archive_integer_encoding_t<Archive>::varint_integers
+>;
+
+template <typename T>
+std::uint64_t _to_varint_value(T value, std::true_type /* signed */) {
+  return zigzag_encode(value);
+}
+
+template <typename T>
+std::uint64_t _to_varint_value(T value, std::false_type /* signed */) {
+  return static_cast<std::uint64_t>(value);
+}
+
+template <typename T>
+T _from_varint_value(std::uint64_t value, std::true_type /* signed */) {
+  return zigzag_decode<T>(value);
+}
+
+template <typename T>
+T _from_varint_value(std::uint64_t value, std::false_type /* signed */) {
+  return static_cast<T>(value);
+}
+
+} // end namespace detail
+
 template <typename T>
 struct Serializer_enabled_if<
   T, std::enable_if_t<is_directly_serializable<T>::value>
@@ -60,18 +96,50 @@ struct Serializer_enabled_if<
 {
   template <typename SizingArchive>
   static void compute_size(T const& obj, SizingArchive& ar) {
-    ar.add_to_size_raw(sizeof(T));
+    _compute_size(obj, ar, detail::_is_varint_encoded_integer<T, SizingArchive>{});
   }
 
   template <typename PackingArchive>
   static void pack(T const& obj, PackingArchive& ar) {
-    ar.pack_data_raw(&obj, &obj + 1);
+    _pack(obj, ar, detail::_is_varint_encoded_integer<T, PackingArchive>{});
   }
 
   template <typename UnpackingArchive>
   static void unpack(void* allocated, UnpackingArchive& ar) {
+    _unpack(allocated, ar, detail::_is_varint_encoded_integer<T, UnpackingArchive>{});
+  }
+
+  template <typename SizingArchive>
+  static void _compute_size(T const& obj, SizingArchive& ar, std::false_type /* varint */) {
+    add_to_size_raw(ar, &obj, &obj + 1);
+  }
+
+  template <typename PackingArchive>
+  static void _pack(T const& obj, PackingArchive& ar, std::false_type /* varint */) {
+    ar.pack_data_raw(&obj, &obj + 1);
+  }
+
+  template <typename UnpackingArchive>
+  static void _unpack(void* allocated, UnpackingArchive& ar, std::false_type /* varint */) {
     ar.template unpack_data_raw<const T>(static_cast<T*>(allocated), 1);
   }
+
+  template <typename SizingArchive>
+  static void _compute_size(T const& obj, SizingArchive& ar, std::true_type /* varint */) {
+    add_varint_to_size(ar, detail::_to_varint_value(obj, std::is_signed<T>{}));
+  }
+
+  template <typename PackingArchive>
+  static void _pack(T const& obj, PackingArchive& ar, std::true_type /* varint */) {
+    pack_varint(ar, detail::_to_varint_value(obj, std::is_signed<T>{}));
+  }
+
+  template <typename UnpackingArchive>
+  static void _unpack(void* allocated, UnpackingArchive& ar, std::true_type /* varint */) {
+    new (allocated) T(
+      detail::_from_varint_value<T>(unpack_varint(ar), std::is_signed<T>{})
+    );
+  }
 };
 
 } // end namespace serialization
@@ -0,0 +1,72 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      fatal_error.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_FATAL_ERROR_H
+#define DARMAFRONTEND_SERIALIZATION_FATAL_ERROR_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace darma {
+namespace serialization {
+namespace detail {
+
+// Where an error can't be thrown (e.g., with DARMA_SERIALIZATION_NO_EXCEPTIONS),
+// it ends the program instead.  The message is printed first, since assert()
+// is compiled out of the release builds that are most likely to hit it.
+[[noreturn]] inline void _fatal_error(char const* what) {
+  std::fprintf(stderr, "darma serialization: %s\n", what);
+  std::abort();
+}
+
+[[noreturn]] inline void _fatal_error(std::string const& what) {
+  _fatal_error(what.c_str());
+}
+
+} // end namespace detail
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_FATAL_ERROR_H
@@ -0,0 +1,416 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      fused.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_FUSED_H
+#define DARMAFRONTEND_SERIALIZATION_FUSED_H
+
+#include <darma/serialization/byte_order.h>
+#include <darma/serialization/direct_serialization.h>
+#include <darma/serialization/raw_data_helpers.h>
+#include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/wire_layout.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace darma {
+namespace serialization {
+
+/// A group of items to be serialized together, in order, as if by
+/// ar | item for each of them, but with each run of adjacent directly
+/// serializable items (e.g., the ints and doubles of a struct) sized with one
+/// add, and packed or unpacked with constant-offset copies and a single move of
+/// the archive's spot (or a single pack_data_raw() / unpack_data_raw() call,
+/// for archives that don't expose their spot), rather than one of each per
+/// item.  The wire format is exactly the same as packing the items one at a
+/// time.  See fused().
+template <typename... Ts>
+class FusedItems {
+  public:
+
+    explicit FusedItems(Ts&... items) : items_(items...) { }
+
+    std::tuple<Ts&...> const& items() const { return items_; }
+
+  private:
+
+    std::tuple<Ts&...> items_;
+};
+
+/// Serialize items as one group (see FusedItems), e.g., in a serialize() method:
+///
+///   template <typename Archive>
+///   void serialize(Archive& ar) { ar | fused(id, rank, x, y, z) | name; }
+///
+/// Items that aren't directly serializable, or that the archive has to treat
+/// one at a time (i.e., with padding, varint encoding or byte swapping), are
+/// serialized as usual between the runs.
+template <typename... Ts>
+FusedItems<Ts...> fused(Ts&... items) {
+  return FusedItems<Ts...>(items...);
+}
+
+namespace detail {
+
+template <typename T, typename Archive>
+using _is_fusable = std::integral_constant<bool,
+  is_directly_serializable<std::remove_const_t<T>>::value
+    and not archive_pads_raw_data<Archive>::value
+    and not _is_varint_encoded_integer<std::remove_const_t<T>, Archive>::value
+    and not swaps_bytes<
+      layout_byte_order_t<archive_layout_t<Archive>>, std::remove_const_t<T>
+    >::value
+>;
+
+// Where each item falls in the runs of fusable items, all computed at compile
+// time (the trailing entries just keep the arrays from being empty)
+template <typename Archive, typename... Ts>
+struct _fused_runs {
+
+  static constexpr std::size_t n_items = sizeof...(Ts);
+
+  static constexpr bool fusable(std::size_t i) {
+    bool const rv[] = { _is_fusable<Ts, Archive>::value..., false };
+    return rv[i];
+  }
+
+  static constexpr std::size_t size(std::size_t i) {
+    std::size_t const rv[] = { sizeof(Ts)..., 0 };
+    return rv[i];
+  }
+
+  static constexpr bool starts_run(std::size_t i) {
+    return fusable(i) and (i == 0 or not fusable(i - 1));
+  }
+
+  static constexpr bool ends_run(std::size_t i) {
+    return fusable(i) and (i + 1 == n_items or not fusable(i + 1));
+  }
+
+  // Bytes before item i in its run
+  static constexpr std::size_t offset(std::size_t i) {
+    std::size_t rv = 0;
+    while(not starts_run(i)) rv += size(--i);
+    return rv;
+  }
+
+  // Bytes in the run that starts at item i
+  static constexpr std::size_t run_size(std::size_t i) {
+    std::size_t rv = 0;
+    for(; i < n_items and fusable(i); ++i) rv += size(i);
+    return rv;
+  }
+
+  static constexpr std::size_t max_run_size() {
+    std::size_t rv = 1;
+    for(std::size_t i = 0; i < n_items; ++i) {
+      if(starts_run(i) and run_size(i) > rv) rv = run_size(i);
+    }
+    return rv;
+  }
+};
+
+template <typename Runs, std::size_t I>
+using _fusable_item = std::integral_constant<bool, Runs::fusable(I)>;
+
+// Forced to be constants (which the optimizer doesn't always manage by itself
+// for the loops above)
+template <typename Runs, std::size_t I>
+using _starts_run = std::integral_constant<bool, Runs::starts_run(I)>;
+template <typename Runs, std::size_t I>
+using _ends_run = std::integral_constant<bool, Runs::ends_run(I)>;
+template <typename Runs, std::size_t I>
+using _offset_in_run = std::integral_constant<std::size_t, Runs::offset(I)>;
+template <typename Runs, std::size_t I>
+using _run_size = std::integral_constant<std::size_t, Runs::run_size(I)>;
+
+//------------------------------------------------------------------------------
+// <editor-fold desc="sizing"> {{{2
+
+template <typename Runs, std::size_t I, typename Archive, typename T>
+void _compute_size_fused_item(Archive& ar, T const&, std::true_type /* fusable */) {
+  if(_starts_run<Runs, I>::value) ar.add_to_size_raw(_run_size<Runs, I>::value);
+}
+
+template <typename Runs, std::size_t I, typename Archive, typename T>
+void _compute_size_fused_item(Archive& ar, T const& item, std::false_type /* fusable */) {
+  ar | item;
+}
+
+template <typename Archive, typename... Ts, std::size_t... Idxs>
+void _compute_size_fused(
+  Archive& ar, FusedItems<Ts...> const& fused, std::index_sequence<Idxs...>
+) {
+  using runs_t = _fused_runs<Archive, Ts...>;
+  using swallow = int[];
+  (void)swallow{ 0, (
+    _compute_size_fused_item<runs_t, Idxs>(ar, std::get<Idxs>(fused.items()),
+      _fusable_item<runs_t, Idxs>{}
+    ), 0)...
+  };
+}
+
+// </editor-fold> end sizing }}}2
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// <editor-fold desc="packing"> {{{2
+
+template <typename Archive>
+using _fused_data_pointer_archetype =
+  decltype(std::declval<Archive&>().data_pointer_reference());
+
+template <typename Archive>
+using _has_fused_data_pointer =
+  tinympl::is_detected<_fused_data_pointer_archetype, Archive>;
+
+template <typename Archive>
+using _fused_check_capacity_archetype =
+  decltype(std::declval<Archive&>().check_capacity(std::size_t{}));
+
+template <typename Archive>
+using _has_fused_check_capacity =
+  tinympl::is_detected<_fused_check_capacity_archetype, Archive>;
+
+// Fusable items are copied at constant offsets from the spot where the run
+// starts, which the compiler can turn into plain stores, and the spot is moved
+// once per run.  That's straight into the buffer if the archive exposes where
+// it's packing, and otherwise into staged, which then goes to the archive all
+// at once.
+// Writing straight into the buffer skips the archive's own capacity checks, so
+// each run is checked once before its first item is copied
+template <std::size_t RunSize, typename Archive>
+void _check_fused_run_capacity(Archive& ar, std::true_type /* has check */) {
+  ar.check_capacity(RunSize);
+}
+
+template <std::size_t RunSize, typename Archive>
+void _check_fused_run_capacity(Archive&, std::false_type /* has check */) { }
+
+template <std::size_t RunSize, typename Archive>
+void _start_fused_packing_run(Archive& ar, std::true_type /* has data pointer */) {
+  _check_fused_run_capacity<RunSize>(ar,
+    typename _has_fused_check_capacity<Archive>::type{}
+  );
+}
+
+template <std::size_t RunSize, typename Archive>
+void _start_fused_packing_run(Archive&, std::false_type /* has data pointer */) { }
+
+template <typename Archive>
+char* _fused_packing_spot(Archive& ar, char*, std::true_type /* has data pointer */) {
+  return *reinterpret_cast<char**>(&ar.data_pointer_reference());
+}
+
+template <typename Archive>
+char* _fused_packing_spot(Archive&, char* staged, std::false_type /* has data pointer */) {
+  return staged;
+}
+
+template <std::size_t RunSize, typename Archive>
+void _end_fused_packing_run(Archive& ar, char*, std::true_type /* has data pointer */) {
+  *reinterpret_cast<char**>(&ar.data_pointer_reference()) += RunSize;
+}
+
+template <std::size_t RunSize, typename Archive>
+void _end_fused_packing_run(Archive& ar, char* staged, std::false_type /* has data pointer */) {
+  pack_data_raw_copy(ar, staged, staged + RunSize);
+}
+
+template <typename Runs, std::size_t I, typename Archive, typename T>
+void _pack_fused_item(
+  Archive& ar, T const& item, char* staged, std::true_type /* fusable */
+) {
+  if(_starts_run<Runs, I>::value) {
+    _start_fused_packing_run<_run_size<Runs, I>::value>(ar,
+      typename _has_fused_data_pointer<Archive>::type{}
+    );
+  }
+  auto* spot = _fused_packing_spot(ar, staged,
+    typename _has_fused_data_pointer<Archive>::type{}
+  );
+  std::memcpy(spot + _offset_in_run<Runs, I>::value, &item, sizeof(T));
+  if(_ends_run<Runs, I>::value) {
+    _end_fused_packing_run<_offset_in_run<Runs, I>::value + sizeof(T)>(ar, staged,
+      typename _has_fused_data_pointer<Archive>::type{}
+    );
+  }
+}
+
+template <typename Runs, std::size_t I, typename Archive, typename T>
+void _pack_fused_item(
+  Archive& ar, T const& item, char*, std::false_type /* fusable */
+) {
+  ar | item;
+}
+
+template <typename Archive, typename... Ts, std::size_t... Idxs>
+void _pack_fused(
+  Archive& ar, FusedItems<Ts...> const& fused, std::index_sequence<Idxs...>
+) {
+  using runs_t = _fused_runs<Archive, Ts...>;
+  char staged[runs_t::max_run_size()];
+  using swallow = int[];
+  (void)swallow{ 0, (
+    _pack_fused_item<runs_t, Idxs>(ar, std::get<Idxs>(fused.items()), staged,
+      _fusable_item<runs_t, Idxs>{}
+    ), 0)...
+  };
+}
+
+// </editor-fold> end packing }}}2
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// <editor-fold desc="unpacking"> {{{2
+
+// As with packing, straight from the buffer if the archive exposes where it's
+// unpacking from, and otherwise through staged (so that archives that check
+// their reads, like CheckedUnpackingArchive, check each run once)
+template <std::size_t RunSize, typename Archive>
+char const* _start_fused_unpacking_run(
+  Archive& ar, char*, std::true_type /* has data pointer */
+) {
+  auto& spot = *reinterpret_cast<char const**>(&ar.data_pointer_reference());
+  auto* rv = spot;
+  spot += RunSize;
+  return rv;
+}
+
+template <std::size_t RunSize, typename Archive>
+char const* _start_fused_unpacking_run(
+  Archive& ar, char* staged, std::false_type /* has data pointer */
+) {
+  ar.template unpack_data_raw<char const>(staged, RunSize);
+  return staged;
+}
+
+// Directly serializable types are trivially copyable, so fusable items can be
+// overwritten in place rather than destroyed and unpacked again
+template <typename Runs, std::size_t I, typename Archive, typename T>
+void _unpack_fused_item(
+  Archive& ar, T& item, char* staged, char const*& run, std::true_type /* fusable */
+) {
+  static_assert(not std::is_const<T>::value, "can't unpack into a const item");
+  if(_starts_run<Runs, I>::value) {
+    run = _start_fused_unpacking_run<_run_size<Runs, I>::value>(ar, staged,
+      typename _has_fused_data_pointer<Archive>::type{}
+    );
+  }
+  std::memcpy(&item, run + _offset_in_run<Runs, I>::value, sizeof(T));
+}
+
+template <typename Runs, std::size_t I, typename Archive, typename T>
+void _unpack_fused_item(
+  Archive& ar, T& item, char*, char const*&, std::false_type /* fusable */
+) {
+  ar | item;
+}
+
+template <typename Archive, typename... Ts, std::size_t... Idxs>
+void _unpack_fused(
+  Archive& ar, FusedItems<Ts...> const& fused, std::index_sequence<Idxs...>
+) {
+  using runs_t = _fused_runs<Archive, Ts...>;
+  char staged[runs_t::max_run_size()];
+  char const* run = staged;
+  using swallow = int[];
+  (void)swallow{ 0, (
+    _unpack_fused_item<runs_t, Idxs>(ar, std::get<Idxs>(fused.items()), staged, run,
+      _fusable_item<runs_t, Idxs>{}
+    ), 0)...
+  };
+}
+
+// </editor-fold> end unpacking }}}2
+//------------------------------------------------------------------------------
+
+template <typename Archive, typename... Ts>
+void _serialize_fused(
+  Archive& ar, FusedItems<Ts...> const& fused,
+  std::true_type /* sizing */, std::false_type /* packing */
+) {
+  _compute_size_fused(ar, fused, std::index_sequence_for<Ts...>{});
+}
+
+template <typename Archive, typename... Ts>
+void _serialize_fused(
+  Archive& ar, FusedItems<Ts...> const& fused,
+  std::false_type /* sizing */, std::true_type /* packing */
+) {
+  _pack_fused(ar, fused, std::index_sequence_for<Ts...>{});
+}
+
+template <typename Archive, typename... Ts>
+void _serialize_fused(
+  Archive& ar, FusedItems<Ts...> const& fused,
+  std::false_type /* sizing */, std::false_type /* packing */
+) {
+  _unpack_fused(ar, fused, std::index_sequence_for<Ts...>{});
+}
+
+} // end namespace detail
+
+// A FusedItems is meant to be a temporary, which the archives' own operator|
+// overloads can't unpack into, so this (found by ADL) takes precedence
+
+template <typename Archive, typename... Ts>
+std::enable_if_t<Archive::is_archive_t::value, Archive&>
+operator|(Archive& ar, FusedItems<Ts...>&& fused) {
+  detail::_serialize_fused(ar, fused,
+    std::integral_constant<bool, Archive::is_sizing()>{},
+    std::integral_constant<bool, Archive::is_packing()>{}
+  );
+  return ar;
+}
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_FUSED_H
@@ -0,0 +1,215 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      integer_encoding.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_INTEGER_ENCODING_H
+#define DARMAFRONTEND_SERIALIZATION_INTEGER_ENCODING_H
+
+#include <darma/serialization/raw_data_helpers.h>
+#include <darma/serialization/varint.h>
+#include <darma/serialization/wire_layout.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+template <typename Archive>
+using _pack_varint_archetype = decltype(
+  std::declval<Archive&>().pack_varint(std::declval<std::uint64_t>())
+);
+
+template <typename Archive>
+using _unpack_varint_archetype = decltype(std::declval<Archive&>().unpack_varint());
+
+template <typename PackingArchive>
+void _pack_varint(
+  PackingArchive& ar, std::uint64_t value,
+  std::true_type /* archive encodes varints itself */
+) {
+  ar.pack_varint(value);
+}
+
+template <typename PackingArchive>
+void _pack_varint(
+  PackingArchive& ar, std::uint64_t value,
+  std::false_type /* archive encodes varints itself */
+) {
+  unsigned char bytes[varint_max_size];
+  auto size = encode_varint(value, bytes);
+  pack_data_raw_copy(ar, bytes, bytes + size);
+}
+
+template <typename UnpackingArchive>
+std::uint64_t _unpack_varint(
+  UnpackingArchive& ar, std::true_type /* archive decodes varints itself */
+) {
+  return ar.unpack_varint();
+}
+
+template <typename UnpackingArchive>
+std::uint64_t _unpack_varint(
+  UnpackingArchive& ar, std::false_type /* archive decodes varints itself */
+) {
+  std::uint64_t rv = 0;
+  for(unsigned shift = 0; shift < 64; shift += 7) {
+    unsigned char byte;
+    ar.template unpack_data_raw<unsigned char const>(&byte, 1);
+    rv |= std::uint64_t(byte & 0x7f) << shift;
+    if((byte & 0x80) == 0) break;
+  }
+  return rv;
+}
+
+template <typename Archive>
+using _archive_varint_sizes = std::integral_constant<bool,
+  archive_integer_encoding_t<Archive>::varint_sizes
+>;
+
+} // end namespace detail
+
+//==============================================================================
+// <editor-fold desc="varints"> {{{1
+
+template <typename SizingArchive>
+void add_varint_to_size(SizingArchive& ar, std::uint64_t value) {
+  ar.add_to_size_raw(detail::varint_size(value));
+}
+
+/// Pack value as a varint (see varint.h).  Archives can provide
+/// pack_varint(value) to encode it in place; otherwise it's encoded to a
+/// temporary and given to pack_data_raw().
+template <typename PackingArchive>
+void pack_varint(PackingArchive& ar, std::uint64_t value) {
+  detail::_pack_varint(ar, value,
+    typename tinympl::is_detected<detail::_pack_varint_archetype, PackingArchive>::type{}
+  );
+}
+
+/// Unpack a varint packed by pack_varint().  Archives can provide
+/// unpack_varint() to decode it in place; otherwise it's read a byte at a time
+/// with unpack_data_raw().
+template <typename UnpackingArchive>
+std::uint64_t unpack_varint(UnpackingArchive& ar) {
+  return detail::_unpack_varint(ar,
+    typename tinympl::is_detected<detail::_unpack_varint_archetype, UnpackingArchive>::type{}
+  );
+}
+
+// </editor-fold> end varints }}}1
+//==============================================================================
+
+
+namespace detail {
+
+template <typename SizingArchive, typename SizeType>
+void _add_size_prefix_to_size(SizingArchive& ar, SizeType size, std::false_type /* varint */) {
+  ar | size;
+}
+
+template <typename SizingArchive, typename SizeType>
+void _add_size_prefix_to_size(SizingArchive& ar, SizeType size, std::true_type /* varint */) {
+  add_varint_to_size(ar, static_cast<std::uint64_t>(size));
+}
+
+template <typename PackingArchive, typename SizeType>
+void _pack_size_prefix(PackingArchive& ar, SizeType size, std::false_type /* varint */) {
+  ar | size;
+}
+
+template <typename PackingArchive, typename SizeType>
+void _pack_size_prefix(PackingArchive& ar, SizeType size, std::true_type /* varint */) {
+  pack_varint(ar, static_cast<std::uint64_t>(size));
+}
+
+template <typename SizeType, typename UnpackingArchive>
+SizeType _unpack_size_prefix(UnpackingArchive& ar, std::false_type /* varint */) {
+  return ar.template unpack_next_item_as<SizeType>();
+}
+
+template <typename SizeType, typename UnpackingArchive>
+SizeType _unpack_size_prefix(UnpackingArchive& ar, std::true_type /* varint */) {
+  return static_cast<SizeType>(unpack_varint(ar));
+}
+
+} // end namespace detail
+
+//==============================================================================
+// <editor-fold desc="size prefixes"> {{{1
+
+// Container serializers should write the number of elements (or bytes) they
+// contain with these rather than ar | obj.size(), so that it's varint encoded
+// for layouts with VarintSizes or VarintIntegers.  For the default layouts
+// these are exactly ar | size, so the fixed-width wire format (and its speed)
+// is unchanged.
+
+template <typename SizingArchive, typename SizeType>
+void add_size_prefix_to_size(SizingArchive& ar, SizeType size) {
+  detail::_add_size_prefix_to_size(ar, size, detail::_archive_varint_sizes<SizingArchive>{});
+}
+
+template <typename PackingArchive, typename SizeType>
+void pack_size_prefix(PackingArchive& ar, SizeType size) {
+  detail::_pack_size_prefix(ar, size, detail::_archive_varint_sizes<PackingArchive>{});
+}
+
+template <typename SizeType, typename UnpackingArchive>
+SizeType unpack_size_prefix(UnpackingArchive& ar) {
+  return detail::_unpack_size_prefix<SizeType>(ar,
+    detail::_archive_varint_sizes<UnpackingArchive>{}
+  );
+}
+
+// </editor-fold> end size prefixes }}}1
+//==============================================================================
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_INTEGER_ENCODING_H
@@ -0,0 +1,261 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      mapped_file_serialization_buffer.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_MAPPED_FILE_SERIALIZATION_BUFFER_H
+#define DARMAFRONTEND_SERIALIZATION_MAPPED_FILE_SERIALIZATION_BUFFER_H
+
+#include <darma/serialization/fatal_error.h>
+
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <system_error>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define DARMA_SERIALIZATION_HAS_MMAP 1
+#endif
+
+#ifdef DARMA_SERIALIZATION_HAS_MMAP
+
+namespace darma {
+namespace serialization {
+
+/// Hints for how a MappedFileSerializationBuffer will be accessed.  They're
+/// only advice to the kernel; any that aren't supported are ignored.
+struct MappedFileHints {
+  /// Pages are touched front to back (i.e., one pack or unpack pass), so the
+  /// kernel can read ahead aggressively and drop pages behind the access
+  bool sequential = true;
+  /// Ask for transparent huge pages, to cut the number of page faults and TLB
+  /// misses for very large files.  Whether file-backed mappings get them
+  /// depends on the kernel and filesystem.
+  bool huge_pages = false;
+  /// Fault the whole file in up front (when it's opened, rather than as it's
+  /// unpacked); only applies to files opened for reading
+  bool populate = false;
+};
+
+/// A serialization buffer backed by a memory-mapped file, for checkpointing
+/// to and restarting from disk without an intermediate copy through a
+/// DynamicSerializationBuffer and write()/read().
+///
+/// The (path, size) constructor creates (or truncates) the file at path,
+/// makes it size bytes long and maps it for writing; this is what
+/// SimpleSerializationHandler::serialize_to_file() packs into.  The (path)
+/// constructor maps an existing file read-only, so it can be given to
+/// deserialize() straight out of the page cache.  Writing through data() of a
+/// read-only buffer is an error (and will fault).
+class MappedFileSerializationBuffer {
+
+  public:
+
+    MappedFileSerializationBuffer(
+      std::string const& path, size_t size,
+      MappedFileHints const& hints = MappedFileHints{}
+    ) : size_(size), writable_(true)
+    {
+      fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd_ < 0) _error("couldn't create mapped serialization file");
+      if(size_ > 0) {
+        auto err = _allocate_file(fd_, size_);
+        if(err != 0) {
+          _close();
+          errno = err;
+          _error("couldn't allocate mapped serialization file");
+        }
+      }
+      _map(PROT_READ | PROT_WRITE, 0, hints);
+    }
+
+    explicit
+    MappedFileSerializationBuffer(
+      std::string const& path,
+      MappedFileHints const& hints = MappedFileHints{}
+    ) : writable_(false)
+    {
+      fd_ = ::open(path.c_str(), O_RDONLY);
+      if(fd_ < 0) _error("couldn't open mapped serialization file");
+      struct stat st;
+      if(::fstat(fd_, &st) != 0) {
+        auto err = errno;
+        _close();
+        errno = err;
+        _error("couldn't stat mapped serialization file");
+      }
+      size_ = static_cast<size_t>(st.st_size);
+      int flags = 0;
+#ifdef MAP_POPULATE
+      if(hints.populate) flags |= MAP_POPULATE;
+#endif
+      _map(PROT_READ, flags, hints);
+    }
+
+    MappedFileSerializationBuffer(MappedFileSerializationBuffer&& other) noexcept
+      : data_(other.data_), size_(other.size_), fd_(other.fd_),
+        writable_(other.writable_)
+    {
+      other.data_ = nullptr;
+      other.size_ = 0;
+      other.fd_ = -1;
+    }
+
+    MappedFileSerializationBuffer& operator=(MappedFileSerializationBuffer&& other) noexcept {
+      if(this != &other) {
+        _unmap();
+        _close();
+        data_ = other.data_;
+        size_ = other.size_;
+        fd_ = other.fd_;
+        writable_ = other.writable_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.fd_ = -1;
+      }
+      return *this;
+    }
+
+    ~MappedFileSerializationBuffer() {
+      _unmap();
+      _close();
+    }
+
+    char* data() {
+      assert(writable_ && "writing to a read-only MappedFileSerializationBuffer");
+      return data_;
+    }
+    char const* data() const { return data_; }
+
+    size_t capacity() const { return size_; }
+
+    bool writable() const { return writable_; }
+
+    /// Block until everything written so far is on disk (rather than just in
+    /// the page cache), e.g., before reporting that a checkpoint is complete.
+    /// Unmapping doesn't do this; without it, dirty pages are written back
+    /// whenever the kernel gets around to it.
+    void sync() {
+      if(writable_ and data_ != nullptr and ::msync(data_, size_, MS_SYNC) != 0) {
+        _error("couldn't sync mapped serialization file");
+      }
+    }
+
+  private:
+
+    // Returns an errno value, or 0 on success
+    static int _allocate_file(int fd, size_t size) {
+#ifndef __APPLE__
+      // Unlike ftruncate(), this makes sure the blocks exist, so running out
+      // of disk space is reported here rather than as a SIGBUS when packing
+      auto err = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+      if(err != EINVAL and err != EOPNOTSUPP) return err;
+      // ...but not every filesystem supports it
+#endif
+      return ::ftruncate(fd, static_cast<off_t>(size)) == 0 ? 0 : errno;
+    }
+
+    void _map(int prot, int extra_flags, MappedFileHints const& hints) {
+      // mmap() rejects zero-length mappings; an empty file has no data anyway
+      if(size_ == 0) return;
+      auto* ptr = ::mmap(nullptr, size_, prot, MAP_SHARED | extra_flags, fd_, 0);
+      if(ptr == MAP_FAILED) {
+        // close() can overwrite the errno from mmap()
+        auto err = errno;
+        _close();
+        errno = err;
+        _error("couldn't map serialization file");
+      }
+      data_ = static_cast<char*>(ptr);
+      // Advice is best-effort, so failures are ignored
+      if(hints.sequential) {
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+      }
+#ifdef MADV_HUGEPAGE
+      if(hints.huge_pages) {
+        ::madvise(data_, size_, MADV_HUGEPAGE);
+      }
+#endif
+    }
+
+    void _unmap() {
+      if(data_ != nullptr) {
+        ::munmap(data_, size_);
+        data_ = nullptr;
+      }
+    }
+
+    void _close() {
+      if(fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+      }
+    }
+
+    [[noreturn]] static void _error(char const* what) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      throw std::system_error(errno, std::generic_category(), what);
+#else
+      detail::_fatal_error(std::string(what) + ": " + std::strerror(errno));
+#endif
+    }
+
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    int fd_ = -1;
+    bool writable_ = false;
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif // DARMA_SERIALIZATION_HAS_MMAP
+
+#endif //DARMAFRONTEND_SERIALIZATION_MAPPED_FILE_SERIALIZATION_BUFFER_H
@@ -0,0 +1,157 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      object_identity.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_OBJECT_IDENTITY_H
+#define DARMAFRONTEND_SERIALIZATION_OBJECT_IDENTITY_H
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+/// Assigns ids to the objects referenced through shared pointers, in the
+/// order they're first seen, so that each one is packed only once.  The sizing
+/// and packing archives each have their own table; since both passes visit
+/// the objects in the same order, they assign the same ids.
+class PackingObjectIdentityTable {
+  private:
+
+    // Objects are distinguished by static type as well as address, so that,
+    // e.g., a struct and its first member aren't mistaken for each other
+    using key_t = std::pair<void const*, std::type_index>;
+
+    struct _key_hash {
+      std::size_t operator()(key_t const& key) const {
+        return std::hash<void const*>{}(key.first) ^ (key.second.hash_code() << 1);
+      }
+    };
+
+    std::unordered_map<key_t, std::size_t, _key_hash> ids_;
+
+  public:
+
+    /// The id of the object at address (with static type type), and whether
+    /// this is the first time it's been seen
+    std::pair<std::size_t, bool>
+    insert(void const* address, std::type_index type) {
+      auto rv = ids_.emplace(key_t(address, type), ids_.size());
+      return { rv.first->second, rv.second };
+    }
+
+    std::size_t size() const { return ids_.size(); }
+};
+
+/// The objects referenced through shared pointers that have been unpacked so
+/// far, indexed by the ids PackingObjectIdentityTable assigned them, along
+/// with the static types they were unpacked as.  The table holds a reference
+/// to each of them until the archive is destroyed.
+class UnpackingObjectIdentityTable {
+  private:
+
+    struct _entry {
+      std::shared_ptr<void> object;
+      std::type_index type;
+    };
+
+    std::vector<_entry> objects_;
+
+  public:
+
+    /// Reserve the next id for an object of static type type before unpacking
+    /// it, so that ids line up with the (pre-order) ids assigned while packing
+    std::size_t reserve_next(std::type_index type) {
+      objects_.push_back(_entry{ nullptr, type });
+      return objects_.size() - 1;
+    }
+
+    void set(std::size_t id, std::shared_ptr<void> obj) {
+      assert(id < objects_.size());
+      objects_[id].object = std::move(obj);
+    }
+
+    /// The object with the given id, or null if there's no such object, if it
+    /// was unpacked as some type other than type, or if it's still being
+    /// unpacked (i.e., it refers back to itself, or to an object that refers to
+    /// it).  Ids come from the buffer, so none of these can be ruled out.
+    std::shared_ptr<void> const* find(std::size_t id, std::type_index type) const {
+      if(id >= objects_.size()) return nullptr;
+      auto const& entry = objects_[id];
+      if(entry.object == nullptr or entry.type != type) return nullptr;
+      return &entry.object;
+    }
+
+    std::size_t size() const { return objects_.size(); }
+};
+
+/// An identity table that's only created the first time it's needed, so that
+/// archives that never see a shared pointer don't pay for one
+template <typename Table>
+class LazyObjectIdentityTable {
+  private:
+
+    std::unique_ptr<Table> table_;
+
+  public:
+
+    Table& get() {
+      if(not table_) table_ = std::make_unique<Table>();
+      return *table_;
+    }
+};
+
+} // end namespace detail
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_OBJECT_IDENTITY_H
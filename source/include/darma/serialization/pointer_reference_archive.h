@@ -65,6 +65,7 @@ class PointerReferencePackingArchive {
   private:
 
     darma::utility::compressed_pair<char*&, SerializationBuffer> data_spot_;
+    detail::LazyObjectIdentityTable<detail::PackingObjectIdentityTable> object_identities_;
 
     template <typename... SerializationBufferCtorArgs>
     PointerReferencePackingArchive(
@@ -86,7 +87,7 @@ class PointerReferencePackingArchive {
 
     template <typename>
     friend struct PointerReferenceSerializationHandler;
-    template <typename>
+    template <typename, typename>
     friend struct SimpleSerializationHandler;
 
   public:
@@ -125,10 +126,16 @@ class PointerReferencePackingArchive {
     }
 
     void*& data_pointer_reference() { return *reinterpret_cast<void**>(&data_spot_.first()); }
+
+    detail::PackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
 };
 
 template <typename Allocator = std::allocator<char>>
-class PointerReferenceUnpackingArchive {
+class PointerReferenceUnpackingArchive
+  : public detail::UnpackingArchiveMixin<
+      PointerReferenceUnpackingArchive<Allocator>, Allocator
+    >
+{
   public:
 
     // Concept "shortcut" tag
@@ -139,7 +146,8 @@ class PointerReferenceUnpackingArchive {
 
   private:
 
-    darma::utility::compressed_pair<char const*&, Allocator> data_spot_;
+    darma::utility::compressed_pair<char const*&, allocator_type> data_spot_;
+    detail::LazyObjectIdentityTable<detail::UnpackingObjectIdentityTable> object_identities_;
 
     explicit
     PointerReferenceUnpackingArchive(char const*& ptr)
@@ -150,6 +158,22 @@ class PointerReferenceUnpackingArchive {
         )
     { }
 
+    PointerReferenceUnpackingArchive(
+      char const*& ptr, allocator_type const& alloc
+    ) : data_spot_(
+          std::piecewise_construct,
+          std::forward_as_tuple(ptr),
+          std::forward_as_tuple(alloc)
+        )
+    { }
+
+    PointerReferenceUnpackingArchive(
+      void const*& ptr, allocator_type const& alloc
+    ) : PointerReferenceUnpackingArchive(
+          *reinterpret_cast<char const**>(&ptr), alloc
+        )
+    { /* forwarding ctor, must be empty */ }
+
     // Put this here to do the messy casting for interfacing with a void* in one place
     explicit
     PointerReferenceUnpackingArchive(char*& ptr)
@@ -172,7 +196,7 @@ class PointerReferenceUnpackingArchive {
 
     template <typename>
     friend struct PointerReferenceSerializationHandler;
-    template <typename>
+    template <typename, typename>
     friend struct SimpleSerializationHandler;
 
     template <typename T>
@@ -222,6 +246,17 @@ class PointerReferenceUnpackingArchive {
       data_spot_.first() += size;
     }
 
+    /// Like unpack_data_raw(), but returns a pointer to the data in the buffer
+    /// rather than copying it out.  Data that isn't aligned for RawDataType
+    /// throws a std::runtime_error (or aborts, without exceptions); the end of
+    /// the buffer isn't known, so it can't be checked against.
+    template <typename RawDataType>
+    RawDataType const* view_data_raw(size_t n_items = 1) {
+      return detail::_view_data_raw<std::remove_const_t<RawDataType>>(
+        data_spot_.first(), n_items
+      );
+    }
+
     template <typename T>
     inline auto& operator|(T& obj) & {
       return _ask_serializer_to_unpack(obj);
@@ -232,52 +267,6 @@ class PointerReferenceUnpackingArchive {
       return _ask_serializer_to_unpack(obj);
     }
 
-    template <typename T>
-    inline T unpack_next_item_as(
-      std::enable_if_t<
-        (sizeof(T) > DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX),
-        darma::utility::_not_a_type_numbered<0>
-      > = { }
-    ) & {
-      using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
-      auto alloc = allocator_t(get_allocator());
-      auto* storage = std::allocator_traits<allocator_t>::allocate(
-        alloc, 1
-      );
-      darma_unpack(allocated_buffer_for<T>(storage), *this);
-      // Use a unique_ptr to delete the temporary storage after returning
-      std::unique_ptr<T> raii_holder(*reinterpret_cast<T*>(storage));
-      return *raii_holder.get();
-    }
-
-    template <typename T>
-    inline T unpack_next_item_as(
-      std::enable_if_t<
-        (sizeof(T) <= DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX),
-        darma::utility::_not_a_type_numbered<1>
-      > = { }
-    ) & {
-      char on_stack_buffer[sizeof(T)];
-      darma_unpack(allocated_buffer_for<T>(on_stack_buffer), *this);
-      // Use a unique_ptr to delete the temporary storage after returning
-      auto destroy_but_not_delete = [this](auto* ptr) {
-        using allocator_t = typename std::allocator_traits<allocator_type>::template rebind_alloc<T>;
-        allocator_t alloc{this->get_allocator()};
-        // Destroy but don't deallocate, since the data is allocated on the stack
-        std::allocator_traits<allocator_t>::destroy(alloc, ptr);
-      };
-      std::unique_ptr<T, decltype(destroy_but_not_delete)> raii_destroy(
-        reinterpret_cast<T*>(on_stack_buffer),
-        destroy_but_not_delete
-      );
-      return *raii_destroy.get();
-    }
-
-    template <typename T>
-    inline void unpack_next_item_at(void* allocated) & {
-      darma_unpack(allocated_buffer_for<T>(allocated), *this);
-    }
-
     auto const& get_allocator() const {
       return data_spot_.second();
     }
@@ -287,12 +276,13 @@ class PointerReferenceUnpackingArchive {
 
     template <typename NeededAllocatorT>
     NeededAllocatorT get_allocator_as() const {
-      // Let's hope this is a compatible type
-      return data_spot_.second();
+      return detail::get_allocator_as<NeededAllocatorT>(data_spot_.second());
     }
 
     void const*& data_pointer_reference() { return *reinterpret_cast<void const**>(&data_spot_.first()); }
 
+    detail::UnpackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+
 };
 
 } // end namespace serialization
@@ -54,6 +54,9 @@
 
 #include <darma/serialization/simple_archive.h>
 #include <darma/serialization/simple_handler.h>
+#include <darma/serialization/wire_layout.h>
+
+#include <type_traits>
 
 namespace darma {
 namespace serialization {
@@ -64,6 +67,25 @@ struct PointerReferenceSerializationHandler
   : FallbackHandler
 {
 
+  private:
+
+    // The pointer reference archives copy raw data as is and write sizes at
+    // their full width, in the middle of the referenced archive's buffer
+    template <typename Archive>
+    static void _check_referenced_archive_layout() {
+      static_assert(not archive_pads_raw_data<Archive>::value,
+        "pointer reference archives only support the packed wire layout"
+      );
+      static_assert(
+        std::is_same<layout_byte_order_t<archive_layout_t<Archive>>, NativeByteOrder>::value,
+        "pointer reference archives only support the native byte order"
+      );
+      static_assert(
+        std::is_same<archive_integer_encoding_t<Archive>, FixedWidthIntegers>::value,
+        "pointer reference archives only support fixed width integers"
+      );
+    }
+
   public:
 
     static auto make_packing_archive(char*& ptr) {
@@ -77,6 +99,7 @@ struct PointerReferenceSerializationHandler
     template <typename CompatiblePackingArchive>
     _darma_requires( requires(CompatiblePackingArchive a) { a._data_spot() => char*&; } )
     static auto make_packing_archive_referencing(CompatiblePackingArchive& ar) {
+      _check_referenced_archive_layout<CompatiblePackingArchive>();
       return PointerReferencePackingArchive<>(
         SimpleSerializationHandler<>::template _data_spot_reference_as<char>(ar)
       );
@@ -98,14 +121,28 @@ struct PointerReferenceSerializationHandler
       return PointerReferenceUnpackingArchive<>(ptr);
     }
 
+    template <typename Allocator>
+    static auto make_unpacking_archive(char const*& ptr, Allocator const& alloc) {
+      using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+      return PointerReferenceUnpackingArchive<allocator_t>(ptr, allocator_t(alloc));
+    }
+
+    template <typename Allocator>
+    static auto make_unpacking_archive(void const*& ptr, Allocator const& alloc) {
+      using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+      return PointerReferenceUnpackingArchive<allocator_t>(ptr, allocator_t(alloc));
+    }
+
     template <typename CompatibleUnpackingArchive>
     _darma_requires( requires(CompatibleUnpackingArchive a) { a._data_spot() => char const*&; } )
     static auto make_unpacking_archive_referencing(
       CompatibleUnpackingArchive& ar
     ) {
+      _check_referenced_archive_layout<CompatibleUnpackingArchive>();
       using allocator_t = std::decay_t<decltype(ar.get_allocator())>;
       return PointerReferenceUnpackingArchive<allocator_t>(
-        SimpleSerializationHandler<allocator_t>::template _const_data_spot_reference_as<char>(ar)
+        SimpleSerializationHandler<allocator_t>::template _const_data_spot_reference_as<char>(ar),
+        ar.get_allocator()
       );
     }
 
@@ -45,62 +45,161 @@
 #ifndef DARMA_IMPL_POLYMORPHIC_SERIALIZATION_H
 #define DARMA_IMPL_POLYMORPHIC_SERIALIZATION_H
 
+#include <darma/serialization/fatal_error.h>
 #include <darma/serialization/polymorphic/registry.h>
 #include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
 
-#include <darma/utility/darma_assert.h>
 #include <darma/utility/demangle.h>
 
+#include <cstdint>
+#include <cstring> // memcpy
 #include <memory> // unique_ptr
+#include <string>
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <stdexcept>
+#endif
 
 namespace darma {
 namespace serialization {
 
+namespace detail {
+
+// Type ids are stable across binaries, so a buffer from another process can
+// name a type that isn't registered here (or isn't registered as
+// AbstractType).  Unpacking through a null unpack function would be much
+// worse than failing, so this is an error in every build, not just in debug
+// builds.
 template <typename AbstractType>
-std::unique_ptr<AbstractType>
-PolymorphicSerializableObject<AbstractType>::unpack(char const*& buffer) {
-  // Get the abstract type index that we're looking for
-  static const size_t abstract_type_index =
-    darma::serialization::detail::get_abstract_type_index<AbstractType>();
-
-  // Get the header
-  auto const& header = *reinterpret_cast<
-    darma::serialization::detail::SerializedPolymorphicObjectHeader const*
-  >(buffer);
-  buffer += sizeof(darma::serialization::detail::SerializedPolymorphicObjectHeader);
-
-  // Look through the abstract bases that this object is registered for until
-  // we find the entry that corresponds to a callable that unpacks the object
-  // as a std::unique_ptr<AbstractType>
-  uint8_t i_base = 0;
-  size_t concrete_index = std::numeric_limits<size_t>::max();
-  for(; i_base < header.n_bases; ++i_base) {
-    const auto& entry = *reinterpret_cast<
-      darma::serialization::detail::PolymorphicAbstractBasesTableEntry const*
-    >(buffer);
-
-    if (abstract_type_index == entry.abstract_index) {
-      // We found the one we want to call, so break
-      concrete_index = entry.concrete_index;
-      break;
-    }
+[[noreturn]] void
+_unknown_polymorphic_type() {
+  std::string message = "Serialized object's concrete type isn't registered"
+    " to be unpacked as abstract type "
+    + darma::utility::try_demangle<AbstractType>::name();
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  throw std::runtime_error(message);
+#else
+  _fatal_error(message);
+#endif
+}
+
+// Returns the unpack function for the compact header at the start of buffer
+// (or nullptr if there isn't one registered) and advances buffer past the
+// header
+template <typename AbstractType>
+polymorphic_unpack_function_t<AbstractType>
+_find_unpack_function_compact(char const*& buffer) {
+  static const std::uint32_t abstract_type_id =
+    compact_polymorphic_type_id(polymorphic_type_id<AbstractType>::value());
+  static auto const& reg = get_polymorphic_unpack_registry<AbstractType>();
 
-    buffer += sizeof(darma::serialization::detail::PolymorphicAbstractBasesTableEntry);
+  std::size_t n_bases = static_cast<std::uint8_t>(*buffer)
+    & ~compact_polymorphic_header_flag;
+  ++buffer;
+
+  std::uint32_t concrete_id = 0;
+  if(n_bases == 1) {
+    // The abstract id is implied, so a concrete type that isn't registered as
+    // an AbstractType just won't be found in the registry
+    std::memcpy(&concrete_id, buffer, sizeof(std::uint32_t));
+    buffer += sizeof(std::uint32_t);
+  }
+  else {
+    for(std::size_t i_base = 0; i_base < n_bases; ++i_base) {
+      CompactPolymorphicAbstractBasesTableEntry entry;
+      std::memcpy(&entry, buffer + i_base * sizeof(entry), sizeof(entry));
+      if(entry.abstract_id == abstract_type_id) {
+        concrete_id = entry.concrete_id;
+        break;
+      }
+    }
+    buffer += n_bases * sizeof(CompactPolymorphicAbstractBasesTableEntry);
   }
-  DARMA_ASSERT_MESSAGE(
-    concrete_index != std::numeric_limits<size_t>::max(),
-    "No registered unpacker found to unpack a concrete type as abstract type "
-      << darma::utility::try_demangle<AbstractType>::name()
-  );
 
-  // Make sure we advance the buffer over all of the other base class entries
-  buffer += sizeof(darma::serialization::detail::PolymorphicAbstractBasesTableEntry) * (header.n_bases - i_base);
+  return reg.find_compact(concrete_id);
+}
+
+// Same as above, for the wide header
+template <typename AbstractType>
+polymorphic_unpack_function_t<AbstractType>
+_find_unpack_function_wide(char const*& buffer) {
+  using header_t = SerializedPolymorphicObjectHeader;
+  using entry_t = PolymorphicAbstractBasesTableEntry;
+
+  // Get the id of the abstract type that we're looking for
+  static const std::uint64_t abstract_type_id =
+    polymorphic_type_id<AbstractType>::value();
 
   // get a reference to the static registry
-  auto& reg = darma::serialization::detail::get_polymorphic_unpack_registry<AbstractType>();
+  static auto const& reg = get_polymorphic_unpack_registry<AbstractType>();
 
-  // execute the unpack callable on the buffer
-  return reg[concrete_index](buffer);
+  // Get the header.  It's copied out rather than read in place, since objects
+  // packed inside other data (e.g., by the std::unique_ptr serializers)
+  // aren't necessarily aligned
+  header_t header;
+  std::memcpy(&header, buffer, sizeof(header_t));
+  auto const* entries = buffer + sizeof(header_t);
+  auto const n_bases = header.n_bases;
+
+  // The common case is that the concrete type only has the one abstract base,
+  // so there's only one entry to look at.  Otherwise, look through the abstract
+  // bases that this object is registered for until we find the entry that
+  // corresponds to a function that unpacks the object as a
+  // std::unique_ptr<AbstractType>
+  std::uint64_t concrete_id = 0;
+  for(size_t i_base = 0; i_base < n_bases; ++i_base) {
+    entry_t entry;
+    std::memcpy(&entry, entries + i_base * sizeof(entry_t), sizeof(entry_t));
+    if(entry.abstract_id == abstract_type_id) {
+      concrete_id = entry.concrete_id;
+      break;
+    }
+  }
+
+  // Advance the buffer over the header and all of the base class entries
+  buffer += sizeof(header_t) + sizeof(entry_t) * n_bases;
+
+  // Look up the unpack function for the concrete type.  (If the object isn't
+  // registered with AbstractType as a base, concrete_id is still 0, which is
+  // never registered.)
+  if(concrete_id == 0) return nullptr;
+  return reg.find(concrete_id);
+}
+
+// Returns the unpack function for the header (of either format) at the start
+// of buffer (or nullptr if there isn't one registered) and advances buffer
+// past the header
+template <typename AbstractType>
+polymorphic_unpack_function_t<AbstractType>
+_find_unpack_function(char const*& buffer) {
+  // The first byte of the compact header has the high bit set; the first byte
+  // of the wide header (part of a small n_bases) never does
+  return (static_cast<std::uint8_t>(*buffer) & compact_polymorphic_header_flag)
+    ? _find_unpack_function_compact<AbstractType>(buffer)
+    : _find_unpack_function_wide<AbstractType>(buffer);
+}
+
+} // end namespace detail
+
+template <typename AbstractType>
+std::unique_ptr<AbstractType>
+PolymorphicSerializableObject<AbstractType>::unpack(char const*& buffer) {
+  auto unpack_function = detail::_find_unpack_function<AbstractType>(buffer);
+  if(unpack_function == nullptr) detail::_unknown_polymorphic_type<AbstractType>();
+
+  // execute the unpack function on the buffer; without a resource, the object
+  // is allocated with new, so it's fine for default_delete to delete it
+  return std::unique_ptr<AbstractType>(unpack_function(buffer, nullptr).release());
+}
+
+template <typename AbstractType>
+polymorphic_unique_ptr<AbstractType>
+PolymorphicSerializableObject<AbstractType>::unpack(
+  char const*& buffer, MemoryResource& resource
+) {
+  auto unpack_function = detail::_find_unpack_function<AbstractType>(buffer);
+  if(unpack_function == nullptr) detail::_unknown_polymorphic_type<AbstractType>();
+  return unpack_function(buffer, &resource);
 }
 
 } // end namespace serialization
@@ -0,0 +1,202 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      memory_resource.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_MEMORY_RESOURCE_H
+#define DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_MEMORY_RESOURCE_H
+
+#include <darma/serialization/fatal_error.h>
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <stdexcept>
+#endif
+
+namespace darma {
+namespace serialization {
+
+//==============================================================================
+// <editor-fold desc="MemoryResource"> {{{1
+
+/// A type-erased source of memory (in the spirit of C++17's
+/// std::pmr::memory_resource) for objects whose concrete type isn't known
+/// until they're deserialized, e.g., by
+/// PolymorphicSerializableObject<AbstractType>::unpack().  Objects allocated
+/// from a resource hold a pointer to it, so it must outlive them.
+class MemoryResource {
+  public:
+
+    virtual void* allocate(std::size_t size, std::size_t alignment) =0;
+
+    virtual void deallocate(void* ptr, std::size_t size, std::size_t alignment) noexcept =0;
+
+    virtual ~MemoryResource() = default;
+};
+
+/// A MemoryResource that allocates from a (standard library compatible)
+/// allocator.  Alignments up to alignof(std::max_align_t) are supported; a
+/// bigger one throws a std::invalid_argument (or aborts, without exceptions)
+/// rather than handing out misaligned storage.
+template <typename Allocator>
+class AllocatorMemoryResource
+  : public MemoryResource
+{
+  private:
+
+    // Allocate in units of max_align_t, so that the result is suitably aligned
+    // for anything that isn't over-aligned, whatever the allocator
+    using unit_t = std::max_align_t;
+    using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<unit_t>;
+    using allocator_traits_t = std::allocator_traits<allocator_t>;
+
+    allocator_t alloc_;
+
+    static std::size_t _n_units(std::size_t size) {
+      return (size + sizeof(unit_t) - 1) / sizeof(unit_t);
+    }
+
+    // An over-aligned concrete type would silently get misaligned storage, so
+    // this is an error in every build, not just in debug builds
+    [[noreturn]] static void _over_aligned() {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      throw std::invalid_argument(
+        "AllocatorMemoryResource doesn't support over-aligned types"
+      );
+#else
+      detail::_fatal_error("AllocatorMemoryResource doesn't support over-aligned types");
+#endif
+    }
+
+  public:
+
+    AllocatorMemoryResource() = default;
+
+    explicit
+    AllocatorMemoryResource(Allocator const& alloc)
+      : alloc_(alloc)
+    { }
+
+    void* allocate(std::size_t size, std::size_t alignment) override {
+      if(alignment > alignof(unit_t)) _over_aligned();
+      // Rounding up to whole units would wrap around to a small allocation
+      if(size > std::numeric_limits<std::size_t>::max() - sizeof(unit_t)) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+        throw std::bad_alloc();
+#else
+        detail::_fatal_error("allocation from an AllocatorMemoryResource is too large");
+#endif
+      }
+      return allocator_traits_t::allocate(alloc_, _n_units(size));
+    }
+
+    void deallocate(void* ptr, std::size_t size, std::size_t) noexcept override {
+      allocator_traits_t::deallocate(alloc_, static_cast<unit_t*>(ptr), _n_units(size));
+    }
+
+    allocator_t const& get_allocator() const { return alloc_; }
+};
+
+// </editor-fold> end MemoryResource }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="PolymorphicDeleter"> {{{1
+
+/// The deleter for polymorphic objects that may have been allocated from a
+/// MemoryResource.  A default-constructed deleter just calls delete, like
+/// std::default_delete.
+template <typename AbstractType>
+class PolymorphicDeleter {
+  public:
+
+    using destroy_function_t = void(*)(AbstractType*, MemoryResource&);
+
+    PolymorphicDeleter() = default;
+
+    PolymorphicDeleter(MemoryResource& resource, destroy_function_t destroy)
+      : resource_(&resource), destroy_(destroy)
+    { }
+
+    void operator()(AbstractType* ptr) const {
+      if(destroy_ != nullptr) destroy_(ptr, *resource_);
+      else delete ptr;
+    }
+
+    /// The resource the object was allocated from, or nullptr if it was
+    /// allocated with new
+    MemoryResource* resource() const { return resource_; }
+
+  private:
+
+    MemoryResource* resource_ = nullptr;
+    destroy_function_t destroy_ = nullptr;
+};
+
+template <typename AbstractType>
+using polymorphic_unique_ptr =
+  std::unique_ptr<AbstractType, PolymorphicDeleter<AbstractType>>;
+
+namespace detail {
+
+template <typename ConcreteType, typename AbstractType>
+void
+_destroy_polymorphic_object(AbstractType* ptr, MemoryResource& resource) {
+  auto* obj = static_cast<ConcreteType*>(ptr);
+  obj->~ConcreteType();
+  resource.deallocate(obj, sizeof(ConcreteType), alignof(ConcreteType));
+}
+
+} // end namespace detail
+
+// </editor-fold> end PolymorphicDeleter }}}1
+//==============================================================================
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_MEMORY_RESOURCE_H
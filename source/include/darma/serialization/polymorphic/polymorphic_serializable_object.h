@@ -45,7 +45,11 @@
 #ifndef DARMA_ABSTRACT_FRONTEND_POLYMORPHIC_SERIALIZABLE_OBJECT_H
 #define DARMA_ABSTRACT_FRONTEND_POLYMORPHIC_SERIALIZABLE_OBJECT_H
 
+#include <darma/serialization/polymorphic/memory_resource.h>
+
+#include <cstddef>
 #include <memory> // std::unique_ptr
+#include <type_traits>
 
 namespace darma {
 namespace serialization {
@@ -57,12 +61,37 @@ struct PolymorphicSerializableObject {
 
   virtual void pack(char*& buffer) const =0;
 
+  /// The size of the header at the start of what pack() writes, which
+  /// identifies the concrete type and is the same for every object of that
+  /// type.  Zero (the default) if the object can't be packed without it.
+  virtual size_t get_packed_header_size() const { return 0; }
+
+  /// Like pack(), without the header.  Containers use this to write the header
+  /// once for a run of objects of the same concrete type.  Only called if
+  /// get_packed_header_size() is nonzero.
+  virtual void pack_without_header(char*& /* buffer */) const { }
+
   static
   std::unique_ptr<AbstractType>
   unpack(char const*& buffer);
 
+  /// Allocates the unpacked object from resource (which must outlive it).
+  /// Objects of types registered with a user-defined static unpack hook,
+  /// rather than through PolymorphicSerializationAdapter, are still allocated
+  /// by the hook; the deleter knows the difference.
+  static
+  polymorphic_unique_ptr<AbstractType>
+  unpack(char const*& buffer, MemoryResource& resource);
+
 };
 
+/// True if T is an abstract type that can be unpacked with
+/// PolymorphicSerializableObject<T>::unpack()
+template <typename T>
+struct is_polymorphic_serializable
+  : std::is_base_of<PolymorphicSerializableObject<T>, T>
+{ };
+
 } // end namespace serialization
 } // end namespace darma
 
@@ -47,43 +47,76 @@
 
 #include <darma/serialization/polymorphic/registry.h>
 #include <darma/serialization/simple_handler.h>
+#include <darma/serialization/pointer_reference_handler.h>
 
 #include <tinympl/variadic/find.hpp>
+#include <tinympl/vector.hpp>
+
+#include <cstdint>
+#include <cstring>
 
 namespace darma {
 namespace serialization {
 
 
+//==============================================================================
+// <editor-fold desc="header formats"> {{{1
+
+/// Header format tags for PolymorphicSerializationAdapter.  The wide header
+/// is 24 bytes plus 16 bytes per abstract base, keeping the object's own data
+/// 8-byte aligned.  The compact header is 5 bytes for a type with a single
+/// abstract base, and 1 byte plus 8 bytes per abstract base otherwise, but
+/// identifies types by 32-bit ids, which are more likely to collide (the
+/// registry asserts at startup if they do).  Objects with either header can
+/// be unpacked with PolymorphicSerializableObject<AbstractType>::unpack().
+struct WidePolymorphicHeader { };
+struct CompactPolymorphicHeader { };
+
+// </editor-fold> end header formats }}}1
+//==============================================================================
+
+
 //==============================================================================
 // <editor-fold desc="PolymorphicSerializationAdapter"> {{{1
 
 namespace detail {
 
+template <typename ConcreteT>
+using default_polymorphic_serialization_handler_t =
+  darma::serialization::PointerReferenceSerializationHandler<
+    darma::serialization::SimpleSerializationHandler<std::allocator<ConcreteT>>
+  >;
+
+template <typename ConcreteType, typename HeaderFormat=WidePolymorphicHeader>
+struct polymorphic_serialization_details;
+
 template <typename ConcreteType>
-struct polymorphic_serialization_details {
+struct polymorphic_serialization_details<ConcreteType, WidePolymorphicHeader> {
   template <typename... AbstractBases>
   struct with_abstract_bases {
     static void
     add_registry_frontmatter_in_place(char* buffer) {
-      // add the header
-      new (buffer) SerializedPolymorphicObjectHeader{
-        /* n_bases = */ static_cast<uint8_t>(sizeof...(AbstractBases)),
-        /* unused */ 0ull,
-        /* also unused */ 0ull
-      };
-      // advance the buffer
+      // Objects can be packed at any offset (e.g., right after the presence
+      // flag of a std::unique_ptr), so the header and table are built here
+      // and copied out rather than constructed in the buffer
+      SerializedPolymorphicObjectHeader header;
+      // Zeroed first so that any padding is deterministic too
+      std::memset(&header, 0, sizeof(header));
+      header.n_bases = sizeof...(AbstractBases);
+      std::memcpy(buffer, &header, sizeof(header));
       buffer += sizeof(SerializedPolymorphicObjectHeader);
 
       // add the array of abstract-to-concrete index pairs
-      new (buffer) PolymorphicAbstractBasesTableEntry[sizeof...(AbstractBases)] {
+      PolymorphicAbstractBasesTableEntry const entries[] = {
         PolymorphicAbstractBasesTableEntry{
-          get_abstract_type_index<AbstractBases>(),
+          polymorphic_type_id<AbstractBases>::value(),
           _impl::PolymorphicUnpackRegistrarWrapper<
             AbstractBases,
             ConcreteType
-          >::registrar.index
+          >::registrar.id
         }...
       };
+      std::memcpy(buffer, entries, sizeof(entries));
     }
     static constexpr auto registry_frontmatter_size =
       sizeof(SerializedPolymorphicObjectHeader)
@@ -92,6 +125,50 @@ struct polymorphic_serialization_details {
   };
 };
 
+template <typename ConcreteType>
+struct polymorphic_serialization_details<ConcreteType, CompactPolymorphicHeader> {
+  template <typename... AbstractBases>
+  struct with_abstract_bases {
+    static_assert(sizeof...(AbstractBases) <= max_compact_polymorphic_abstract_bases,
+      "too many abstract bases for CompactPolymorphicHeader"
+    );
+    static constexpr bool single_base = sizeof...(AbstractBases) == 1;
+
+    static void
+    add_registry_frontmatter_in_place(char* buffer) {
+      // add the tag
+      *buffer = static_cast<char>(
+        compact_polymorphic_header_flag | sizeof...(AbstractBases)
+      );
+      ++buffer;
+
+      CompactPolymorphicAbstractBasesTableEntry entries[] = {
+        CompactPolymorphicAbstractBasesTableEntry{
+          compact_polymorphic_type_id(polymorphic_type_id<AbstractBases>::value()),
+          compact_polymorphic_type_id(
+            _impl::PolymorphicUnpackRegistrarWrapper<
+              AbstractBases,
+              ConcreteType
+            >::registrar.id
+          )
+        }...
+      };
+      if(single_base) {
+        // the abstract id is implied
+        std::memcpy(buffer, &entries[0].concrete_id, sizeof(std::uint32_t));
+      }
+      else {
+        std::memcpy(buffer, entries, sizeof(entries));
+      }
+    }
+    static constexpr auto registry_frontmatter_size = 1 + (single_base
+      ? sizeof(std::uint32_t)
+      : sizeof(CompactPolymorphicAbstractBasesTableEntry[sizeof...(AbstractBases)])
+    );
+    using concrete_t = ConcreteType;
+  };
+};
+
 template <typename Details, typename BaseT, typename SerializationHandler>
 struct _polymorphic_serialization_adapter_impl : BaseT {
 
@@ -120,6 +197,14 @@ struct _polymorphic_serialization_adapter_impl : BaseT {
     void pack(char*& buffer) const override {
       polymorphic_details_t::add_registry_frontmatter_in_place(buffer);
       buffer += polymorphic_details_t::registry_frontmatter_size;
+      pack_without_header(buffer);
+    }
+
+    size_t get_packed_header_size() const override {
+      return polymorphic_details_t::registry_frontmatter_size;
+    }
+
+    void pack_without_header(char*& buffer) const override {
       auto ar = serialization_handler_t::make_packing_archive(
         buffer
       );
@@ -129,18 +214,64 @@ struct _polymorphic_serialization_adapter_impl : BaseT {
 
 };
 
+// Allocates a ConcreteT from resource (or with new, if resource is null) and
+// unpacks it there
+template <typename ConcreteT, typename AbstractT, typename SerializationHandler>
+polymorphic_unique_ptr<AbstractT>
+_unpack_polymorphic_object(char const*& buffer, MemoryResource* resource) {
+  using allocator_t = std::allocator<ConcreteT>;
+  allocator_t alloc;
+  void* allocated_spot = resource != nullptr
+    ? resource->allocate(sizeof(ConcreteT), alignof(ConcreteT))
+    : std::allocator_traits<allocator_t>::allocate(alloc, 1);
+
+  auto ar = SerializationHandler::make_unpacking_archive(buffer);
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  try {
+#endif
+    // call the customization point, allow ADL
+    darma_unpack(
+      darma::serialization::allocated_buffer_for<ConcreteT>(allocated_spot), ar
+    );
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  }
+  catch(...) {
+    // If unpack throws, the object was never constructed
+    if(resource != nullptr) {
+      resource->deallocate(allocated_spot, sizeof(ConcreteT), alignof(ConcreteT));
+    }
+    else {
+      std::allocator_traits<allocator_t>::deallocate(
+        alloc, static_cast<ConcreteT*>(allocated_spot), 1
+      );
+    }
+    throw;
+  }
+#endif
+
+  auto* obj = static_cast<ConcreteT*>(allocated_spot);
+  if(resource != nullptr) {
+    return polymorphic_unique_ptr<AbstractT>(obj, PolymorphicDeleter<AbstractT>(
+      *resource, &_destroy_polymorphic_object<ConcreteT, AbstractT>
+    ));
+  }
+  return polymorphic_unique_ptr<AbstractT>(obj);
+}
+
 } // end namespace detail
 
 // Adapter for single abstract base
 template <typename ConcreteT, typename AbstractT, typename BaseT = AbstractT,
   typename SerializationHandler =
-    darma::serialization::PointerReferenceSerializationHandler<
-      darma::serialization::SimpleSerializationHandler<std::allocator<ConcreteT>>
-    >
+    detail::default_polymorphic_serialization_handler_t<ConcreteT>,
+  typename HeaderFormat = WidePolymorphicHeader
 >
 struct PolymorphicSerializationAdapter
   : detail::_polymorphic_serialization_adapter_impl<
-      typename detail::polymorphic_serialization_details<ConcreteT>::template with_abstract_bases<AbstractT>,
+      typename detail::polymorphic_serialization_details<
+        ConcreteT, HeaderFormat
+      >::template with_abstract_bases<AbstractT>,
       BaseT,
       SerializationHandler
     >
@@ -148,7 +279,9 @@ struct PolymorphicSerializationAdapter
   private:
     using serialization_handler_t = SerializationHandler;
     using impl_t = detail::_polymorphic_serialization_adapter_impl<
-      typename detail::polymorphic_serialization_details<ConcreteT>::template with_abstract_bases<AbstractT>,
+      typename detail::polymorphic_serialization_details<
+        ConcreteT, HeaderFormat
+      >::template with_abstract_bases<AbstractT>,
       BaseT,
       serialization_handler_t
     >;
@@ -164,50 +297,35 @@ struct PolymorphicSerializationAdapter
   public:
 
     static
-    std::unique_ptr<AbstractT>
-    _darma_static_polymorphic_serializable_adapter_unpack(char const*& buffer) {
-
-      // TODO ask the abstract object for an allocator? Or allocate some other way?
-      using allocator_t = std::allocator<ConcreteT>;
-      using allocator_traits_t = std::allocator_traits<allocator_t>;
-      allocator_t alloc;
-      void* allocated_spot = std::allocator_traits<allocator_t>::allocate(alloc, 1);
-
-      auto ar = serialization_handler_t::make_unpacking_archive(buffer);
-
-      // call the customization point, allow ADL
-      darma_unpack(
-        darma::serialization::allocated_buffer_for<ConcreteT>(allocated_spot), ar
-      );
-
-      std::unique_ptr<ConcreteT> rv(reinterpret_cast<ConcreteT*>(allocated_spot));
-
-      return std::move(rv);
+    polymorphic_unique_ptr<AbstractT>
+    _darma_static_polymorphic_serializable_adapter_unpack(
+      char const*& buffer, MemoryResource* resource
+    ) {
+      return detail::_unpack_polymorphic_object<
+        ConcreteT, AbstractT, serialization_handler_t
+      >(buffer, resource);
     }
 };
 
 // Adapter for multiple abstract bases
-template <typename ConcreteT, typename BaseT, typename... AbstractTypes>
+template <typename ConcreteT, typename BaseT, typename HeaderFormat, typename... AbstractTypes>
 struct PolymorphicSerializationAdapter<ConcreteT, tinympl::vector<AbstractTypes...>, BaseT,
-  darma::serialization::PointerReferenceSerializationHandler<
-    darma::serialization::SimpleSerializationHandler<std::allocator<ConcreteT>>
-  >
+  detail::default_polymorphic_serialization_handler_t<ConcreteT>, HeaderFormat
 > : detail::_polymorphic_serialization_adapter_impl<
-      typename detail::polymorphic_serialization_details<ConcreteT>::template with_abstract_bases<AbstractTypes...>,
+      typename detail::polymorphic_serialization_details<
+        ConcreteT, HeaderFormat
+      >::template with_abstract_bases<AbstractTypes...>,
       BaseT,
-      darma::serialization::PointerReferenceSerializationHandler<
-        darma::serialization::SimpleSerializationHandler<std::allocator<ConcreteT>>
-      >
+      detail::default_polymorphic_serialization_handler_t<ConcreteT>
     >
 {
   private:
-    using serialization_handler_t = darma::serialization::PointerReferenceSerializationHandler<
-      darma::serialization::SimpleSerializationHandler<std::allocator<ConcreteT>>
-    >;
+    using serialization_handler_t =
+      detail::default_polymorphic_serialization_handler_t<ConcreteT>;
     using impl_t = detail::_polymorphic_serialization_adapter_impl<
-      typename detail::polymorphic_serialization_details<ConcreteT>::template with_abstract_bases<
-        AbstractTypes...
-      >,
+      typename detail::polymorphic_serialization_details<
+        ConcreteT, HeaderFormat
+      >::template with_abstract_bases<AbstractTypes...>,
       BaseT, serialization_handler_t
     >;
 
@@ -228,27 +346,26 @@ struct PolymorphicSerializationAdapter<ConcreteT, tinympl::vector<AbstractTypes.
       >
     >
     static
-    std::unique_ptr<AbstractT>
-    _darma_static_polymorphic_serializable_adapter_unpack_as(char const*& buffer) {
-
-      // TODO ask the abstract object for an allocator? Or allocate some other way?
-      using allocator_t = std::allocator<ConcreteT>;
-      using allocator_traits_t = std::allocator_traits<allocator_t>;
-      allocator_t alloc;
-      void* allocated_spot = std::allocator_traits<allocator_t>::allocate(alloc, 1);
-
-      auto ar = serialization_handler_t::make_unpacking_archive(buffer);
-
-      darma_unpack(
-        darma::serialization::allocated_buffer_for<ConcreteT>(allocated_spot), ar
-      );
-
-      std::unique_ptr<ConcreteT> rv(reinterpret_cast<ConcreteT*>(allocated_spot));
-
-      return std::move(rv);
+    polymorphic_unique_ptr<AbstractT>
+    _darma_static_polymorphic_serializable_adapter_unpack_as(
+      char const*& buffer, MemoryResource* resource
+    ) {
+      return detail::_unpack_polymorphic_object<
+        ConcreteT, AbstractT, serialization_handler_t
+      >(buffer, resource);
     }
 };
 
+/// PolymorphicSerializationAdapter with the default serialization handler and
+/// a CompactPolymorphicHeader.  AbstractT can be a tinympl::vector of abstract
+/// bases, as with PolymorphicSerializationAdapter.
+template <typename ConcreteT, typename AbstractT, typename BaseT = AbstractT>
+using CompactPolymorphicSerializationAdapter = PolymorphicSerializationAdapter<
+  ConcreteT, AbstractT, BaseT,
+  detail::default_polymorphic_serialization_handler_t<ConcreteT>,
+  CompactPolymorphicHeader
+>;
+
 // </editor-fold> end PolymorphicSerializationAdapter }}}1
 //==============================================================================
 
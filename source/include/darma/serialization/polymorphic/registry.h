@@ -45,33 +45,196 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_REGISTRY_H
 #define DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_REGISTRY_H
 
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/polymorphic/memory_resource.h>
+#include <darma/serialization/polymorphic/type_id.h>
+
+#include <darma/utility/darma_assert.h>
+
 #include <tinympl/detection.hpp>
 #include <tinympl/select.hpp>
 
-#include <functional> // function
-#include <vector>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <stdexcept>
+#endif
 
 namespace darma {
 namespace serialization {
 namespace detail {
 
-// TODO this could be sped up a bit in specific cases where certain AbstractBase disallow multiple inheritance for derived types
-
+// resource is nullptr if the object should be allocated with new
 template <typename AbstractBase>
-using abstract_base_unpack_registry =
-  std::vector<
-    std::function<std::unique_ptr<AbstractBase>(char const*& buffer)>
-  >;
-
-template <typename=void>
-size_t&
-get_known_abstract_base_count() {
-  static size_t abstract_base_count = 0;
-  return abstract_base_count;
+using polymorphic_unpack_function_t =
+  polymorphic_unique_ptr<AbstractBase>(*)(char const*& buffer, MemoryResource* resource);
+
+// A bad registration (e.g., two types with the same id) would otherwise unpack
+// objects as the wrong type, so it's an error in every build, not just in
+// debug builds
+[[noreturn]] inline void
+_polymorphic_registration_error(std::string const& message) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  throw std::logic_error(message);
+#else
+  _fatal_error(message);
+#endif
+}
+
+inline void
+_check_polymorphic_id_collision(
+  std::type_info const* registered, std::type_info const& type, char const* id_kind
+) {
+  if(registered != nullptr and *registered != type) {
+    _polymorphic_registration_error(std::string("Polymorphic ") + id_kind
+      + " collision between " + registered->name() + " and " + type.name()
+      + "; specialize polymorphic_type_id to give one of them a different id"
+    );
+  }
 }
 
+// An open-addressing (linear probing) hash table from type id to Function.
+// Entries are only added during static initialization, so lookups don't need
+// to synchronize.
+template <typename Function>
+class _polymorphic_unpack_table {
+  private:
+
+    struct _slot {
+      std::uint64_t id;  // 0 means empty
+      Function function;
+      std::type_info const* type;  // only used to detect id collisions
+    };
+
+    std::vector<_slot> slots_ = std::vector<_slot>(16, _slot{0, nullptr, nullptr});
+    std::size_t size_ = 0;
+
+    static std::size_t _home_slot(std::uint64_t id, std::size_t mask) {
+      // FNV-1a's low bits are reasonably well mixed already; fold in the high
+      // bits anyway in case the id was assigned by hand
+      return static_cast<std::size_t>(id ^ (id >> 32)) & mask;
+    }
+
+    static _slot& _find_slot(std::vector<_slot>& slots, std::uint64_t id) {
+      auto mask = slots.size() - 1;
+      auto i = _home_slot(id, mask);
+      while(slots[i].id != 0 and slots[i].id != id) i = (i + 1) & mask;
+      return slots[i];
+    }
+
+    _slot const* _lookup(std::uint64_t id) const {
+      auto mask = slots_.size() - 1;
+      auto i = _home_slot(id, mask);
+      while(slots_[i].id != id) {
+        if(slots_[i].id == 0) return nullptr;
+        i = (i + 1) & mask;
+      }
+      return &slots_[i];
+    }
+
+  public:
+
+    /// Returns false if id is already registered to type.  Registering it to
+    /// a different type is an error.
+    bool insert(std::uint64_t id, Function function, std::type_info const& type) {
+      if(id == 0) {
+        _polymorphic_registration_error(
+          std::string("Polymorphic type id for ") + type.name() + " is zero"
+        );
+      }
+      // Keep the load factor at or below one half
+      if(2 * (size_ + 1) > slots_.size()) {
+        std::vector<_slot> new_slots(2 * slots_.size(), _slot{0, nullptr, nullptr});
+        for(auto const& slot : slots_) {
+          if(slot.id != 0) _find_slot(new_slots, slot.id) = slot;
+        }
+        slots_.swap(new_slots);
+      }
+      auto& slot = _find_slot(slots_, id);
+      if(slot.id == id) {
+        _check_polymorphic_id_collision(slot.type, type, "type id");
+        return false;
+      }
+      slot = _slot{id, function, &type};
+      ++size_;
+      return true;
+    }
+
+    Function find(std::uint64_t id) const {
+      auto const* slot = _lookup(id);
+      return slot != nullptr ? slot->function : nullptr;
+    }
+
+    /// The type registered for id, or nullptr if there isn't one
+    std::type_info const* find_type(std::uint64_t id) const {
+      auto const* slot = _lookup(id);
+      return slot != nullptr ? slot->type : nullptr;
+    }
+
+    std::size_t size() const { return size_; }
+};
+
+/// The 32-bit id written in place of id by CompactPolymorphicHeader
+inline std::uint32_t
+compact_polymorphic_type_id(std::uint64_t id) {
+  return static_cast<std::uint32_t>(id ^ (id >> 32));
+}
+
+// Maps concrete type ids to the function that unpacks that concrete type as an
+// AbstractBase.  Plain function pointers rather than std::function, so that
+// dispatching an unpack is a single indirect call with no type erasure in
+// between.  Each concrete type is in two tables: one keyed by its full id and
+// one by its compact (32-bit) id.
+template <typename AbstractBase>
+class abstract_base_unpack_registry {
+  public:
+
+    using function_t = polymorphic_unpack_function_t<AbstractBase>;
+
+  private:
+
+    _polymorphic_unpack_table<function_t> by_id_;
+    _polymorphic_unpack_table<function_t> by_compact_id_;
+
+  public:
+
+    /// Returns false if type was already registered (in which case the
+    /// existing entry is kept).  This can happen legitimately, e.g., when a
+    /// shared library and the executable both instantiate the same registrar.
+    /// If id or its compact id is already registered to a different type,
+    /// this is an error (and neither table is changed).
+    bool insert(std::uint64_t id, function_t function, std::type_info const& type) {
+      auto compact_id = compact_polymorphic_type_id(id);
+      if(compact_id == 0) {
+        _polymorphic_registration_error(std::string("Polymorphic type id for ")
+          + type.name() + " has a compact id of zero; specialize"
+          " polymorphic_type_id to give it a different id"
+        );
+      }
+      _check_polymorphic_id_collision(by_id_.find_type(id), type, "type id");
+      _check_polymorphic_id_collision(
+        by_compact_id_.find_type(compact_id), type, "compact type id"
+      );
+      by_compact_id_.insert(compact_id, function, type);
+      return by_id_.insert(id, function, type);
+    }
+
+    /// Returns nullptr if nothing is registered for id
+    function_t find(std::uint64_t id) const { return by_id_.find(id); }
+
+    /// Returns nullptr if nothing is registered for compact_id
+    function_t find_compact(std::uint32_t compact_id) const {
+      return by_compact_id_.find(compact_id);
+    }
+
+    std::size_t size() const { return by_id_.size(); }
+};
+
 template <typename AbstractBase>
 abstract_base_unpack_registry<AbstractBase>&
 get_polymorphic_unpack_registry() {
@@ -79,6 +242,9 @@ get_polymorphic_unpack_registry() {
   return _reg;
 }
 
+//==============================================================================
+// <editor-fold desc="serialized header formats"> {{{1
+
 struct SerializedPolymorphicObjectHeader {
   size_t n_bases;
   // Pad to 128 bits for now to make alignment work out reasonably in the most
@@ -88,40 +254,68 @@ struct SerializedPolymorphicObjectHeader {
 };
 
 struct PolymorphicAbstractBasesTableEntry {
-  size_t abstract_index;
-  size_t concrete_index;
+  std::uint64_t abstract_id;
+  std::uint64_t concrete_id;
 };
 
+// The compact header is a single tag byte, with the high bit set (which the
+// first byte of a SerializedPolymorphicObjectHeader never has, since n_bases
+// is small) and the number of abstract bases in the low bits.  In the common
+// case of a single abstract base the tag is followed by just the 32-bit
+// concrete id; the abstract id is implied by the type the object is unpacked
+// as.  Otherwise, the tag is followed by a table of 32-bit id pairs.  Nothing
+// is aligned, so everything is read with memcpy.
+constexpr std::uint8_t compact_polymorphic_header_flag = 0x80;
+constexpr std::size_t max_compact_polymorphic_abstract_bases = 0x7f;
+
+struct CompactPolymorphicAbstractBasesTableEntry {
+  std::uint32_t abstract_id;
+  std::uint32_t concrete_id;
+};
+
+// </editor-fold> end serialized header formats }}}1
+//==============================================================================
+
 namespace _impl {
 
 //==============================================================================
 // <editor-fold desc="PolymorphicUnpackRegistrar"> {{{1
 
+// The registrars ignore the result of insert(): false only means the type was
+// already registered (e.g., by another shared library), and a registration
+// that collides with a different type fails inside insert() itself, during
+// static initialization.
+
 template <typename AbstractBase, typename ConcreteType, typename Enable=void>
 struct PolymorphicUnpackRegistrar;
 
 //------------------------------------------------------------------------------
 // <editor-fold desc="static unpack detection"> {{{2
 
-// Use longer names in the adapters to avoid collisions with user-defined functions named "unpack"
+// Use longer names in the adapters to avoid collisions with user-defined functions named "unpack".
+// Unlike the user-facing hooks, these allocate from a MemoryResource (if given one).
 template <typename T, typename AbstractBase>
 using _has_static_long_name_unpack_as_archetype = decltype(
-  T::template _darma_static_polymorphic_serializable_adapter_unpack_as<AbstractBase>(std::declval<char const*&>())
+  T::template _darma_static_polymorphic_serializable_adapter_unpack_as<AbstractBase>(
+    std::declval<char const*&>(), std::declval<MemoryResource*>()
+  )
 );
 
 template <typename T, typename AbstractBase>
 using _has_static_long_name_unpack_as = tinympl::is_detected_convertible<
-  std::unique_ptr<AbstractBase>, _has_static_long_name_unpack_as_archetype, T, AbstractBase
+  polymorphic_unique_ptr<AbstractBase>, _has_static_long_name_unpack_as_archetype, T, AbstractBase
 >;
 
 template <typename T>
 using _has_static_long_name_unpack_archetype = decltype(
-  T::_darma_static_polymorphic_serializable_adapter_unpack(std::declval<char const*&>())
+  T::_darma_static_polymorphic_serializable_adapter_unpack(
+    std::declval<char const*&>(), std::declval<MemoryResource*>()
+  )
 );
 
 template <typename T, typename AbstractBase>
 using _has_static_long_name_unpack = tinympl::is_detected_convertible<
-  std::unique_ptr<AbstractBase>, _has_static_long_name_unpack_archetype, T
+  polymorphic_unique_ptr<AbstractBase>, _has_static_long_name_unpack_archetype, T
 >;
 
 template <typename T, typename AbstractBase>
@@ -174,13 +368,14 @@ struct PolymorphicUnpackRegistrar<AbstractBase, ConcreteType,
     ConcreteType, AbstractBase
   >
 >{
-  size_t index;
+  std::uint64_t id = polymorphic_type_id<ConcreteType>::value();
   PolymorphicUnpackRegistrar() {
-    auto& reg = get_polymorphic_unpack_registry<AbstractBase>();
-    index = reg.size();
-    reg.emplace_back([](char const*& buffer) {
-      return ConcreteType::template unpack_as<AbstractBase>(buffer);
-    });
+    get_polymorphic_unpack_registry<AbstractBase>().insert(id, [](char const*& buffer, MemoryResource*) {
+      // User-defined hooks always allocate with new
+      return polymorphic_unique_ptr<AbstractBase>(
+        ConcreteType::template unpack_as<AbstractBase>(buffer).release()
+      );
+    }, typeid(ConcreteType));
   }
 };
 
@@ -191,13 +386,14 @@ struct PolymorphicUnpackRegistrar<AbstractBase, ConcreteType,
     ConcreteType, AbstractBase
   >
 >{
-  size_t index;
+  std::uint64_t id = polymorphic_type_id<ConcreteType>::value();
   PolymorphicUnpackRegistrar() {
-    auto& reg = get_polymorphic_unpack_registry<AbstractBase>();
-    index = reg.size();
-    reg.emplace_back([](char const*& buffer) {
-      return ConcreteType::unpack(buffer);
-    });
+    get_polymorphic_unpack_registry<AbstractBase>().insert(id, [](char const*& buffer, MemoryResource*) {
+      // User-defined hooks always allocate with new
+      return polymorphic_unique_ptr<AbstractBase>(
+        ConcreteType::unpack(buffer).release()
+      );
+    }, typeid(ConcreteType));
   }
 };
 
@@ -208,13 +404,13 @@ struct PolymorphicUnpackRegistrar<AbstractBase, ConcreteType,
     ConcreteType, AbstractBase
   >
 >{
-  size_t index;
+  std::uint64_t id = polymorphic_type_id<ConcreteType>::value();
   PolymorphicUnpackRegistrar() {
-    auto& reg = get_polymorphic_unpack_registry<AbstractBase>();
-    index = reg.size();
-    reg.emplace_back([](char const*& buffer) {
-      return ConcreteType::template _darma_static_polymorphic_serializable_adapter_unpack_as<AbstractBase>(buffer);
-    });
+    get_polymorphic_unpack_registry<AbstractBase>().insert(id, [](char const*& buffer, MemoryResource* resource) {
+      return ConcreteType::template _darma_static_polymorphic_serializable_adapter_unpack_as<AbstractBase>(
+        buffer, resource
+      );
+    }, typeid(ConcreteType));
   }
 };
 
@@ -225,13 +421,13 @@ struct PolymorphicUnpackRegistrar<AbstractBase, ConcreteType,
     ConcreteType, AbstractBase
   >
 >{
-  size_t index;
+  std::uint64_t id = polymorphic_type_id<ConcreteType>::value();
   PolymorphicUnpackRegistrar() {
-    auto& reg = get_polymorphic_unpack_registry<AbstractBase>();
-    index = reg.size();
-    reg.emplace_back([](char const*& buffer) {
-      return ConcreteType::_darma_static_polymorphic_serializable_adapter_unpack(buffer);
-    });
+    get_polymorphic_unpack_registry<AbstractBase>().insert(id, [](char const*& buffer, MemoryResource* resource) {
+      return ConcreteType::_darma_static_polymorphic_serializable_adapter_unpack(
+        buffer, resource
+      );
+    }, typeid(ConcreteType));
   }
 };
 
@@ -248,34 +444,8 @@ PolymorphicUnpackRegistrarWrapper<AbstractBase, ConcreteType>::registrar = { };
 //==============================================================================
 
 
-template <typename AbstractBase>
-struct AbstractBaseRegistrar {
-  size_t index;
-  AbstractBaseRegistrar() {
-    auto& count = get_known_abstract_base_count();
-    index = count;
-    ++count;
-  }
-};
-
-template <typename AbstractBase>
-struct AbstractBaseRegistrarWrapper {
-  static AbstractBaseRegistrar<AbstractBase> registrar;
-};
-
-template <typename AbstractBase>
-AbstractBaseRegistrar<AbstractBase>
-  AbstractBaseRegistrarWrapper<AbstractBase>::registrar = { };
-
 } // end namespace _impl
 
-template <typename AbstractType>
-size_t
-get_abstract_type_index() {
-  return _impl::AbstractBaseRegistrarWrapper<AbstractType>::registrar.index;
-}
-
-
 } // end namespace detail
 } // end namespace serialization
 } // end namespace darma
@@ -0,0 +1,87 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      type_id.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_TYPE_ID_H
+#define DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_TYPE_ID_H
+
+#include <cstdint>
+#include <typeinfo>
+
+namespace darma {
+namespace serialization {
+
+/// 64-bit FNV-1a hash of a null-terminated string.  Usable at compile time,
+/// e.g., to give polymorphic_type_id an explicit name.
+constexpr std::uint64_t
+polymorphic_type_name_hash(char const* name) {
+  std::uint64_t rv = 0xcbf29ce484222325ull;
+  for(; *name != '\0'; ++name) {
+    rv ^= static_cast<std::uint64_t>(static_cast<unsigned char>(*name));
+    rv *= 0x100000001b3ull;
+  }
+  return rv;
+}
+
+/// The id that identifies T (a concrete type or an abstract base) in
+/// serialized polymorphic objects.  Unlike an index handed out during static
+/// initialization, it doesn't depend on the order in which types happen to be
+/// registered, so it's the same in every process that uses the same ABI.
+///
+/// The default hashes the (mangled) name from typeid(T), which isn't stable
+/// across ABIs and isn't meaningful for types with internal linkage.  For
+/// those cases, or to keep ids fixed when a type is renamed, specialize this
+/// with a static value() returning, e.g.,
+/// polymorphic_type_name_hash("my::Type").  Ids must be nonzero.
+template <typename T, typename Enable=void>
+struct polymorphic_type_id {
+  static std::uint64_t value() {
+    static const std::uint64_t rv = polymorphic_type_name_hash(typeid(T).name());
+    return rv;
+  }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_POLYMORPHIC_TYPE_ID_H
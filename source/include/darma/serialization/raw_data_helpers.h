@@ -0,0 +1,251 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      raw_data_helpers.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_RAW_DATA_HELPERS_H
+#define DARMAFRONTEND_SERIALIZATION_RAW_DATA_HELPERS_H
+
+#include <darma/serialization/wire_layout.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+template <typename Archive, typename ContiguousIterator>
+using _typed_add_to_size_raw_archetype = decltype(
+  std::declval<Archive&>().add_to_size_raw(
+    std::declval<ContiguousIterator>(), std::declval<ContiguousIterator>()
+  )
+);
+
+template <typename SizingArchive, typename ContiguousIterator>
+void _add_to_size_raw(
+  SizingArchive& ar, ContiguousIterator begin, ContiguousIterator end,
+  std::true_type /* archive knows about types */
+) {
+  ar.add_to_size_raw(begin, end);
+}
+
+template <typename SizingArchive, typename ContiguousIterator>
+void _add_to_size_raw(
+  SizingArchive& ar, ContiguousIterator begin, ContiguousIterator end,
+  std::false_type /* archive only counts bytes */
+) {
+  using value_type =
+    std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+  ar.add_to_size_raw(std::distance(begin, end) * sizeof(value_type));
+}
+
+template <typename Archive, typename ContiguousIterator>
+using _pack_data_raw_copy_archetype = decltype(
+  std::declval<Archive&>().pack_data_raw_copy(
+    std::declval<ContiguousIterator>(), std::declval<ContiguousIterator>()
+  )
+);
+
+template <typename PackingArchive, typename ContiguousIterator>
+void _pack_data_raw_copy(
+  PackingArchive& ar, ContiguousIterator begin, ContiguousIterator end,
+  std::true_type /* archive might refer to raw data rather than copying it */
+) {
+  ar.pack_data_raw_copy(begin, end);
+}
+
+template <typename PackingArchive, typename ContiguousIterator>
+void _pack_data_raw_copy(
+  PackingArchive& ar, ContiguousIterator begin, ContiguousIterator end,
+  std::false_type /* archive always copies raw data */
+) {
+  ar.pack_data_raw(begin, end);
+}
+
+template <typename Archive, typename RawDataType>
+using _checked_data_raw_count_archetype = decltype(
+  std::declval<Archive&>().template checked_data_raw_count<RawDataType>(
+    std::declval<std::size_t>()
+  )
+);
+
+template <typename RawDataType, typename UnpackingArchive>
+std::size_t _checked_data_raw_count(
+  UnpackingArchive& ar, std::size_t n_items,
+  std::true_type /* archive checks its reads */
+) {
+  return ar.template checked_data_raw_count<RawDataType>(n_items);
+}
+
+template <typename RawDataType, typename UnpackingArchive>
+std::size_t _checked_data_raw_count(
+  UnpackingArchive&, std::size_t n_items,
+  std::false_type /* archive checks its reads */
+) {
+  return n_items;
+}
+
+template <typename Archive>
+using _checked_item_count_archetype = decltype(
+  std::declval<Archive&>().checked_item_count(std::declval<std::size_t>())
+);
+
+template <typename UnpackingArchive>
+std::size_t _checked_item_count(
+  UnpackingArchive& ar, std::size_t n_items,
+  std::true_type /* archive checks its reads */
+) {
+  return ar.checked_item_count(n_items);
+}
+
+template <typename UnpackingArchive>
+std::size_t _checked_item_count(
+  UnpackingArchive&, std::size_t n_items,
+  std::false_type /* archive checks its reads */
+) {
+  return n_items;
+}
+
+template <typename Archive>
+using _unpacking_error_archetype = decltype(
+  static_cast<bool>(std::declval<Archive const&>().error())
+);
+
+template <typename UnpackingArchive>
+bool _unpacking_failed(
+  UnpackingArchive const& ar, std::true_type /* archive reports errors */
+) {
+  return static_cast<bool>(ar.error());
+}
+
+template <typename UnpackingArchive>
+bool _unpacking_failed(
+  UnpackingArchive const&, std::false_type /* archive reports errors */
+) {
+  return false;
+}
+
+} // end namespace detail
+
+/// Account for the raw data in [begin, end) that the pack() counterpart will
+/// give to pack_data_raw(begin, end).  Serializers should use this instead of
+/// ar.add_to_size_raw(n_bytes) for anything other than bytes, so that archives
+/// that align raw data (see AlignedLayout) can add the same padding that
+/// packing will.  Archives that only count bytes work too.
+template <typename SizingArchive, typename ContiguousIterator>
+void add_to_size_raw(
+  SizingArchive& ar, ContiguousIterator begin, ContiguousIterator end
+) {
+  detail::_add_to_size_raw(ar, begin, end,
+    typename tinympl::is_detected<
+      detail::_typed_add_to_size_raw_archetype, SizingArchive, ContiguousIterator
+    >::type{}
+  );
+}
+
+/// Pack raw data that won't outlive the pack() call (e.g., a temporary
+/// buffer).  Some archives (see ScatterGatherPackingArchive) refer to large
+/// raw data given to pack_data_raw() instead of copying it; this makes sure
+/// it's copied.
+template <typename PackingArchive, typename ContiguousIterator>
+void pack_data_raw_copy(
+  PackingArchive& ar, ContiguousIterator begin, ContiguousIterator end
+) {
+  detail::_pack_data_raw_copy(ar, begin, end,
+    typename tinympl::is_detected<
+      detail::_pack_data_raw_copy_archetype, PackingArchive, ContiguousIterator
+    >::type{}
+  );
+}
+
+/// The number of items a serializer should allocate for before giving them to
+/// unpack_data_raw<RawDataType>(dest, n_items), where n_items came from the
+/// buffer (e.g., a size prefix).  Archives that check their reads (see
+/// CheckedUnpackingArchive) report a count that runs past the end of the buffer
+/// here, before anything is allocated for it, and give back 0 if they don't
+/// throw; other archives give back n_items.
+template <typename RawDataType, typename UnpackingArchive>
+std::size_t checked_data_raw_count(UnpackingArchive& ar, std::size_t n_items) {
+  return detail::_checked_data_raw_count<RawDataType>(ar, n_items,
+    typename tinympl::is_detected<
+      detail::_checked_data_raw_count_archetype, UnpackingArchive, RawDataType
+    >::type{}
+  );
+}
+
+/// The number of elements a container serializer should allocate for or loop
+/// over, where n_items came from the buffer (i.e., the container's size
+/// prefix) and every element takes up at least one byte of it.  Archives that
+/// check their reads report a count that's more than the rest of the buffer
+/// could hold, and give back 0 if they don't throw; other archives give back
+/// n_items.
+template <typename UnpackingArchive>
+std::size_t checked_item_count(UnpackingArchive& ar, std::size_t n_items) {
+  return detail::_checked_item_count(ar, n_items,
+    typename tinympl::is_detected<
+      detail::_checked_item_count_archetype, UnpackingArchive
+    >::type{}
+  );
+}
+
+/// Whether an archive that doesn't throw (see CheckedUnpackingArchive) has run
+/// into an error, after which a serializer unpacking a number of elements can
+/// stop early; always false for other archives
+template <typename UnpackingArchive>
+bool unpacking_failed(UnpackingArchive const& ar) {
+  return detail::_unpacking_failed(ar,
+    typename tinympl::is_detected<
+      detail::_unpacking_error_archetype, UnpackingArchive
+    >::type{}
+  );
+}
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_RAW_DATA_HELPERS_H
@@ -0,0 +1,300 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      scatter_gather_archive.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_SCATTER_GATHER_ARCHIVE_H
+#define DARMAFRONTEND_SERIALIZATION_SCATTER_GATHER_ARCHIVE_H
+
+#include <darma/serialization/object_identity.h>
+#include <darma/serialization/serialization_buffer.h>
+#include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/simple_handler_fwd.h>
+#include <darma/serialization/wire_layout.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <sys/uio.h>
+#  define DARMA_SERIALIZATION_HAS_IOVEC 1
+#endif
+
+// Raw data at least this big is referred to rather than copied
+#ifndef DARMA_SERIALIZATION_SCATTER_GATHER_MIN_EXTERNAL_SIZE
+#  define DARMA_SERIALIZATION_SCATTER_GATHER_MIN_EXTERNAL_SIZE 4096
+#endif
+
+namespace darma {
+namespace serialization {
+
+/// A contiguous piece of a ScatterGatherSerializationBuffer
+struct ScatterGatherSegment {
+  void const* data;
+  std::size_t size;
+};
+
+/// The result of packing with a ScatterGatherPackingArchive: a list of
+/// segments which, concatenated, are the same bytes the packing archive of a
+/// SimpleSerializationHandler would have produced.  Some segments are in an
+/// inline buffer owned by this object; the rest point directly at the raw data
+/// of the objects that were packed, so those objects must be alive and
+/// unchanged for as long as the segments are used.
+template <typename Allocator=std::allocator<char>>
+class ScatterGatherSerializationBuffer {
+  public:
+
+    using inline_buffer_t = GrowableSerializationBuffer<Allocator>;
+
+    ScatterGatherSerializationBuffer(
+      inline_buffer_t&& inline_data,
+      std::vector<ScatterGatherSegment>&& segments
+    ) : inline_data_(std::move(inline_data)),
+        segments_(std::move(segments))
+    {
+      for(auto const& segment : segments_) size_ += segment.size;
+    }
+
+    ScatterGatherSerializationBuffer(ScatterGatherSerializationBuffer&&) = default;
+    ScatterGatherSerializationBuffer& operator=(ScatterGatherSerializationBuffer&&) = default;
+
+    std::vector<ScatterGatherSegment> const& segments() const { return segments_; }
+
+    /// Total bytes in all segments
+    std::size_t size() const { return size_; }
+
+    /// Bytes copied into the inline buffer
+    std::size_t inline_size() const { return inline_data_.size(); }
+
+    /// Gather the segments into dest, which must have room for size() bytes
+    void copy_to(void* dest) const {
+      auto* spot = static_cast<char*>(dest);
+      for(auto const& segment : segments_) {
+        std::memcpy(spot, segment.data, segment.size);
+        spot += segment.size;
+      }
+    }
+
+#ifdef DARMA_SERIALIZATION_HAS_IOVEC
+    /// The segments, for writev(), sendmsg(), etc.
+    std::vector<struct iovec> iovecs() const {
+      std::vector<struct iovec> rv(segments_.size());
+      for(std::size_t i = 0; i < segments_.size(); ++i) {
+        rv[i].iov_base = const_cast<void*>(segments_[i].data);
+        rv[i].iov_len = segments_[i].size;
+      }
+      return rv;
+    }
+#endif
+
+  private:
+
+    inline_buffer_t inline_data_;
+    std::vector<ScatterGatherSegment> segments_;
+    std::size_t size_ = 0;
+};
+
+/// A packing archive that copies small raw data into an inline buffer (which
+/// it grows as needed, so no sizing pass is required) but only records where
+/// raw data of at least min_external_size bytes is (e.g., the elements of a
+/// large std::vector<double>), so that vectored I/O can gather it from the
+/// original objects.  Only the packed wire layout is supported.
+///
+/// Raw data smaller than min_external_size_floor is always copied, whatever
+/// min_external_size is: scalars (size prefixes, shared pointer tags, and so
+/// on, in serializers here and elsewhere) are routinely packed from locals and
+/// conversions, which won't be alive when the segments are used.  Serializers
+/// that pack larger temporaries have to use pack_data_raw_copy() rather than
+/// pack_data_raw() for them.
+template <typename Allocator=std::allocator<char>>
+class ScatterGatherPackingArchive {
+  protected:
+
+    using buffer_t = GrowableSerializationBuffer<Allocator>;
+
+    // A segment that's either external or at an offset into the inline buffer
+    // (which can move while packing)
+    struct _segment {
+      void const* external;
+      std::size_t inline_offset;
+      std::size_t size;
+    };
+
+    char* data_spot_ = nullptr;
+    char* data_end_ = nullptr;
+    buffer_t buffer_;
+    std::vector<_segment> segments_;
+    // Where the inline data since the last external segment starts
+    std::size_t inline_begin_ = 0;
+    std::size_t min_external_size_;
+    detail::LazyObjectIdentityTable<detail::PackingObjectIdentityTable> object_identities_;
+
+    ScatterGatherPackingArchive(buffer_t&& buffer, std::size_t min_external_size)
+      : buffer_(std::move(buffer)),
+        min_external_size_(std::max(min_external_size, min_external_size_floor))
+    {
+      data_spot_ = buffer_.data() + buffer_.size();
+      data_end_ = buffer_.data() + buffer_.capacity();
+      inline_begin_ = buffer_.size();
+    }
+
+    std::size_t _inline_offset() const {
+      return static_cast<std::size_t>(data_spot_ - buffer_.data());
+    }
+
+    void _close_inline_segment() {
+      auto offset = _inline_offset();
+      if(offset > inline_begin_) {
+        segments_.push_back({ nullptr, inline_begin_, offset - inline_begin_ });
+      }
+      inline_begin_ = offset;
+    }
+
+    ScatterGatherSerializationBuffer<Allocator> _extract() {
+      _close_inline_segment();
+      buffer_.resize(_inline_offset());
+      data_spot_ = data_end_ = nullptr;  // As part of expiring the Archive
+      std::vector<ScatterGatherSegment> segments;
+      segments.reserve(segments_.size());
+      for(auto const& segment : segments_) {
+        segments.push_back({
+          segment.external != nullptr ?
+            segment.external : buffer_.data() + segment.inline_offset,
+          segment.size
+        });
+      }
+      return ScatterGatherSerializationBuffer<Allocator>(
+        std::move(buffer_), std::move(segments)
+      );
+    }
+
+    template <typename, typename>
+    friend struct SimpleSerializationHandler;
+
+  private:
+
+    template <typename T>
+    inline auto& _ask_serializer_to_pack(T const& obj) & {
+      darma_pack(obj, *this);
+      return *this;
+    }
+
+    void _grow_to_fit(std::size_t additional_size) {
+      auto offset = _inline_offset();
+      buffer_.resize(offset);
+      buffer_.reserve(std::max(2 * buffer_.capacity(), offset + additional_size));
+      data_spot_ = buffer_.data() + offset;
+      data_end_ = buffer_.data() + buffer_.capacity();
+    }
+
+  public:
+
+    // Concept "shortcut" tag
+    using is_packing_archive_t = std::true_type;
+    using is_archive_t = std::true_type;
+
+    using layout_type = PackedLayout;
+
+    /// Larger than any scalar (see above)
+    static constexpr std::size_t min_external_size_floor = 32;
+
+    ScatterGatherPackingArchive(ScatterGatherPackingArchive&&) = default;
+
+    static constexpr bool is_sizing() { return false; }
+    static constexpr bool is_packing() { return true; }
+    static constexpr bool is_unpacking() { return false; }
+
+    template <typename ContiguousIterator>
+    void pack_data_raw(ContiguousIterator begin, ContiguousIterator end) {
+      using value_type =
+        std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+      auto size = static_cast<std::size_t>(std::distance(begin, end)) * sizeof(value_type);
+      if(size >= min_external_size_) {
+        _close_inline_segment();
+        segments_.push_back({ static_cast<void const*>(begin), 0, size });
+      }
+      else {
+        pack_data_raw_copy(begin, end);
+      }
+    }
+
+    /// Always copies, for raw data that won't outlive the packing
+    template <typename ContiguousIterator>
+    void pack_data_raw_copy(ContiguousIterator begin, ContiguousIterator end) {
+      using value_type =
+        std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+      auto size = static_cast<std::size_t>(std::distance(begin, end)) * sizeof(value_type);
+      // empty containers may hand us null pointers, which memcpy doesn't allow
+      if(size == 0) return;
+      if(static_cast<std::size_t>(data_end_ - data_spot_) < size) {
+        _grow_to_fit(size);
+      }
+      std::memcpy(data_spot_, static_cast<void const*>(begin), size);
+      data_spot_ += size;
+    }
+
+    template <typename T>
+    inline auto& operator|(T const& obj) & {
+      return _ask_serializer_to_pack(obj);
+    }
+
+    template <typename T>
+    inline auto& operator<<(T const& obj) & {
+      return _ask_serializer_to_pack(obj);
+    }
+
+    detail::PackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+
+};
+
+template <typename Allocator>
+constexpr std::size_t ScatterGatherPackingArchive<Allocator>::min_external_size_floor;
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_SCATTER_GATHER_ARCHIVE_H
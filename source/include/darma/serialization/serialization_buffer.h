@@ -47,11 +47,18 @@
 
 #include <darma/utility/compressed_pair.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <memory>
 #ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
 #  include <stdexcept>
 #endif
 
+#ifndef DARMA_SERIALIZATION_GROWABLE_BUFFER_INITIAL_CAPACITY
+#  define DARMA_SERIALIZATION_GROWABLE_BUFFER_INITIAL_CAPACITY 256
+#endif
+
 namespace darma {
 namespace serialization {
 
@@ -100,9 +107,12 @@ struct DynamicSerializationBuffer {
     }
 
     DynamicSerializationBuffer& operator=(DynamicSerializationBuffer&& other) {
-      begin_ = other.begin_;
-      end_ = std::move(other.end_);
-      other.begin_ = other.end_.first() = nullptr;
+      if(this != &other) {
+        _deallocate();
+        begin_ = other.begin_;
+        end_ = std::move(other.end_);
+        other.begin_ = other.end_.first() = nullptr;
+      }
       return *this;
     }
 
@@ -114,7 +124,11 @@ struct DynamicSerializationBuffer {
     Allocator& allocator() { return end_.second(); }
     Allocator const& allocator() const { return end_.second(); }
 
-    ~DynamicSerializationBuffer() {
+    ~DynamicSerializationBuffer() { _deallocate(); }
+
+  private:
+
+    void _deallocate() {
       if(begin_ != nullptr) {
         std::allocator_traits<Allocator>::deallocate(
           allocator(), begin_, end_.first() - begin_
@@ -122,10 +136,122 @@ struct DynamicSerializationBuffer {
       }
     }
 
+    // end_ must be first so that the allocator can be used to initialize begin_;
+    darma::utility::compressed_pair<char*, Allocator> end_ = nullptr;
+    char* begin_ = nullptr;
+};
+
+/// A buffer that tracks how many of its bytes are in use and can be grown,
+/// for packing without knowing the packed size ahead of time.  Unlike the other
+/// buffers, size() (the bytes used) and capacity() (the bytes allocated) differ.
+template <typename Allocator=std::allocator<char>>
+struct GrowableSerializationBuffer {
+
+    static_assert(
+      sizeof(typename std::allocator_traits<Allocator>::value_type) == sizeof(char),
+      "Allocator given to GrowableSerializationBuffer must allocate objects of size 1 byte"
+    );
+
+  public:
+
+    explicit
+    GrowableSerializationBuffer(
+      size_t initial_capacity = DARMA_SERIALIZATION_GROWABLE_BUFFER_INITIAL_CAPACITY
+    ) : GrowableSerializationBuffer(initial_capacity, Allocator{})
+    { }
+
+    GrowableSerializationBuffer(
+      size_t initial_capacity,
+      Allocator const& alloc
+    ) : end_(
+          std::piecewise_construct,
+          std::forward_as_tuple(nullptr),
+          std::forward_as_tuple(alloc)
+        )
+    {
+      if(initial_capacity > 0) {
+        begin_ = std::allocator_traits<Allocator>::allocate(
+          allocator(), initial_capacity
+        );
+        end_.first() = begin_ + initial_capacity;
+      }
+    }
+
+    GrowableSerializationBuffer(
+      GrowableSerializationBuffer&& other
+    ) : end_(std::move(other.end_)),
+        begin_(other.begin_),
+        size_(other.size_)
+    {
+      other.begin_ = other.end_.first() = nullptr;
+      other.size_ = 0;
+    }
+
+    GrowableSerializationBuffer& operator=(GrowableSerializationBuffer&& other) {
+      if(this != &other) {
+        _deallocate();
+        begin_ = other.begin_;
+        end_ = std::move(other.end_);
+        size_ = other.size_;
+        other.begin_ = other.end_.first() = nullptr;
+        other.size_ = 0;
+      }
+      return *this;
+    }
+
+    char* data() { return begin_; }
+    char const* data() const { return begin_; }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return end_.first() - begin_; }
+
+    /// Ensure capacity() is at least new_capacity, preserving the first size()
+    /// bytes.  Like std::vector::reserve(), allocates exactly new_capacity
+    /// bytes if it has to reallocate, which invalidates pointers into the
+    /// buffer.
+    void reserve(size_t new_capacity) {
+      if(new_capacity <= capacity()) return;
+      auto* new_begin = std::allocator_traits<Allocator>::allocate(
+        allocator(), new_capacity
+      );
+      if(size_ > 0) std::memcpy(new_begin, begin_, size_);
+      _deallocate();
+      begin_ = new_begin;
+      end_.first() = begin_ + new_capacity;
+    }
+
+    /// Change the number of bytes in use, growing the buffer if necessary.
+    /// Newly used bytes are left uninitialized.  The capacity at least doubles
+    /// when the buffer grows, so growing it a few bytes at a time reallocates
+    /// only a logarithmic number of times.
+    void resize(size_t new_size) {
+      if(new_size > capacity()) {
+        auto const doubled = capacity() <= std::numeric_limits<size_t>::max() / 2 ?
+          2 * capacity() : std::numeric_limits<size_t>::max();
+        reserve(std::max(new_size, doubled));
+      }
+      size_ = new_size;
+    }
+
+    Allocator& allocator() { return end_.second(); }
+    Allocator const& allocator() const { return end_.second(); }
+
+    ~GrowableSerializationBuffer() { _deallocate(); }
+
   private:
+
+    void _deallocate() {
+      if(begin_ != nullptr) {
+        std::allocator_traits<Allocator>::deallocate(
+          allocator(), begin_, end_.first() - begin_
+        );
+      }
+    }
+
     // end_ must be first so that the allocator can be used to initialize begin_;
     darma::utility::compressed_pair<char*, Allocator> end_ = nullptr;
     char* begin_ = nullptr;
+    size_t size_ = 0;
 };
 
 struct NonOwningSerializationBuffer {
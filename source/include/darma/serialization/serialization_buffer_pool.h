@@ -0,0 +1,337 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      serialization_buffer_pool.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_BUFFER_POOL_H
+#define DARMAFRONTEND_SERIALIZATION_BUFFER_POOL_H
+
+#include <darma/serialization/fatal_error.h>
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Buffers are pooled in power-of-two size classes from the min to the max
+// size (inclusive).  Larger requests go straight to operator new/delete.
+#ifndef DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS
+#  define DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS 64
+#endif
+#ifndef DARMA_SERIALIZATION_BUFFER_POOL_MAX_SIZE_CLASS
+#  define DARMA_SERIALIZATION_BUFFER_POOL_MAX_SIZE_CLASS (1 << 20)
+#endif
+// Upper bound on the number of idle buffers kept in each size class
+#ifndef DARMA_SERIALIZATION_BUFFER_POOL_MAX_BUFFERS_PER_SIZE_CLASS
+#  define DARMA_SERIALIZATION_BUFFER_POOL_MAX_BUFFERS_PER_SIZE_CLASS 64
+#endif
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+constexpr std::size_t
+_buffer_pool_n_size_classes(std::size_t min_size, std::size_t max_size) {
+  return min_size >= max_size ? 1 : 1 + _buffer_pool_n_size_classes(min_size * 2, max_size);
+}
+
+} // end namespace detail
+
+/// A thread-safe pool of raw buffers, bucketed by power-of-two size class, so
+/// that serializing many small messages doesn't call malloc and free for every
+/// one.  Buffers are normally obtained through PooledSerializationBufferAllocator,
+/// which is what returns them to the pool when, e.g., the
+/// DynamicSerializationBuffer holding them is destroyed.
+class SerializationBufferPool {
+  private:
+
+    static constexpr std::size_t min_size_class_ = DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS;
+    static constexpr std::size_t max_size_class_ = DARMA_SERIALIZATION_BUFFER_POOL_MAX_SIZE_CLASS;
+
+    static_assert((min_size_class_ & (min_size_class_ - 1)) == 0
+      and (max_size_class_ & (max_size_class_ - 1)) == 0
+      and min_size_class_ <= max_size_class_,
+      "buffer pool size classes must be powers of two, with min <= max"
+    );
+
+    // Critical sections are a handful of instructions, so a spin lock is much
+    // cheaper than a std::mutex here.  The statistics are only modified while
+    // holding the lock, so they can be updated with plain loads and stores
+    // rather than (much more expensive) atomic read-modify-writes; they're
+    // atomic only so that they can be read without the lock.
+    struct _size_class_bucket {
+      std::atomic_flag locked = ATOMIC_FLAG_INIT;
+      std::vector<void*> buffers;
+      std::atomic<std::size_t> hits = { 0 };
+      std::atomic<std::size_t> misses = { 0 };
+      std::atomic<std::size_t> n_retained = { 0 };
+
+      void lock() noexcept {
+        while(locked.test_and_set(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+      }
+      void unlock() noexcept { locked.clear(std::memory_order_release); }
+    };
+
+    static void _increment(std::atomic<std::size_t>& counter) {
+      counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t n_size_classes_ =
+      detail::_buffer_pool_n_size_classes(min_size_class_, max_size_class_);
+
+    _size_class_bucket buckets_[n_size_classes_];
+    std::size_t max_buffers_per_size_class_;
+
+    // Only for allocations that are too big to pool
+    std::atomic<std::size_t> unpooled_misses_ = { 0 };
+
+    static std::size_t _size_class_index(std::size_t size) {
+      std::size_t idx = 0;
+      for(auto class_size = min_size_class_; class_size < size; class_size *= 2) {
+        ++idx;
+      }
+      return idx;
+    }
+
+    static std::size_t _size_of_class(std::size_t idx) {
+      return min_size_class_ << idx;
+    }
+
+  public:
+
+    explicit
+    SerializationBufferPool(
+      std::size_t max_buffers_per_size_class = DARMA_SERIALIZATION_BUFFER_POOL_MAX_BUFFERS_PER_SIZE_CLASS
+    ) : max_buffers_per_size_class_(max_buffers_per_size_class)
+    {
+      // Reserve up front so that deallocate() never has to allocate
+      for(auto& bucket : buckets_) {
+        bucket.buffers.reserve(max_buffers_per_size_class_);
+      }
+    }
+
+    SerializationBufferPool(SerializationBufferPool const&) = delete;
+    SerializationBufferPool& operator=(SerializationBufferPool const&) = delete;
+
+    /// The pool used by default-constructed PooledSerializationBufferAllocators.
+    /// It is never destroyed, so that buffers in static objects that are
+    /// destroyed after it would have been can still be given back to it.
+    static SerializationBufferPool& global() {
+      static auto* pool = new SerializationBufferPool;
+      return *pool;
+    }
+
+    void* allocate(std::size_t size) {
+      if(size > max_size_class_) {
+        unpooled_misses_.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+      }
+      auto idx = _size_class_index(size);
+      auto& bucket = buckets_[idx];
+      {
+        std::lock_guard<_size_class_bucket> lock(bucket);
+        if(not bucket.buffers.empty()) {
+          auto* rv = bucket.buffers.back();
+          bucket.buffers.pop_back();
+          _increment(bucket.hits);
+          bucket.n_retained.store(bucket.buffers.size(), std::memory_order_relaxed);
+          return rv;
+        }
+        _increment(bucket.misses);
+      }
+      return ::operator new(_size_of_class(idx));
+    }
+
+    /// size must be the same as the size given to allocate()
+    void deallocate(void* ptr, std::size_t size) noexcept {
+      if(size <= max_size_class_) {
+        auto& bucket = buckets_[_size_class_index(size)];
+        std::lock_guard<_size_class_bucket> lock(bucket);
+        if(bucket.buffers.size() < max_buffers_per_size_class_) {
+          bucket.buffers.push_back(ptr);
+          bucket.n_retained.store(bucket.buffers.size(), std::memory_order_relaxed);
+          return;
+        }
+      }
+      ::operator delete(ptr);
+    }
+
+    /// Free all idle buffers held by the pool
+    void release() noexcept {
+      for(auto& bucket : buckets_) {
+        std::lock_guard<_size_class_bucket> lock(bucket);
+        for(auto* ptr : bucket.buffers) ::operator delete(ptr);
+        bucket.buffers.clear();
+        bucket.n_retained.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    //==========================================================================
+    // <editor-fold desc="statistics"> {{{1
+
+    /// Allocations satisfied with a buffer from the pool
+    std::size_t hits() const {
+      std::size_t rv = 0;
+      for(auto& bucket : buckets_) rv += bucket.hits.load(std::memory_order_relaxed);
+      return rv;
+    }
+
+    /// Allocations that had to go to operator new
+    std::size_t misses() const {
+      auto rv = unpooled_misses_.load(std::memory_order_relaxed);
+      for(auto& bucket : buckets_) rv += bucket.misses.load(std::memory_order_relaxed);
+      return rv;
+    }
+
+    double hit_rate() const {
+      auto h = hits(), m = misses();
+      return h + m == 0 ? 0.0 : static_cast<double>(h) / (h + m);
+    }
+
+    /// Bytes held in idle buffers (counted by size class, not requested size)
+    std::size_t bytes_retained() const {
+      std::size_t rv = 0;
+      for(std::size_t idx = 0; idx < n_size_classes_; ++idx) {
+        rv += buckets_[idx].n_retained.load(std::memory_order_relaxed)
+          * _size_of_class(idx);
+      }
+      return rv;
+    }
+
+    void reset_statistics() {
+      for(auto& bucket : buckets_) {
+        std::lock_guard<_size_class_bucket> lock(bucket);
+        bucket.hits.store(0, std::memory_order_relaxed);
+        bucket.misses.store(0, std::memory_order_relaxed);
+      }
+      unpooled_misses_.store(0, std::memory_order_relaxed);
+    }
+
+    // </editor-fold> end statistics }}}1
+    //==========================================================================
+
+    ~SerializationBufferPool() { release(); }
+};
+
+/// An allocator that draws from a SerializationBufferPool (the global pool
+/// unless otherwise given).  Use SimpleSerializationHandler<
+/// PooledSerializationBufferAllocator<>> (or serialize_with_allocator() for a
+/// specific pool) to have serialize() reuse buffers.
+template <typename T=char>
+class PooledSerializationBufferAllocator {
+  public:
+
+    using value_type = T;
+
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    PooledSerializationBufferAllocator() noexcept
+      : pool_(&SerializationBufferPool::global())
+    { }
+
+    explicit
+    PooledSerializationBufferAllocator(SerializationBufferPool& pool) noexcept
+      : pool_(&pool)
+    { }
+
+    template <typename U>
+    PooledSerializationBufferAllocator(
+      PooledSerializationBufferAllocator<U> const& other
+    ) noexcept : pool_(other.pool_)
+    { }
+
+    T* allocate(std::size_t n) {
+      static_assert(alignof(T) <= alignof(std::max_align_t),
+        "PooledSerializationBufferAllocator doesn't support over-aligned types"
+      );
+      // sizeof(T) * n would wrap around to a small block that then overruns
+      if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+        throw std::bad_alloc();
+#else
+        detail::_fatal_error("pooled buffer allocation is too large");
+#endif
+      }
+      return static_cast<T*>(pool_->allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept {
+      // Nothing that big was ever handed out
+      if(n > std::numeric_limits<std::size_t>::max() / sizeof(T)) return;
+      pool_->deallocate(ptr, sizeof(T) * n);
+    }
+
+    SerializationBufferPool& pool() const { return *pool_; }
+
+    template <typename U>
+    bool operator==(PooledSerializationBufferAllocator<U> const& other) const {
+      return pool_ == other.pool_;
+    }
+
+    template <typename U>
+    bool operator!=(PooledSerializationBufferAllocator<U> const& other) const {
+      return pool_ != other.pool_;
+    }
+
+  private:
+
+    template <typename>
+    friend class PooledSerializationBufferAllocator;
+
+    SerializationBufferPool* pool_;
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_BUFFER_POOL_H
@@ -50,6 +50,7 @@ namespace serialization {
 
 template <typename T> struct Serializer;
 template <typename T, typename Enable=void> struct Serializer_enabled_if;
+template <typename T, typename Enable=void> struct ViewDeserializer;
 
 } // end namespace serialization
 } // end namespace darma
@@ -52,10 +52,14 @@
 
 #include <darma/serialization/serializers/standard_library/map.h>
 #include <darma/serialization/serializers/standard_library/set.h>
+#include <darma/serialization/serializers/standard_library/shared_ptr.h>
 #include <darma/serialization/serializers/standard_library/string.h>
 #include <darma/serialization/serializers/standard_library/vector.h>
 #include <darma/serialization/serializers/standard_library/pair.h>
 #include <darma/serialization/serializers/standard_library/tuple.h>
 #include <darma/serialization/serializers/standard_library/list.h>
+#include <darma/serialization/serializers/standard_library/unordered_map.h>
+#include <darma/serialization/serializers/standard_library/unordered_set.h>
+#include <darma/serialization/serializers/standard_library/unique_ptr.h>
 
 #endif //DARMAFRONTEND_SERIALIZATION_SERIALIZERS_ALL_H
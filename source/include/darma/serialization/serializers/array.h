@@ -45,8 +45,10 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_ARRAY_H
 #define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_ARRAY_H
 
+#include <darma/serialization/byte_order.h>
 #include <darma/serialization/nonintrusive.h>
 #include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/views.h>
 #include <cstdint>
 
 namespace darma {
@@ -55,6 +57,13 @@ namespace serialization {
 template <typename T, size_t N>
 struct is_directly_serializable<T[N]> : is_directly_serializable<T> { };
 
+template <typename T, size_t N>
+struct byte_swap_traits<T[N], std::enable_if_t<detail::is_byte_swappable<T>::value>> {
+  static void copy_swapped(void* dest, void const* src, std::size_t n_items) {
+    byte_swap_traits<T>::copy_swapped(dest, src, n_items * N);
+  }
+};
+
 // Directly serializable T specialization of T[N]  (This is an
 // optimization for performance purposes only)
 // This should just use the direct serializer; no need to give it here as well
@@ -109,6 +118,20 @@ struct Serializer_enabled_if<
   }
 };
 
+// Directly serializable T[N] is packed as N raw T's, so it can be read in place
+template <typename T, size_t N>
+struct ViewDeserializer<
+  T[N], std::enable_if_t<is_directly_serializable<T>::value>
+>
+{
+  using view_type = ArrayView<T>;
+
+  template <typename UnpackingArchive>
+  static view_type unpack_view(UnpackingArchive& ar) {
+    return view_type(ar.template view_data_raw<T>(N), N);
+  }
+};
+
 } // end namespace serialization
 } // end namespace darma
 
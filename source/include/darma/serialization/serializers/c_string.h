@@ -45,14 +45,14 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_C_STRING_H
 #define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_C_STRING_H
 
-namespace darma {
-namespace serialization {
-
 #include <darma/serialization/nonintrusive.h>
 #include <darma/serialization/serialization_traits.h>
 #include <cstring>
 #include <type_traits>
 
+namespace darma {
+namespace serialization {
+
 template <>
 struct is_directly_serializable<char const*> : std::false_type { };
 
@@ -45,39 +45,39 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_LIST_H
 #define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_LIST_H
 
+#include <darma/serialization/integer_encoding.h>
 #include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
 #include <darma/serialization/serialization_traits.h>
 
 #include <list>
 
-// TODO serialization of non-standard allocators
-
 namespace darma {
 namespace serialization {
 
-template <typename T, typename Archive>
-struct is_sizable_with_archive<std::list<T>, Archive>
+template <typename T, typename Allocator, typename Archive>
+struct is_sizable_with_archive<std::list<T, Allocator>, Archive>
   : is_sizable_with_archive<T, Archive>
 { };
 
-template <typename T, typename Archive>
-struct is_packable_with_archive<std::list<T>, Archive>
+template <typename T, typename Allocator, typename Archive>
+struct is_packable_with_archive<std::list<T, Allocator>, Archive>
   : is_packable_with_archive<T, Archive>
 { };
 
-template <typename T, typename Archive>
-struct is_unpackable_with_archive<std::list<T>, Archive>
+template <typename T, typename Allocator, typename Archive>
+struct is_unpackable_with_archive<std::list<T, Allocator>, Archive>
   : is_unpackable_with_archive<T, Archive>
 { };
 
-template <typename T>
-struct Serializer<std::list<T>> {
+template <typename T, typename Allocator>
+struct Serializer<std::list<T, Allocator>> {
 
-  using list_t = std::list<T>;
+  using list_t = std::list<T, Allocator>;
 
   template <typename SizingArchive>
   static void compute_size(list_t const& obj, SizingArchive& ar) {
-    ar | obj.size();
+    add_size_prefix_to_size(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -85,7 +85,7 @@ struct Serializer<std::list<T>> {
 
   template <typename Archive>
   static void pack(list_t const& obj, Archive& ar) {
-    ar | obj.size();
+    pack_size_prefix(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -93,11 +93,31 @@ struct Serializer<std::list<T>> {
 
   template <typename Archive>
   static void unpack(void* allocated, Archive& ar) {
-    auto size = ar.template unpack_next_item_as<typename list_t::size_type>();
+    auto size = checked_item_count(ar,
+      unpack_size_prefix<typename list_t::size_type>(ar)
+    );
     auto& obj = *(new (allocated) list_t(
       ar.template get_allocator_as<typename list_t::allocator_type>())
     );
-    for(int64_t i = 0; i < size; ++i) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      _unpack_elements(obj, size, ar);
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~list_t();
+      throw;
+    }
+#else
+    _unpack_elements(obj, size, ar);
+#endif
+  }
+
+  template <typename Archive>
+  static void _unpack_elements(
+    list_t& obj, typename list_t::size_type size, Archive& ar
+  ) {
+    for(typename list_t::size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
       obj.emplace_back(ar.template unpack_next_item_as<T>());
     }
   }
@@ -48,36 +48,38 @@
 #include <darma/serialization/serializers/const.h>
 #include <darma/serialization/serializers/standard_library/pair.h>
 
+#include <darma/serialization/integer_encoding.h>
 #include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
 #include <darma/serialization/serialization_traits.h>
 
 #include <map>
 
-// TODO stateful compare? stateful allocators?
+// TODO stateful compare?
 
 namespace darma {
 namespace serialization {
 
 //==============================================================================
 
-template <typename Key, typename T, typename Compare, typename Archive>
-struct is_sizable_with_archive<std::map<Key, T, Compare>, Archive>
+template <typename Key, typename T, typename Compare, typename Allocator, typename Archive>
+struct is_sizable_with_archive<std::map<Key, T, Compare, Allocator>, Archive>
   : tinympl::and_<
       is_sizable_with_archive<std::pair<Key const, T>, Archive>,
       std::is_empty<Compare>, std::is_trivially_copyable<Compare>
     >
 { };
 
-template <typename Key, typename T, typename Compare, typename Archive>
-struct is_packable_with_archive<std::map<Key, T, Compare>, Archive>
+template <typename Key, typename T, typename Compare, typename Allocator, typename Archive>
+struct is_packable_with_archive<std::map<Key, T, Compare, Allocator>, Archive>
   : tinympl::and_<
       is_packable_with_archive<std::pair<Key const, T>, Archive>,
       std::is_empty<Compare>, std::is_trivially_copyable<Compare>
     >
 { };
 
-template <typename Key, typename T, typename Compare, typename Archive>
-struct is_unpackable_with_archive<std::map<Key, T, Compare>, Archive>
+template <typename Key, typename T, typename Compare, typename Allocator, typename Archive>
+struct is_unpackable_with_archive<std::map<Key, T, Compare, Allocator>, Archive>
   : tinympl::and_<
       is_unpackable_with_archive<std::pair<Key const, T>, Archive>,
       std::is_empty<Compare>, std::is_trivially_copyable<Compare>
@@ -86,13 +88,13 @@ struct is_unpackable_with_archive<std::map<Key, T, Compare>, Archive>
 
 //==============================================================================
 
-template <typename Key, typename T, typename Compare>
-struct Serializer<std::map<Key, T, Compare>> {
-  using map_t = std::map<Key, T, Compare>;
+template <typename Key, typename T, typename Compare, typename Allocator>
+struct Serializer<std::map<Key, T, Compare, Allocator>> {
+  using map_t = std::map<Key, T, Compare, Allocator>;
 
   template <typename Archive>
   static void compute_size(map_t const& obj, Archive& ar) {
-    ar | obj.size();
+    add_size_prefix_to_size(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -100,7 +102,7 @@ struct Serializer<std::map<Key, T, Compare>> {
 
   template <typename Archive>
   static void pack(map_t const& obj, Archive& ar) {
-    ar | obj.size();
+    pack_size_prefix(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -108,10 +110,37 @@ struct Serializer<std::map<Key, T, Compare>> {
 
   template <typename Archive>
   static void unpack(void* allocated, Archive& ar) {
-    auto size = ar.template unpack_next_item_as<typename map_t::size_type>();
-    auto& obj = *(new (allocated) map_t());
-    for(int64_t i = 0; i < size; ++i) {
-      obj.emplace(ar.template unpack_next_item_as<std::pair<Key const, T>>());
+    auto size = checked_item_count(ar,
+      unpack_size_prefix<typename map_t::size_type>(ar)
+    );
+    auto& obj = *(new (allocated) map_t(
+      ar.template get_allocator_as<typename map_t::allocator_type>()
+    ));
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      _unpack_elements(obj, size, ar);
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~map_t();
+      throw;
+    }
+#else
+    _unpack_elements(obj, size, ar);
+#endif
+  }
+
+  template <typename Archive>
+  static void _unpack_elements(
+    map_t& obj, typename map_t::size_type size, Archive& ar
+  ) {
+    // Elements were packed in iteration order, so each one goes at the end.
+    // With an end hint, the insert is amortized constant time instead of a
+    // full O(log n) descent from the root
+    for(typename map_t::size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
+      obj.emplace_hint(obj.end(),
+        ar.template unpack_next_item_as<std::pair<Key const, T>>()
+      );
     }
   }
 
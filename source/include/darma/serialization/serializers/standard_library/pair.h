@@ -45,11 +45,14 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_PAIR_H
 #define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_PAIR_H
 
+#include <darma/serialization/byte_order.h>
 #include <darma/serialization/nonintrusive.h>
 #include <darma/serialization/serialization_traits.h>
 
 #include <darma/serialization/serializers/const.h>
 
+#include <cstring>
+#include <type_traits>
 #include <utility>
 
 namespace darma {
@@ -89,6 +92,39 @@ struct is_directly_serializable<std::pair<T, U>>
     >
 { };
 
+template <typename T, typename U>
+struct byte_swap_traits<std::pair<T, U>,
+  std::enable_if_t<
+    detail::is_byte_swappable<std::remove_const_t<T>>::value
+      and detail::is_byte_swappable<std::remove_const_t<U>>::value
+  >
+> {
+  static void copy_swapped(void* dest, void const* src, std::size_t n_items) {
+    using pair_t = std::pair<T, U>;
+    using storage_t = std::aligned_storage_t<sizeof(pair_t), alignof(pair_t)>;
+    // The wire side can be at any offset (see PortableLayout), so each pair is
+    // swapped between aligned copies.  Copying the whole pair first carries
+    // any padding along with it.
+    storage_t in, out;
+    auto const& in_pair = *reinterpret_cast<pair_t const*>(&in);
+    auto& out_pair = *reinterpret_cast<pair_t*>(&out);
+    // (The const_casts are for const members, which are still being initialized)
+    for(std::size_t i = 0; i < n_items; ++i) {
+      std::memcpy(&in, static_cast<char const*>(src) + i * sizeof(pair_t), sizeof(pair_t));
+      std::memcpy(&out, &in, sizeof(pair_t));
+      byte_swap_traits<std::remove_const_t<T>>::copy_swapped(
+        const_cast<void*>(static_cast<void const*>(&out_pair.first)),
+        &in_pair.first, 1
+      );
+      byte_swap_traits<std::remove_const_t<U>>::copy_swapped(
+        const_cast<void*>(static_cast<void const*>(&out_pair.second)),
+        &in_pair.second, 1
+      );
+      std::memcpy(static_cast<char*>(dest) + i * sizeof(pair_t), &out, sizeof(pair_t));
+    }
+  }
+};
+
 //==============================================================================
 
 // Only need to implement the non-directly-serializable version, since the
@@ -101,13 +137,16 @@ struct Serializer_enabled_if<
 {
   using pair_t = std::pair<T, U>;
 
-  template <typename Archive>
-  static void compute_size(pair_t const& obj, Archive& ar) {
+  // Templated on the pair so that the std::pair<T const, U> (etc.)
+  // specializations below don't convert (i.e., copy) their argument to a
+  // pair_t first
+  template <typename PairT, typename Archive>
+  static void compute_size(PairT const& obj, Archive& ar) {
     ar % obj.first % obj.second;
   }
 
-  template <typename Archive>
-  static void pack(pair_t const& obj, Archive& ar) {
+  template <typename PairT, typename Archive>
+  static void pack(PairT const& obj, Archive& ar) {
     ar << obj.first << obj.second;
   }
 
@@ -117,7 +156,19 @@ struct Serializer_enabled_if<
     // it's faster and it works with every implementation I've ever heard of
     auto* obj_ptr = static_cast<pair_t*>(allocated);
     ar.template unpack_next_item_at<T>(&obj_ptr->first);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      ar.template unpack_next_item_at<U>(&obj_ptr->second);
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      using first_t = std::remove_const_t<T>;
+      const_cast<first_t*>(&obj_ptr->first)->~first_t();
+      throw;
+    }
+#else
     ar.template unpack_next_item_at<U>(&obj_ptr->second);
+#endif
   }
 };
 
@@ -47,36 +47,38 @@
 
 #include <darma/serialization/serializers/const.h>
 
+#include <darma/serialization/integer_encoding.h>
 #include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
 #include <darma/serialization/serialization_traits.h>
 
 #include <set>
 
-// TODO stateful compare? stateful allocators?
+// TODO stateful compare?
 
 namespace darma {
 namespace serialization {
 
 //==============================================================================
 
-template <typename Key, typename Compare, typename Archive>
-struct is_sizable_with_archive<std::set<Key, Compare>, Archive>
+template <typename Key, typename Compare, typename Allocator, typename Archive>
+struct is_sizable_with_archive<std::set<Key, Compare, Allocator>, Archive>
   : tinympl::and_<
       is_sizable_with_archive<Key, Archive>,
       std::is_empty<Compare>, std::is_trivially_copyable<Compare>
     >
 { };
 
-template <typename Key, typename Compare, typename Archive>
-struct is_packable_with_archive<std::set<Key, Compare>, Archive>
+template <typename Key, typename Compare, typename Allocator, typename Archive>
+struct is_packable_with_archive<std::set<Key, Compare, Allocator>, Archive>
 : tinympl::and_<
   is_packable_with_archive<Key, Archive>,
 std::is_empty<Compare>, std::is_trivially_copyable<Compare>
 >
 { };
 
-template <typename Key, typename Compare, typename Archive>
-struct is_unpackable_with_archive<std::set<Key, Compare>, Archive>
+template <typename Key, typename Compare, typename Allocator, typename Archive>
+struct is_unpackable_with_archive<std::set<Key, Compare, Allocator>, Archive>
   : tinympl::and_<
       is_unpackable_with_archive<Key, Archive>,
       std::is_empty<Compare>, std::is_trivially_copyable<Compare>
@@ -85,13 +87,13 @@ struct is_unpackable_with_archive<std::set<Key, Compare>, Archive>
 
 //==============================================================================
 
-template <typename Key, typename Compare>
-struct Serializer<std::set<Key, Compare>> {
-  using set_t = std::set<Key, Compare>;
+template <typename Key, typename Compare, typename Allocator>
+struct Serializer<std::set<Key, Compare, Allocator>> {
+  using set_t = std::set<Key, Compare, Allocator>;
 
   template <typename Archive>
   static void compute_size(set_t const& obj, Archive& ar) {
-    ar | obj.size();
+    add_size_prefix_to_size(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -99,7 +101,7 @@ struct Serializer<std::set<Key, Compare>> {
 
   template <typename Archive>
   static void pack(set_t const& obj, Archive& ar) {
-    ar | obj.size();
+    pack_size_prefix(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -107,10 +109,33 @@ struct Serializer<std::set<Key, Compare>> {
 
   template <typename Archive>
   static void unpack(void* allocated, Archive& ar) {
-    auto size = ar.template unpack_next_item_as<typename set_t::size_type>();
-    auto& obj = *(new (allocated) set_t());
-    for(int64_t i = 0; i < size; ++i) {
-      obj.emplace(ar.template unpack_next_item_as<Key>());
+    auto size = checked_item_count(ar,
+      unpack_size_prefix<typename set_t::size_type>(ar)
+    );
+    auto& obj = *(new (allocated) set_t(
+      ar.template get_allocator_as<typename set_t::allocator_type>()
+    ));
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      _unpack_elements(obj, size, ar);
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~set_t();
+      throw;
+    }
+#else
+    _unpack_elements(obj, size, ar);
+#endif
+  }
+
+  template <typename Archive>
+  static void _unpack_elements(
+    set_t& obj, typename set_t::size_type size, Archive& ar
+  ) {
+    // Packed in sorted order; see the std::map serializer for why we hint
+    for(typename set_t::size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
+      obj.emplace_hint(obj.end(), ar.template unpack_next_item_as<Key>());
     }
   }
 
@@ -0,0 +1,195 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      shared_ptr.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_SHARED_PTR_H
+#define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_SHARED_PTR_H
+
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/object_identity.h>
+#include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/serializers/standard_library/unique_ptr.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+// Each shared pointer is packed as a tag, followed by the object it points to
+// only the first time that object is seen; later pointers to the same object
+// refer back to it by id (see PackingObjectIdentityTable)
+struct _shared_pointer_tag {
+  static constexpr std::size_t null = 0;
+  static constexpr std::size_t new_object = 1;
+  static constexpr std::size_t first_back_reference = 2;
+};
+
+template <typename T, typename Archive>
+std::size_t _shared_pointer_tag_for(T const* ptr, Archive& ar) {
+  if(ptr == nullptr) return _shared_pointer_tag::null;
+  auto id_and_inserted = ar.object_identities().insert(
+    static_cast<void const*>(ptr), std::type_index(typeid(T))
+  );
+  if(id_and_inserted.second) return _shared_pointer_tag::new_object;
+  return _shared_pointer_tag::first_back_reference + id_and_inserted.first;
+}
+
+template <typename Archive>
+using _report_invalid_object_reference_archetype = decltype(
+  std::declval<Archive&>().report_invalid_object_reference()
+);
+
+template <typename UnpackingArchive>
+void _invalid_object_reference(
+  UnpackingArchive& ar, std::true_type /* archive reports errors */
+) {
+  ar.report_invalid_object_reference();
+}
+
+template <typename UnpackingArchive>
+void _invalid_object_reference(
+  UnpackingArchive&, std::false_type /* archive reports errors */
+) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  throw std::runtime_error(
+    "shared pointer refers back to an object that can't be unpacked there"
+  );
+#else
+  _fatal_error("shared pointer refers back to an object that can't be unpacked there");
+#endif
+}
+
+} // end namespace detail
+
+/// Objects pointed to by more than one std::shared_ptr (with the same static
+/// type) are packed once, and the sharing is restored when they're unpacked.
+/// Cyclic references can't be unpacked; break cycles with std::weak_ptr.  A
+/// reference back to an object that hasn't been unpacked (or was unpacked as
+/// another type) is reported through a CheckedUnpackingArchive's error(), and
+/// otherwise throws a std::runtime_error.
+template <typename T>
+struct Serializer<std::shared_ptr<T>> {
+  using value_t = std::remove_const_t<T>;
+  using pointee_serializer_t = detail::_pointee_serializer<value_t>;
+  using tag_t = detail::_shared_pointer_tag;
+
+  template <typename SizingArchive>
+  static void compute_size(std::shared_ptr<T> const& obj, SizingArchive& ar) {
+    auto tag = detail::_shared_pointer_tag_for(obj.get(), ar);
+    ar | tag;
+    if(tag == tag_t::new_object) pointee_serializer_t::compute_size(*obj, ar);
+  }
+
+  template <typename Archive>
+  static void pack(std::shared_ptr<T> const& obj, Archive& ar) {
+    auto tag = detail::_shared_pointer_tag_for(obj.get(), ar);
+    ar | tag;
+    if(tag == tag_t::new_object) pointee_serializer_t::pack(*obj, ar);
+  }
+
+  template <typename Archive>
+  static std::shared_ptr<T> _unpack_pointer(Archive& ar) {
+    auto tag = ar.template unpack_next_item_as<std::size_t>();
+    if(tag == tag_t::null) return nullptr;
+    auto& identities = ar.object_identities();
+    if(tag == tag_t::new_object) {
+      auto id = identities.reserve_next(std::type_index(typeid(value_t)));
+      std::shared_ptr<value_t> rv(pointee_serializer_t::unpack(ar));
+      identities.set(id, rv);
+      return rv;
+    }
+    auto const* found = identities.find(
+      tag - tag_t::first_back_reference, std::type_index(typeid(value_t))
+    );
+    if(found == nullptr) {
+      detail::_invalid_object_reference(ar, typename tinympl::is_detected<
+        detail::_report_invalid_object_reference_archetype, Archive
+      >::type{});
+      return nullptr;
+    }
+    return std::static_pointer_cast<value_t>(*found);
+  }
+
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    new (allocated) std::shared_ptr<T>(_unpack_pointer(ar));
+  }
+};
+
+/// Packed as the std::shared_ptr it locks to (so an expired pointer is
+/// packed as null).  After unpacking, the object stays alive only if some
+/// std::shared_ptr unpacked along with it refers to it.
+template <typename T>
+struct Serializer<std::weak_ptr<T>> {
+  using shared_serializer_t = Serializer<std::shared_ptr<T>>;
+
+  template <typename SizingArchive>
+  static void compute_size(std::weak_ptr<T> const& obj, SizingArchive& ar) {
+    shared_serializer_t::compute_size(obj.lock(), ar);
+  }
+
+  template <typename Archive>
+  static void pack(std::weak_ptr<T> const& obj, Archive& ar) {
+    shared_serializer_t::pack(obj.lock(), ar);
+  }
+
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    new (allocated) std::weak_ptr<T>(shared_serializer_t::_unpack_pointer(ar));
+  }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_SHARED_PTR_H
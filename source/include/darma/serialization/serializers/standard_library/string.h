@@ -45,55 +45,75 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_STRING_H
 #define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_STRING_H
 
+#include <darma/serialization/integer_encoding.h>
 #include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
 #include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/views.h>
 
 #include <darma/serialization/serializers/arithmetic_types.h>
 
 #include <string>
 
-#ifndef DARMA_SERIALIZATION_STRING_UNPACK_MAX_STACK_ALLOCATION
+#ifndef DARMA_SERIALIZATION_STRING_UNPACK_STACK_ALLOCATION_MAX
 #  define DARMA_SERIALIZATION_STRING_UNPACK_STACK_ALLOCATION_MAX 1024
 #endif
 
 namespace darma {
 namespace serialization {
 
-// TODO strings with non-standard/non-empty allocators ?
 // TODO make a specialization of unpack takes advantage of the fact that (most) output archives can provide an iterator
 
 //==============================================================================
 
-template <typename CharT, typename Traits>
-struct Serializer<std::basic_string<CharT, Traits>> {
+template <typename CharT, typename Traits, typename Allocator>
+struct Serializer<std::basic_string<CharT, Traits, Allocator>> {
 
   static_assert(is_directly_serializable<CharT>::value,
     "CharT of std::basic_string must be directly serializable"
   );
 
-  using string_t = std::basic_string<CharT, Traits>;
+  using string_t = std::basic_string<CharT, Traits, Allocator>;
 
   template <typename Archive>
   static void compute_size(string_t const& obj, Archive& ar) {
-    ar | obj.size();
-    ar.add_to_size_raw(sizeof(CharT) * obj.size());
+    add_size_prefix_to_size(ar, obj.size());
+    add_to_size_raw(ar, obj.data(), obj.data() + obj.size());
   }
 
   template <typename Archive>
   static void pack(string_t const& obj, Archive& ar) {
-    ar | obj.size();
+    pack_size_prefix(ar, obj.size());
     ar.pack_data_raw(obj.data(), obj.data() + obj.size());
   }
 
   template <typename Archive>
   static void unpack(void* allocated, Archive& ar) {
-    auto size = ar.template unpack_next_item_as<typename string_t::size_type>();
-    auto& obj = *(new (allocated) string_t(size, static_cast<CharT>(0)));
+    auto size = checked_data_raw_count<CharT>(ar,
+      unpack_size_prefix<typename string_t::size_type>(ar)
+    );
+    auto& obj = *(new (allocated) string_t(
+      size, static_cast<CharT>(0),
+      ar.template get_allocator_as<typename string_t::allocator_type>()
+    ));
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      ar.template unpack_data_raw<CharT const>(
+        // This is probably safe everywhere, given that the nonconst version of
+        // data() was added to C++17
+        const_cast<CharT*>(obj.data()), size
+      );
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~string_t();
+      throw;
+    }
+#else
     ar.template unpack_data_raw<CharT const>(
-      // This is probably safe everywhere, given that the nonconst version of
-      // data() was added to C++17
       const_cast<CharT*>(obj.data()), size
     );
+#endif
     // If the const cast ever doesn't work, we'd need to do something like this:
     //
     //   auto size = ar.template unpack_next_item_as<typename string_t::size_type>();
@@ -117,6 +137,21 @@ struct Serializer<std::basic_string<CharT, Traits>> {
 
 //==============================================================================
 
+template <typename CharT, typename Traits, typename Allocator>
+struct ViewDeserializer<std::basic_string<CharT, Traits, Allocator>> {
+  using view_type = BasicStringView<CharT, Traits>;
+
+  template <typename Archive>
+  static view_type unpack_view(Archive& ar) {
+    auto size = unpack_size_prefix<
+      typename std::basic_string<CharT, Traits, Allocator>::size_type
+    >(ar);
+    return view_type(ar.template view_data_raw<CharT>(size), size);
+  }
+};
+
+//==============================================================================
+
 } // end namespace serialization
 } // end namespace darma
 
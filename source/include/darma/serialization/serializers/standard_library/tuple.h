@@ -45,10 +45,14 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_TUPLE_H
 #define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_TUPLE_H
 
+#include <darma/serialization/byte_order.h>
 #include <darma/serialization/nonintrusive.h>
 #include <darma/serialization/serialization_traits.h>
 
+#include <cstring>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 namespace darma {
 namespace serialization {
@@ -83,6 +87,47 @@ struct is_directly_serializable<std::tuple<Ts...>>
     >
 { };
 
+template <typename... Ts>
+struct byte_swap_traits<std::tuple<Ts...>,
+  std::enable_if_t<
+    tinympl::and_<detail::is_byte_swappable<std::remove_const_t<Ts>>...>::value
+  >
+> {
+  using tuple_t = std::tuple<Ts...>;
+
+  template <size_t... Idxs>
+  static void _swap_elements(
+    tuple_t* dest, tuple_t const* src, std::integer_sequence<size_t, Idxs...>
+  ) {
+    // Order doesn't matter here, so simple fold emulation is fine.  (The
+    // const_cast is for const elements, which are still being initialized.)
+    int expand[] = { 0, (
+      byte_swap_traits<std::remove_const_t<std::tuple_element_t<Idxs, tuple_t>>>::copy_swapped(
+        const_cast<void*>(static_cast<void const*>(&std::get<Idxs>(*dest))),
+        &std::get<Idxs>(*src), 1
+      ), 0
+    )... };
+    (void)expand;
+  }
+
+  static void copy_swapped(void* dest, void const* src, std::size_t n_items) {
+    using storage_t = std::aligned_storage_t<sizeof(tuple_t), alignof(tuple_t)>;
+    // The wire side can be at any offset (see PortableLayout), so each tuple
+    // is swapped between aligned copies.  Copying the whole tuple first
+    // carries any padding along with it.
+    storage_t in, out;
+    for(std::size_t i = 0; i < n_items; ++i) {
+      std::memcpy(&in, static_cast<char const*>(src) + i * sizeof(tuple_t), sizeof(tuple_t));
+      std::memcpy(&out, &in, sizeof(tuple_t));
+      _swap_elements(
+        reinterpret_cast<tuple_t*>(&out), reinterpret_cast<tuple_t const*>(&in),
+        std::index_sequence_for<Ts...>{}
+      );
+      std::memcpy(static_cast<char*>(dest) + i * sizeof(tuple_t), &out, sizeof(tuple_t));
+    }
+  }
+};
+
 //==============================================================================
 
 // Only need to implement the non-directly-serializable version, since the
@@ -137,10 +182,35 @@ struct Serializer_enabled_if<
   inline static void _apply_unpack_recursively(
     Archive& ar, Arg& arg, Args&... args
   ) {
-    ar.template unpack_next_item_at<Arg>(&arg);
+    // The storage is still uninitialized here, so const elements (e.g., the
+    // key in a std::tuple<int const, ...>) are constructed in place like the rest
+    using arg_t = std::remove_const_t<Arg>;
+    ar.template unpack_next_item_at<Arg>(const_cast<arg_t*>(&arg));
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      this_t::_apply_unpack_recursively(ar, args...);
+    }
+    catch(...) {
+      // Destroy the elements unpacked so far (in reverse order, as the
+      // exception unwinds) to leave allocated uninitialized, as we found it
+      this_t::_destroy_element(*const_cast<arg_t*>(&arg));
+      throw;
+    }
+#else
     this_t::_apply_unpack_recursively(ar, args...);
+#endif
   };
 
+  template <typename U>
+  inline static void _destroy_element(U& elem) { elem.~U(); }
+
+  template <typename U, size_t N>
+  inline static void _destroy_element(U (&elems)[N]) {
+    for(size_t i = N; i > 0; --i) {
+      this_t::_destroy_element(elems[i - 1]);
+    }
+  }
+
   template <typename Archive, size_t... Idxs>
   static void _apply_unpack_impl(
     tuple_t& obj, Archive& ar, std::integer_sequence<size_t, Idxs...>
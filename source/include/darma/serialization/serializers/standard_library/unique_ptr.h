@@ -0,0 +1,458 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      unique_ptr.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNIQUE_PTR_H
+#define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNIQUE_PTR_H
+
+#include <darma/serialization/byte_order.h>
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/integer_encoding.h>
+#include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
+#include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/wire_layout.h>
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/serializers/standard_library/vector.h>
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <stdexcept>
+#endif
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+//==============================================================================
+// <editor-fold desc="packing polymorphic objects into an archive"> {{{1
+
+// Polymorphic objects pack themselves into a char buffer (see
+// PolymorphicSerializableObject::pack()), so they're written straight into the
+// archive's buffer if the archive exposes where it's packing, and through a
+// temporary buffer otherwise.  Either way, they're written without padding and
+// in the host's byte order, so they can't be serialized with layouts that pad
+// raw data (AlignedLayout) or store it in another byte order (PortableLayout
+// with a WireOrder other than the host's).
+
+template <typename Archive>
+using _archive_swaps_bytes =
+  _byte_order_differs_from_host<layout_byte_order_t<archive_layout_t<Archive>>>;
+
+template <typename Archive>
+using _data_pointer_reference_archetype =
+  decltype(std::declval<Archive&>().data_pointer_reference());
+
+template <typename Archive>
+using _has_data_pointer_reference =
+  tinympl::is_detected<_data_pointer_reference_archetype, Archive>;
+
+template <typename Archive>
+using _check_capacity_archetype =
+  decltype(std::declval<Archive&>().check_capacity(std::size_t{}));
+
+template <typename Archive>
+using _has_check_capacity =
+  tinympl::is_detected<_check_capacity_archetype, Archive>;
+
+// Writing straight into the buffer skips the archive's own capacity checks, so
+// the bytes the object says it needs are checked first, if the archive can
+template <typename Archive, typename SizeFunction>
+void _check_polymorphic_capacity(
+  Archive& ar, SizeFunction&& size_function, std::true_type /* has check */
+) {
+  ar.check_capacity(size_function());
+}
+
+template <typename Archive, typename SizeFunction>
+void _check_polymorphic_capacity(
+  Archive&, SizeFunction&&, std::false_type /* has check */
+) { }
+
+template <typename Archive, typename SizeFunction, typename PackFunction>
+void _pack_polymorphic_bytes(
+  Archive& ar, SizeFunction&& size_function, PackFunction&& pack_function,
+  std::true_type /* has data pointer reference */
+) {
+  _check_polymorphic_capacity(ar, std::forward<SizeFunction>(size_function),
+    typename _has_check_capacity<Archive>::type{}
+  );
+  pack_function(*reinterpret_cast<char**>(&ar.data_pointer_reference()));
+}
+
+template <typename Archive, typename SizeFunction, typename PackFunction>
+void _pack_polymorphic_bytes(
+  Archive& ar, SizeFunction&& size_function, PackFunction&& pack_function,
+  std::false_type /* has data pointer reference */
+) {
+  std::vector<char> tmp(size_function());
+  char* spot = tmp.data();
+  pack_function(spot);
+  pack_data_raw_copy(ar, tmp.data(), tmp.data() + tmp.size());
+}
+
+template <typename Archive, typename SizeFunction, typename PackFunction>
+void _pack_polymorphic_bytes(
+  Archive& ar, SizeFunction&& size_function, PackFunction&& pack_function
+) {
+  static_assert(not archive_pads_raw_data<Archive>::value,
+    "polymorphic objects can only be serialized with the packed wire layout"
+  );
+  static_assert(not _archive_swaps_bytes<Archive>::value,
+    "polymorphic objects can only be serialized in the host's byte order"
+  );
+  _pack_polymorphic_bytes(ar,
+    std::forward<SizeFunction>(size_function),
+    std::forward<PackFunction>(pack_function),
+    typename _has_data_pointer_reference<Archive>::type{}
+  );
+}
+
+template <typename Archive>
+char const*& _unpacking_data_spot(Archive& ar) {
+  static_assert(not archive_pads_raw_data<Archive>::value,
+    "polymorphic objects can only be serialized with the packed wire layout"
+  );
+  static_assert(not _archive_swaps_bytes<Archive>::value,
+    "polymorphic objects can only be serialized in the host's byte order"
+  );
+  return *reinterpret_cast<char const**>(&ar.data_pointer_reference());
+}
+
+// Returns the unpack function for the polymorphic header at spot and advances
+// spot past it; a header naming a type that isn't registered as an AbstractT
+// is an error (see _unknown_polymorphic_type())
+template <typename AbstractT>
+polymorphic_unpack_function_t<AbstractT>
+_registered_unpack_function(char const*& spot) {
+  auto rv = _find_unpack_function<AbstractT>(spot);
+  if(rv == nullptr) _unknown_polymorphic_type<AbstractT>();
+  return rv;
+}
+
+// </editor-fold> end packing polymorphic objects into an archive }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="objects owned through pointers"> {{{1
+
+// Serializes the object an owning pointer points to; unpack() returns an
+// object allocated as if by new, for the pointer to take ownership of
+template <typename T, typename Enable=void>
+struct _pointee_serializer {
+  template <typename SizingArchive>
+  static void compute_size(T const& obj, SizingArchive& ar) { ar | obj; }
+
+  template <typename Archive>
+  static void pack(T const& obj, Archive& ar) { ar | obj; }
+
+  template <typename Archive>
+  static T* unpack(Archive& ar) {
+    // std::default_delete will free this with delete, which matches
+    using allocator_t = std::allocator<T>;
+    allocator_t alloc;
+    auto* spot = std::allocator_traits<allocator_t>::allocate(alloc, 1);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+#endif
+      ar.template unpack_next_item_at<T>(spot);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    }
+    catch(...) {
+      std::allocator_traits<allocator_t>::deallocate(alloc, spot, 1);
+      throw;
+    }
+#endif
+    return spot;
+  }
+};
+
+// Polymorphic objects are packed with their own pack() (including the header
+// identifying their concrete type), and unpacked as their concrete type
+template <typename T>
+struct _pointee_serializer<T,
+  std::enable_if_t<is_polymorphic_serializable<T>::value>
+> {
+  template <typename SizingArchive>
+  static void compute_size(T const& obj, SizingArchive& ar) {
+    ar.add_to_size_raw(obj.get_packed_size());
+  }
+
+  template <typename Archive>
+  static void pack(T const& obj, Archive& ar) {
+    _pack_polymorphic_bytes(ar,
+      [&]{ return obj.get_packed_size(); },
+      [&](char*& spot) { obj.pack(spot); }
+    );
+  }
+
+  template <typename Archive>
+  static T* unpack(Archive& ar) {
+    auto& spot = _unpacking_data_spot(ar);
+    auto unpack_function = _registered_unpack_function<T>(spot);
+    // Without a resource, the object is allocated with new
+    return unpack_function(spot, nullptr).release();
+  }
+};
+
+// </editor-fold> end objects owned through pointers }}}1
+//==============================================================================
+
+
+//==============================================================================
+// <editor-fold desc="std::vector<std::unique_ptr<AbstractT>>"> {{{1
+
+// The elements are packed in runs, each of which starts with its length and
+// kind.  Consecutive objects of the same concrete type are packed with the
+// header identifying that type written once, for the first object, so the
+// unpack function for the run is looked up once rather than once per element.
+template <typename AbstractT, typename Allocator>
+struct _polymorphic_pointer_vector_serializer {
+  using vector_t = std::vector<std::unique_ptr<AbstractT>, Allocator>;
+  using size_type = typename vector_t::size_type;
+
+  enum struct _run_kind : std::uint8_t {
+    null = 0,
+    // header once, then each object without its header
+    same_concrete_type = 1,
+    // each object packed with its own header (for objects that can't be
+    // packed without one)
+    individual = 2
+  };
+
+  // Calls f(begin, end, kind) for each run in obj
+  template <typename Function>
+  static void _for_each_run(vector_t const& obj, Function&& f) {
+    size_type i = 0;
+    auto const n = obj.size();
+    while(i < n) {
+      auto begin = i;
+      if(obj[i] == nullptr) {
+        while(i < n and obj[i] == nullptr) ++i;
+        f(begin, i, _run_kind::null);
+      }
+      else if(obj[i]->get_packed_header_size() == 0) {
+        while(i < n and obj[i] != nullptr and obj[i]->get_packed_header_size() == 0) ++i;
+        f(begin, i, _run_kind::individual);
+      }
+      else {
+        auto const& type = typeid(*obj[i]);
+        ++i;
+        while(i < n and obj[i] != nullptr and typeid(*obj[i]) == type) ++i;
+        f(begin, i, _run_kind::same_concrete_type);
+      }
+    }
+  }
+
+  static size_t _run_bytes(vector_t const& obj, size_type begin, size_type end, _run_kind kind) {
+    size_t rv = 0;
+    if(kind == _run_kind::same_concrete_type) {
+      auto header_size = obj[begin]->get_packed_header_size();
+      rv += header_size;
+      for(auto i = begin; i < end; ++i) rv += obj[i]->get_packed_size() - header_size;
+    }
+    else if(kind == _run_kind::individual) {
+      for(auto i = begin; i < end; ++i) rv += obj[i]->get_packed_size();
+    }
+    return rv;
+  }
+
+  template <typename SizingArchive>
+  static void compute_size(vector_t const& obj, SizingArchive& ar) {
+    add_size_prefix_to_size(ar, obj.size());
+    _for_each_run(obj, [&](size_type begin, size_type end, _run_kind kind) {
+      add_size_prefix_to_size(ar, end - begin);
+      ar | static_cast<std::uint8_t>(kind);
+      ar.add_to_size_raw(_run_bytes(obj, begin, end, kind));
+    });
+  }
+
+  template <typename Archive>
+  static void pack(vector_t const& obj, Archive& ar) {
+    pack_size_prefix(ar, obj.size());
+    _for_each_run(obj, [&](size_type begin, size_type end, _run_kind kind) {
+      pack_size_prefix(ar, end - begin);
+      ar | static_cast<std::uint8_t>(kind);
+      if(kind == _run_kind::null) return;
+      _pack_polymorphic_bytes(ar,
+        [&]{ return _run_bytes(obj, begin, end, kind); },
+        [&](char*& spot) {
+          auto i = begin;
+          if(kind == _run_kind::same_concrete_type) {
+            obj[i]->pack(spot);
+            for(++i; i < end; ++i) obj[i]->pack_without_header(spot);
+          }
+          else {
+            for(; i < end; ++i) obj[i]->pack(spot);
+          }
+        }
+      );
+    });
+  }
+
+  [[noreturn]] static void _corrupt_run() {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    throw std::runtime_error("corrupt run of polymorphic objects in serialized data");
+#else
+    detail::_fatal_error("corrupt run of polymorphic objects in serialized data");
+#endif
+  }
+
+  template <typename Archive>
+  static void _unpack_runs(vector_t& obj, size_type size, Archive& ar) {
+    // The vector grows run by run instead of being reserved from the size
+    // prefix up front: a run of nulls takes a couple of bytes however long it
+    // is, so the prefix can't be checked against what's left of the buffer
+    while(obj.size() < size and not unpacking_failed(ar)) {
+      auto run_length = unpack_size_prefix<size_type>(ar);
+      auto kind_value = ar.template unpack_next_item_as<std::uint8_t>();
+      // Every run has at least one element, and no more than are left; an
+      // empty run would never finish, and a long one would grow the vector
+      // past its size prefix
+      if(run_length == 0 or run_length > size - obj.size()
+        or kind_value > static_cast<std::uint8_t>(_run_kind::individual)
+      ) {
+        _corrupt_run();
+      }
+      auto kind = static_cast<_run_kind>(kind_value);
+      if(kind == _run_kind::null) {
+        obj.resize(obj.size() + run_length);
+      }
+      else if(kind == _run_kind::same_concrete_type) {
+        auto& spot = _unpacking_data_spot(ar);
+        auto unpack_function = _registered_unpack_function<AbstractT>(spot);
+        for(size_type i = 0; i < run_length; ++i) {
+          // Owned until it's in the vector, in case emplace_back() throws
+          std::unique_ptr<AbstractT> element(unpack_function(spot, nullptr).release());
+          obj.emplace_back(std::move(element));
+        }
+      }
+      else {
+        auto& spot = _unpacking_data_spot(ar);
+        for(size_type i = 0; i < run_length; ++i) {
+          auto unpack_function = _registered_unpack_function<AbstractT>(spot);
+          std::unique_ptr<AbstractT> element(unpack_function(spot, nullptr).release());
+          obj.emplace_back(std::move(element));
+        }
+      }
+    }
+  }
+
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    auto size = unpack_size_prefix<size_type>(ar);
+    auto& obj = *(new (allocated) vector_t(
+      ar.template get_allocator_as<typename vector_t::allocator_type>())
+    );
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      _unpack_runs(obj, size, ar);
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~vector_t();
+      throw;
+    }
+#else
+    _unpack_runs(obj, size, ar);
+#endif
+  }
+};
+
+// </editor-fold> end std::vector<std::unique_ptr<AbstractT>> }}}1
+//==============================================================================
+
+} // end namespace detail
+
+/// A presence flag, followed by the pointee if there is one.  Objects pointed
+/// to by a polymorphic_serializable type are unpacked as their concrete type.
+template <typename T>
+struct Serializer<std::unique_ptr<T>> {
+  using value_t = std::remove_const_t<T>;
+  using pointee_serializer_t = detail::_pointee_serializer<value_t>;
+
+  template <typename SizingArchive>
+  static void compute_size(std::unique_ptr<T> const& obj, SizingArchive& ar) {
+    ar | static_cast<bool>(obj);
+    if(obj) pointee_serializer_t::compute_size(*obj, ar);
+  }
+
+  template <typename Archive>
+  static void pack(std::unique_ptr<T> const& obj, Archive& ar) {
+    ar | static_cast<bool>(obj);
+    if(obj) pointee_serializer_t::pack(*obj, ar);
+  }
+
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    if(ar.template unpack_next_item_as<bool>()) {
+      new (allocated) std::unique_ptr<T>(pointee_serializer_t::unpack(ar));
+    }
+    else {
+      new (allocated) std::unique_ptr<T>();
+    }
+  }
+};
+
+/// Only vectors of pointers to polymorphic_serializable types are grouped by
+/// concrete type; the rest are serialized like any other std::vector
+template <typename T, typename Allocator>
+struct Serializer<std::vector<std::unique_ptr<T>, Allocator>>
+  : std::conditional_t<is_polymorphic_serializable<T>::value,
+      detail::_polymorphic_pointer_vector_serializer<T, Allocator>,
+      Serializer_enabled_if<std::vector<std::unique_ptr<T>, Allocator>>
+    >
+{ };
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNIQUE_PTR_H
@@ -0,0 +1,251 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      unordered_common.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNORDERED_COMMON_H
+#define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNORDERED_COMMON_H
+
+#include <darma/serialization/integer_encoding.h>
+#include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
+#include <darma/serialization/serialization_traits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace darma {
+namespace serialization {
+
+namespace detail {
+
+// Shared by the std::unordered_{map,multimap,set,multiset} serializers, which
+// only differ in their value_type.  The bucket count and max load factor are
+// sent along with the size so that the destination can be set up with the
+// same table up front and never has to rehash while it fills.
+template <typename Container, typename Enable=void>
+struct UnorderedContainerSerializer;
+
+template <typename Container>
+struct _unordered_container_serializer_base {
+  using container_t = Container;
+  using size_type = typename container_t::size_type;
+
+  template <typename Archive>
+  static void _compute_header_size(container_t const& obj, Archive& ar) {
+    add_size_prefix_to_size(ar, obj.size());
+    add_size_prefix_to_size(ar, obj.bucket_count());
+    ar | obj.max_load_factor();
+  }
+
+  template <typename Archive>
+  static void _pack_header(container_t const& obj, Archive& ar) {
+    pack_size_prefix(ar, obj.size());
+    pack_size_prefix(ar, obj.bucket_count());
+    ar | obj.max_load_factor();
+  }
+
+  // The bucket count and max load factor are only hints, so a checked archive
+  // (see checked_item_count()) doesn't fail over implausible ones; it just
+  // doesn't size the table from them
+  template <typename Archive>
+  static void _sanitize_table_shape(
+    Archive& ar, size_type& bucket_count, float& max_load_factor,
+    std::true_type /* archive checks its reads */
+  ) {
+    bucket_count = std::min<size_type>(bucket_count, ar.bytes_remaining());
+    if(not std::isfinite(max_load_factor) or not (max_load_factor > 0.0f)) {
+      max_load_factor = 1.0f;
+    }
+  }
+
+  template <typename Archive>
+  static void _sanitize_table_shape(
+    Archive&, size_type&, float&, std::false_type /* archive checks its reads */
+  ) { }
+
+  template <typename Archive, typename UnpackElementsCallable>
+  static void _unpack(
+    void* allocated, Archive& ar, UnpackElementsCallable&& unpack_elements
+  ) {
+    auto size = checked_item_count(ar, unpack_size_prefix<size_type>(ar));
+    auto bucket_count = unpack_size_prefix<size_type>(ar);
+    auto max_load_factor = ar.template unpack_next_item_as<float>();
+    _sanitize_table_shape(ar, bucket_count, max_load_factor,
+      typename tinympl::is_detected<_checked_item_count_archetype, Archive>::type{}
+    );
+    auto& obj = *(new (allocated) container_t(
+      bucket_count,
+      typename container_t::hasher{},
+      typename container_t::key_equal{},
+      ar.template get_allocator_as<typename container_t::allocator_type>()
+    ));
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+#endif
+      obj.max_load_factor(max_load_factor);
+      // Only reserve if the sender's table was somehow too small to hold
+      // everything; reserve() is allowed to shrink the bucket count otherwise
+      if(static_cast<float>(size) > obj.max_load_factor() * obj.bucket_count()) {
+        obj.reserve(size);
+      }
+      unpack_elements(obj, size);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~container_t();
+      throw;
+    }
+#endif
+  }
+};
+
+// Basic case: elements not directly serializable, so go through the archive
+// one at a time
+template <typename Container>
+struct UnorderedContainerSerializer<Container,
+  std::enable_if_t<
+    not is_directly_serializable<typename Container::value_type>::value
+  >
+> : _unordered_container_serializer_base<Container>
+{
+  using base_t = _unordered_container_serializer_base<Container>;
+  using typename base_t::container_t;
+  using typename base_t::size_type;
+  using value_type = typename container_t::value_type;
+
+  template <typename Archive>
+  static void compute_size(container_t const& obj, Archive& ar) {
+    base_t::_compute_header_size(obj, ar);
+    for(auto&& val : obj) {
+      ar | val;
+    }
+  }
+
+  template <typename Archive>
+  static void pack(container_t const& obj, Archive& ar) {
+    base_t::_pack_header(obj, ar);
+    for(auto&& val : obj) {
+      ar | val;
+    }
+  }
+
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    base_t::_unpack(allocated, ar, [&ar](container_t& obj, size_type size) {
+      for(size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
+        obj.emplace(ar.template unpack_next_item_as<value_type>());
+      }
+    });
+  }
+};
+
+// Directly serializable elements (e.g., std::unordered_map<int, double>).
+// Sizing doesn't have to walk the table at all, and each element is copied
+// in and out as a single raw block instead of being dispatched through the
+// archive member by member.  (This is an optimization for performance
+// purposes only)
+template <typename Container>
+struct UnorderedContainerSerializer<Container,
+  std::enable_if_t<
+    is_directly_serializable<typename Container::value_type>::value
+  >
+> : _unordered_container_serializer_base<Container>
+{
+  using base_t = _unordered_container_serializer_base<Container>;
+  using typename base_t::container_t;
+  using typename base_t::size_type;
+  using value_type = typename container_t::value_type;
+
+  template <typename Archive>
+  static void compute_size(container_t const& obj, Archive& ar) {
+    base_t::_compute_header_size(obj, ar);
+    _compute_elements_size(obj, ar, archive_pads_raw_data<Archive>{});
+  }
+
+  template <typename Archive>
+  static void _compute_elements_size(
+    container_t const& obj, Archive& ar, std::false_type /* pads raw data */
+  ) {
+    ar.add_to_size_raw(sizeof(value_type) * obj.size());
+  }
+
+  // Each element is its own block of raw data when packed, so it has to be
+  // sized that way too if the archive might pad in between
+  template <typename Archive>
+  static void _compute_elements_size(
+    container_t const& obj, Archive& ar, std::true_type /* pads raw data */
+  ) {
+    for(auto&& val : obj) {
+      add_to_size_raw(ar, &val, &val + 1);
+    }
+  }
+
+  template <typename Archive>
+  static void pack(container_t const& obj, Archive& ar) {
+    base_t::_pack_header(obj, ar);
+    for(auto&& val : obj) {
+      ar.pack_data_raw(&val, &val + 1);
+    }
+  }
+
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    base_t::_unpack(allocated, ar, [&ar](container_t& obj, size_type size) {
+      std::aligned_storage_t<sizeof(value_type), alignof(value_type)> storage;
+      auto const* val = reinterpret_cast<value_type const*>(&storage);
+      for(size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
+        ar.template unpack_data_raw<value_type const>(&storage, 1);
+        obj.emplace(*val);
+      }
+    });
+  }
+};
+
+} // end namespace detail
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNORDERED_COMMON_H
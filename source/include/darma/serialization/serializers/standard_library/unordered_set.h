@@ -0,0 +1,166 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      unordered_set.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNORDERED_SET_H
+#define DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNORDERED_SET_H
+
+#include <darma/serialization/serializers/const.h>
+#include <darma/serialization/serializers/standard_library/unordered_common.h>
+
+#include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/serialization_traits.h>
+
+#include <unordered_set>
+
+// TODO stateful hash and key_equal?
+
+namespace darma {
+namespace serialization {
+
+//==============================================================================
+// <editor-fold desc="std::unordered_set"> {{{1
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator, typename Archive
+>
+struct is_sizable_with_archive<
+  std::unordered_set<Key, Hash, KeyEqual, Allocator>, Archive
+> : tinympl::and_<
+      is_sizable_with_archive<Key, Archive>,
+      std::is_empty<Hash>, std::is_trivially_copyable<Hash>,
+      std::is_empty<KeyEqual>, std::is_trivially_copyable<KeyEqual>
+    >
+{ };
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator, typename Archive
+>
+struct is_packable_with_archive<
+  std::unordered_set<Key, Hash, KeyEqual, Allocator>, Archive
+> : tinympl::and_<
+      is_packable_with_archive<Key, Archive>,
+      std::is_empty<Hash>, std::is_trivially_copyable<Hash>,
+      std::is_empty<KeyEqual>, std::is_trivially_copyable<KeyEqual>
+    >
+{ };
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator, typename Archive
+>
+struct is_unpackable_with_archive<
+  std::unordered_set<Key, Hash, KeyEqual, Allocator>, Archive
+> : tinympl::and_<
+      is_unpackable_with_archive<Key, Archive>,
+      std::is_empty<Hash>, std::is_trivially_copyable<Hash>,
+      std::is_empty<KeyEqual>, std::is_trivially_copyable<KeyEqual>
+    >
+{ };
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator
+>
+struct Serializer<std::unordered_set<Key, Hash, KeyEqual, Allocator>>
+  : detail::UnorderedContainerSerializer<
+      std::unordered_set<Key, Hash, KeyEqual, Allocator>
+    >
+{ };
+
+// </editor-fold> end std::unordered_set }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="std::unordered_multiset"> {{{1
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator, typename Archive
+>
+struct is_sizable_with_archive<
+  std::unordered_multiset<Key, Hash, KeyEqual, Allocator>, Archive
+> : tinympl::and_<
+      is_sizable_with_archive<Key, Archive>,
+      std::is_empty<Hash>, std::is_trivially_copyable<Hash>,
+      std::is_empty<KeyEqual>, std::is_trivially_copyable<KeyEqual>
+    >
+{ };
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator, typename Archive
+>
+struct is_packable_with_archive<
+  std::unordered_multiset<Key, Hash, KeyEqual, Allocator>, Archive
+> : tinympl::and_<
+      is_packable_with_archive<Key, Archive>,
+      std::is_empty<Hash>, std::is_trivially_copyable<Hash>,
+      std::is_empty<KeyEqual>, std::is_trivially_copyable<KeyEqual>
+    >
+{ };
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator, typename Archive
+>
+struct is_unpackable_with_archive<
+  std::unordered_multiset<Key, Hash, KeyEqual, Allocator>, Archive
+> : tinympl::and_<
+      is_unpackable_with_archive<Key, Archive>,
+      std::is_empty<Hash>, std::is_trivially_copyable<Hash>,
+      std::is_empty<KeyEqual>, std::is_trivially_copyable<KeyEqual>
+    >
+{ };
+
+template <typename Key, typename Hash, typename KeyEqual,
+  typename Allocator
+>
+struct Serializer<std::unordered_multiset<Key, Hash, KeyEqual, Allocator>>
+  : detail::UnorderedContainerSerializer<
+      std::unordered_multiset<Key, Hash, KeyEqual, Allocator>
+    >
+{ };
+
+// </editor-fold> end std::unordered_multiset }}}1
+//==============================================================================
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_SERIALIZERS_STANDARD_LIBRARY_UNORDERED_SET_H
@@ -45,30 +45,33 @@
 #ifndef DARMAFRONTEND_SERIALIZATION_STANDARD_LIBRARY_VECTOR_H
 #define DARMAFRONTEND_SERIALIZATION_STANDARD_LIBRARY_VECTOR_H
 
+#include <darma/serialization/integer_encoding.h>
 #include <darma/serialization/nonintrusive.h>
+#include <darma/serialization/raw_data_helpers.h>
 #include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/views.h>
 
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 namespace darma {
 namespace serialization {
 
-// TODO vectors with non-standard/non-empty allocators ?
-
 //==============================================================================
 
-template <typename T, typename Archive>
-struct is_sizable_with_archive<std::vector<T>, Archive>
+template <typename T, typename Allocator, typename Archive>
+struct is_sizable_with_archive<std::vector<T, Allocator>, Archive>
   : is_sizable_with_archive<T, Archive>
 { };
 
-template <typename T, typename Archive>
-struct is_packable_with_archive<std::vector<T>, Archive>
+template <typename T, typename Allocator, typename Archive>
+struct is_packable_with_archive<std::vector<T, Allocator>, Archive>
   : is_packable_with_archive<T, Archive>
 { };
 
-template <typename T, typename Archive>
-struct is_unpackable_with_archive<std::vector<T>, Archive>
+template <typename T, typename Allocator, typename Archive>
+struct is_unpackable_with_archive<std::vector<T, Allocator>, Archive>
   : is_unpackable_with_archive<T, Archive>
 { };
 
@@ -76,16 +79,16 @@ struct is_unpackable_with_archive<std::vector<T>, Archive>
 
 // Basic case: T not directly serializable. Can't really optimize further
 // than just unpacking each item one at a time
-template <typename T>
+template <typename T, typename Allocator>
 struct Serializer_enabled_if<
-  std::vector<T>, std::enable_if_t<not is_directly_serializable<T>::value>
+  std::vector<T, Allocator>, std::enable_if_t<not is_directly_serializable<T>::value>
 >
 {
-  using vector_t = std::vector<T>;
+  using vector_t = std::vector<T, Allocator>;
 
   template <typename SizingArchive>
   static void compute_size(vector_t const& obj, SizingArchive& ar) {
-    ar | obj.size();
+    add_size_prefix_to_size(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -93,7 +96,7 @@ struct Serializer_enabled_if<
 
   template <typename Archive>
   static void pack(vector_t const& obj, Archive& ar) {
-    ar | obj.size();
+    pack_size_prefix(ar, obj.size());
     for(auto&& val : obj) {
       ar | val;
     }
@@ -101,12 +104,66 @@ struct Serializer_enabled_if<
 
   template <typename Archive>
   static void unpack(void* allocated, Archive& ar) {
-    auto size = ar.template unpack_next_item_as<typename vector_t::size_type>();
+    auto size = checked_item_count(ar,
+      unpack_size_prefix<typename vector_t::size_type>(ar)
+    );
     auto& obj = *(new (allocated) vector_t(
       ar.template get_allocator_as<typename vector_t::allocator_type>())
     );
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      _unpack_elements(obj, size, ar,
+        typename std::is_nothrow_default_constructible<T>::type{}
+      );
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it
+      obj.~vector_t();
+      throw;
+    }
+#else
+    _unpack_elements(obj, size, ar,
+      typename std::is_nothrow_default_constructible<T>::type{}
+    );
+#endif
+  }
+
+  // If T is cheap and safe to default construct (e.g., std::string), size the
+  // vector up front and unpack each element directly into its final slot, so
+  // that there's no temporary to move from and destroy for each element
+  template <typename Archive>
+  static void _unpack_elements(
+    vector_t& obj, typename vector_t::size_type size, Archive& ar,
+    std::true_type /* nothrow default constructible */
+  ) {
+    using alloc_traits = std::allocator_traits<Allocator>;
+    auto alloc = obj.get_allocator();
+    obj.resize(size);
+    for(typename vector_t::size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
+      auto* slot = std::addressof(obj[i]);
+      alloc_traits::destroy(alloc, slot);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      try {
+        ar.template unpack_next_item_at<T>(slot);
+      }
+      catch(...) {
+        // Put something back in the slot so that the vector can be destroyed
+        alloc_traits::construct(alloc, slot);
+        throw;
+      }
+#else
+      ar.template unpack_next_item_at<T>(slot);
+#endif
+    }
+  }
+
+  template <typename Archive>
+  static void _unpack_elements(
+    vector_t& obj, typename vector_t::size_type size, Archive& ar,
+    std::false_type /* nothrow default constructible */
+  ) {
     obj.reserve(size);
-    for(int64_t i = 0; i < size; ++i) {
+    for(typename vector_t::size_type i = 0; i < size and not unpacking_failed(ar); ++i) {
       obj.emplace_back(ar.template unpack_next_item_as<T>());
     }
   }
@@ -116,32 +173,63 @@ struct Serializer_enabled_if<
 
 // Directly serializable T specialization of std::vector<T>.  (This is an
 // optimization for performance purposes only)
-template <typename T>
+template <typename T, typename Allocator>
 struct Serializer_enabled_if<
-  std::vector<T>, std::enable_if_t<is_directly_serializable<T>::value>
+  std::vector<T, Allocator>, std::enable_if_t<is_directly_serializable<T>::value>
 >
 {
-  using vector_t = std::vector<T>;
+  using vector_t = std::vector<T, Allocator>;
 
   template <typename Archive>
   static void compute_size(vector_t const& obj, Archive& ar) {
-    ar | obj.size();
-    ar.add_to_size_raw(sizeof(T) * obj.size());
+    add_size_prefix_to_size(ar, obj.size());
+    add_to_size_raw(ar, obj.data(), obj.data() + obj.size());
   }
 
   template <typename Archive>
   static void pack(vector_t const& obj, Archive& ar) {
-    ar | obj.size();
+    pack_size_prefix(ar, obj.size());
     ar.pack_data_raw(obj.data(), obj.data() + obj.size());
   }
 
   template <typename Archive>
   static void unpack(void* allocated, Archive& ar) {
-    auto size = ar.template unpack_next_item_as<typename vector_t::size_type>();
+    auto size = checked_data_raw_count<T>(ar,
+      unpack_size_prefix<typename vector_t::size_type>(ar)
+    );
     auto& obj = *(new (allocated) vector_t(
       size, ar.template get_allocator_as<typename vector_t::allocator_type>()
     ));
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      ar.template unpack_data_raw<T const>(obj.data(), size);
+    }
+    catch(...) {
+      // Leave allocated uninitialized, as we found it (e.g., when a streaming
+      // archive runs out of data)
+      obj.~vector_t();
+      throw;
+    }
+#else
     ar.template unpack_data_raw<T const>(obj.data(), size);
+#endif
+  }
+};
+
+// Directly serializable elements can be read in place
+template <typename T, typename Allocator>
+struct ViewDeserializer<
+  std::vector<T, Allocator>, std::enable_if_t<is_directly_serializable<T>::value>
+>
+{
+  using view_type = ArrayView<T>;
+
+  template <typename Archive>
+  static view_type unpack_view(Archive& ar) {
+    auto size = unpack_size_prefix<
+      typename std::vector<T, Allocator>::size_type
+    >(ar);
+    return view_type(ar.template view_data_raw<T>(size), size);
   }
 };
 
@@ -45,32 +45,208 @@
 #ifndef DARMAFRONTEND_SIZING_ARCHIVE_H
 #define DARMAFRONTEND_SIZING_ARCHIVE_H
 
+#include <darma/serialization/byte_order.h>
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/object_identity.h>
 #include <darma/serialization/serialization_traits.h>
 #include <darma/serialization/serialization_buffer.h>
 #include <darma/serialization/simple_handler_fwd.h>
+#include <darma/serialization/varint.h>
+#include <darma/serialization/views.h>
+#include <darma/serialization/wire_layout.h>
+#include <darma/utility/not_a_type.h>
 
 #include "simple_handler_fwd.h"
 #include "pointer_reference_handler_fwd.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
 
 #ifndef DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX
 #  define DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX 1024
 #endif
 
+// Check every write a SimplePackingArchive makes against its buffer's
+// capacity, and that it packs exactly as many bytes as the sizing pass said it
+// would, aborting with a message otherwise (i.e., when a compute_size()
+// under-reports).  On by default in debug builds; compiled out entirely when
+// it's 0.
+#ifndef DARMA_SERIALIZATION_CHECK_PACKING
+#  ifdef NDEBUG
+#    define DARMA_SERIALIZATION_CHECK_PACKING 0
+#  else
+#    define DARMA_SERIALIZATION_CHECK_PACKING 1
+#  endif
+#endif
+
 namespace darma {
 namespace serialization {
 
-class SimpleSizingArchive {
+namespace detail {
+
+template <typename NeededAllocatorT, typename ArchiveAllocatorT>
+NeededAllocatorT
+_get_allocator_as(ArchiveAllocatorT const& alloc, std::true_type) {
+  return NeededAllocatorT(alloc);
+}
+
+template <typename NeededAllocatorT, typename ArchiveAllocatorT>
+NeededAllocatorT
+_get_allocator_as(ArchiveAllocatorT const&, std::false_type) {
+  return NeededAllocatorT{};
+}
+
+// Convert an unpacking archive's allocator into the allocator type a
+// serializer needs (e.g., the allocator_type of a container it's unpacking).
+// If the needed allocator can't be constructed from the archive's (e.g., a
+// std::vector<int> being unpacked with an arena allocator), it gets a
+// default-constructed one instead, as it would have without the archive.
+template <typename NeededAllocatorT, typename ArchiveAllocatorT>
+NeededAllocatorT
+get_allocator_as(ArchiveAllocatorT const& alloc) {
+  return _get_allocator_as<NeededAllocatorT>(alloc,
+    typename std::is_constructible<
+      NeededAllocatorT, ArchiveAllocatorT const&
+    >::type{}
+  );
+}
+
+/// Unpacking archive functionality that only depends on the archive's
+/// allocator and the darma_unpack() customization point, shared between
+/// SimpleUnpackingArchive and PointerReferenceUnpackingArchive (CRTP base)
+template <typename Archive, typename Allocator>
+class UnpackingArchiveMixin {
+  private:
+
+    Archive& _archive() { return *static_cast<Archive*>(this); }
+
+    template <typename T>
+    using _allocator_for_t =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+  public:
+
+    // The unpacked object is constructed in storage owned by this function and
+    // then moved (not copied) into the return value, so that, e.g., each
+    // std::string in a std::vector<std::string> is only allocated once
+
+    template <typename T>
+    inline T unpack_next_item_as(
+      std::enable_if_t<
+        (sizeof(T) > DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX),
+        darma::utility::_not_a_type_numbered<0>
+      > = { }
+    ) & {
+      using allocator_t = _allocator_for_t<T>;
+      using traits_t = std::allocator_traits<allocator_t>;
+      allocator_t alloc(_archive().get_allocator());
+      auto deallocate = [&alloc](T* ptr) { traits_t::deallocate(alloc, ptr, 1); };
+      std::unique_ptr<T, decltype(deallocate)> storage(
+        traits_t::allocate(alloc, 1), deallocate
+      );
+      darma_unpack(allocated_buffer_for<T>(storage.get()), _archive());
+      // Destroyed before the storage is deallocated
+      auto destroy = [&alloc](T* ptr) { traits_t::destroy(alloc, ptr); };
+      std::unique_ptr<T, decltype(destroy)> unpacked(storage.get(), destroy);
+      return std::move(*unpacked);
+    }
+
+    template <typename T>
+    inline T unpack_next_item_as(
+      std::enable_if_t<
+        (sizeof(T) <= DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX),
+        darma::utility::_not_a_type_numbered<1>
+      > = { }
+    ) & {
+      std::aligned_storage_t<sizeof(T), alignof(T)> on_stack_buffer;
+      darma_unpack(allocated_buffer_for<T>(&on_stack_buffer), _archive());
+      // Destroy but don't deallocate, since the data is allocated on the stack
+      auto destroy = [this](T* ptr) {
+        _allocator_for_t<T> alloc(_archive().get_allocator());
+        std::allocator_traits<_allocator_for_t<T>>::destroy(alloc, ptr);
+      };
+      std::unique_ptr<T, decltype(destroy)> unpacked(
+        reinterpret_cast<T*>(&on_stack_buffer), destroy
+      );
+      return std::move(*unpacked);
+    }
+
+    template <typename T>
+    inline void unpack_next_item_at(void* allocated) & {
+      darma_unpack(allocated_buffer_for<T>(allocated), _archive());
+    }
+
+    /// Read the next item without copying it out of the buffer (see
+    /// ViewDeserializer).  The returned view points into the buffer being
+    /// unpacked, so it's only valid as long as that buffer is.
+    template <typename T>
+    inline view_type_t<T> unpack_next_item_as_view() & {
+      return ViewDeserializer<T>::unpack_view(_archive());
+    }
+};
+
+[[noreturn]] inline void _view_failed(char const* what) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  throw std::runtime_error(what);
+#else
+  _fatal_error(what);
+#endif
+}
+
+// bytes_available is how much of the buffer is left, if that's known
+template <typename RawDataType>
+RawDataType const* _view_data_raw(
+  char const*& data_spot, std::size_t n_items,
+  std::size_t bytes_available = std::numeric_limits<std::size_t>::max()
+) {
+  // Views hand out typed pointers straight into the buffer, so the data has to
+  // be where a RawDataType could actually live.  Whether it is depends on the
+  // layout and on what was packed before it, so this is checked in every build.
+  if(reinterpret_cast<std::uintptr_t>(data_spot) % alignof(RawDataType) != 0) {
+    _view_failed("data viewed in a serialization buffer must be suitably aligned");
+  }
+  if(n_items > bytes_available / sizeof(RawDataType)) {
+    _view_failed("data viewed in a serialization buffer runs past its end");
+  }
+  auto* rv = reinterpret_cast<RawDataType const*>(data_spot);
+  data_spot += n_items * sizeof(RawDataType);
+  return rv;
+}
+
+#if DARMA_SERIALIZATION_CHECK_PACKING
+[[noreturn]] inline void _packing_check_failed(
+  char const* what, std::size_t expected, std::size_t actual
+) {
+  char message[256];
+  std::snprintf(message, sizeof(message),
+    "%s (%zu bytes expected, %zu packed); a compute_size()"
+    " probably doesn't match its pack()", what, expected, actual
+  );
+  _fatal_error(message);
+}
+#endif
+
+} // end namespace detail
+
+template <typename Layout=PackedLayout>
+class BasicSimpleSizingArchive {
   protected:
 
     std::size_t size_ = 0;
+    detail::LazyObjectIdentityTable<detail::PackingObjectIdentityTable> object_identities_;
 
-    SimpleSizingArchive() = default;
+    BasicSimpleSizingArchive() = default;
 
-    template <typename>
+    template <typename, typename>
     friend struct SimpleSerializationHandler;
 
   private:
@@ -87,14 +263,28 @@ class SimpleSizingArchive {
     using is_sizing_archive_t = std::true_type;
     using is_archive_t = std::true_type;
 
+    using layout_type = Layout;
+
     static constexpr bool is_sizing() { return true; }
     static constexpr bool is_packing() { return false; }
     static constexpr bool is_unpacking() { return false; }
 
+    /// Add size bytes that don't need any alignment.  Use the iterator version
+    /// (or the add_to_size_raw(ar, begin, end) helper) for anything else.
     void add_to_size_raw(size_t size) {
       size_ += size;
     }
 
+    /// The size that pack_data_raw(begin, end) will take up, with padding
+    template <typename ContiguousIterator>
+    void add_to_size_raw(ContiguousIterator begin, ContiguousIterator end) {
+      using value_type =
+        std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+      auto n_items = static_cast<size_t>(std::distance(begin, end));
+      size_ += Layout::template padding_for<value_type>(size_, n_items)
+        + n_items * sizeof(value_type);
+    }
+
     template <typename T>
     inline auto& operator|(T const& obj) & {
       return _ask_serializer_for_size(obj);
@@ -105,14 +295,24 @@ class SimpleSizingArchive {
       return _ask_serializer_for_size(obj);
     }
 
+    /// Ids of the objects packed through shared pointers so far (see
+    /// serializers/standard_library/shared_ptr.h)
+    detail::PackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+
 };
 
-template <typename SerializationBuffer=DynamicSerializationBuffer<std::allocator<char>>>
+using SimpleSizingArchive = BasicSimpleSizingArchive<>;
+
+template <
+  typename SerializationBuffer=DynamicSerializationBuffer<std::allocator<char>>,
+  typename Layout=PackedLayout
+>
 class SimplePackingArchive {
   protected:
 
     char* data_spot_ = nullptr;
     SerializationBuffer buffer_;
+    detail::LazyObjectIdentityTable<detail::PackingObjectIdentityTable> object_identities_;
 
     template <typename BufferT>
     explicit SimplePackingArchive(BufferT&& buffer)
@@ -121,9 +321,37 @@ class SimplePackingArchive {
 
     char*& _data_spot() { return data_spot_; }
 
-    template <typename>
+    template <typename, typename>
     friend struct SimpleSerializationHandler;
 
+    // The checks compile to nothing unless DARMA_SERIALIZATION_CHECK_PACKING
+
+    void _check_capacity(std::size_t n_bytes) const {
+#if DARMA_SERIALIZATION_CHECK_PACKING
+      auto const packed = static_cast<std::size_t>(data_spot_ - buffer_.data());
+      if(n_bytes > buffer_.capacity() - packed) {
+        detail::_packing_check_failed("packing ran past the end of the buffer",
+          buffer_.capacity(), packed + n_bytes
+        );
+      }
+#else
+      (void)n_bytes;
+#endif
+    }
+
+    void _check_packed_size(std::size_t expected) const {
+#if DARMA_SERIALIZATION_CHECK_PACKING
+      auto const packed = static_cast<std::size_t>(data_spot_ - buffer_.data());
+      if(packed != expected) {
+        detail::_packing_check_failed("packed size doesn't match the sizing pass",
+          expected, packed
+        );
+      }
+#else
+      (void)expected;
+#endif
+    }
+
   private:
 
     template <typename T>
@@ -132,12 +360,27 @@ class SimplePackingArchive {
       return *this;
     }
 
+    template <typename RawDataType>
+    void _pad_for(size_t n_items) {
+      auto padding = Layout::template padding_for<RawDataType>(
+        data_spot_ - buffer_.data(), n_items
+      );
+      _check_capacity(padding + n_items * sizeof(RawDataType));
+      if(padding != 0) {
+        // Zeroed so that the packed bytes are deterministic
+        std::memset(data_spot_, 0, padding);
+        data_spot_ += padding;
+      }
+    }
+
   public:
 
     // Concept "shortcut" tag
     using is_packing_archive_t = std::true_type;
     using is_archive_t = std::true_type;
 
+    using layout_type = Layout;
+
     static constexpr bool is_sizing() { return false; }
     static constexpr bool is_packing() { return true; }
     static constexpr bool is_unpacking() { return false; }
@@ -146,11 +389,137 @@ class SimplePackingArchive {
     void pack_data_raw(ContiguousIterator begin, ContiguousIterator end) {
       using value_type =
         std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+      auto n_items = static_cast<size_t>(std::distance(begin, end));
+      _pad_for<value_type>(n_items);
       // std::copy(begin, end, reinterpret_cast<value_type*>(data_spot_));
       // Use memcpy, since copy invokes the assignment operator, and "raw"
-      // implies that this isn't necessary
-      auto size = std::distance(begin, end) * sizeof(value_type);
-      std::memcpy(data_spot_, static_cast<void const*>(begin), size);
+      // implies that this isn't necessary (unless the layout needs the bytes
+      // swapped, in which case this is still a straight copy on the wire side)
+      detail::copy_raw_data<layout_byte_order_t<Layout>, value_type>(
+        data_spot_, static_cast<void const*>(begin), n_items
+      );
+      data_spot_ += n_items * sizeof(value_type);
+    }
+
+    template <typename T>
+    inline auto& operator|(T const& obj) & {
+      return _ask_serializer_to_pack(obj);
+    }
+
+    template <typename T>
+    inline auto& operator<<(T const& obj) & {
+      return _ask_serializer_to_pack(obj);
+    }
+
+    /// Pack value as a varint (see pack_varint()), encoding it straight into
+    /// the buffer
+    void pack_varint(std::uint64_t value) {
+      _check_capacity(detail::varint_size(value));
+      data_spot_ += detail::encode_varint(
+        value, reinterpret_cast<unsigned char*>(data_spot_)
+      );
+    }
+
+    /// The spot where the next item will be packed, for serializers that write
+    /// into the buffer directly (without any padding)
+    void*& data_pointer_reference() { return *reinterpret_cast<void**>(&data_spot_); }
+
+#if DARMA_SERIALIZATION_CHECK_PACKING
+    /// For serializers that write through data_pointer_reference(): check
+    /// that n_bytes more fit in the buffer.  Only there when
+    /// DARMA_SERIALIZATION_CHECK_PACKING is on, so that serializers that have
+    /// to work out n_bytes (e.g., polymorphic objects) only do it then.
+    void check_capacity(std::size_t n_bytes) const { _check_capacity(n_bytes); }
+#endif
+
+    /// Ids of the objects packed through shared pointers so far (see
+    /// serializers/standard_library/shared_ptr.h)
+    detail::PackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+
+};
+
+/// A packing archive that grows its buffer as it goes, so that objects can be
+/// packed without a sizing pass first.  It doesn't expose its data spot, since
+/// anything writing through it directly would bypass the capacity check.
+template <
+  typename GrowableBuffer=GrowableSerializationBuffer<std::allocator<char>>,
+  typename Layout=PackedLayout
+>
+class GrowablePackingArchive {
+  protected:
+
+    char* data_spot_ = nullptr;
+    char* data_end_ = nullptr;
+    GrowableBuffer buffer_;
+    detail::LazyObjectIdentityTable<detail::PackingObjectIdentityTable> object_identities_;
+
+    template <typename BufferT>
+    explicit GrowablePackingArchive(BufferT&& buffer)
+      : buffer_(std::forward<BufferT>(buffer))
+    {
+      // Pack after anything that's already in the buffer
+      data_spot_ = buffer_.data() + buffer_.size();
+      data_end_ = buffer_.data() + buffer_.capacity();
+    }
+
+    // Record the bytes packed so far as the buffer's size
+    void _commit_size() {
+      buffer_.resize(data_spot_ - buffer_.data());
+    }
+
+    template <typename, typename>
+    friend struct SimpleSerializationHandler;
+
+  private:
+
+    template <typename T>
+    inline auto& _ask_serializer_to_pack(T const& obj) & {
+      darma_pack(obj, *this);
+      return *this;
+    }
+
+    // Kept out of line so that the common (non-growing) path in pack_data_raw
+    // stays small enough to inline
+    void _grow_to_fit(size_t additional_size) {
+      auto offset = static_cast<size_t>(data_spot_ - buffer_.data());
+      _commit_size();
+      buffer_.reserve(std::max(2 * buffer_.capacity(), offset + additional_size));
+      data_spot_ = buffer_.data() + offset;
+      data_end_ = buffer_.data() + buffer_.capacity();
+    }
+
+  public:
+
+    // Concept "shortcut" tag
+    using is_packing_archive_t = std::true_type;
+    using is_archive_t = std::true_type;
+
+    using layout_type = Layout;
+
+    static constexpr bool is_sizing() { return false; }
+    static constexpr bool is_packing() { return true; }
+    static constexpr bool is_unpacking() { return false; }
+
+    template <typename ContiguousIterator>
+    void pack_data_raw(ContiguousIterator begin, ContiguousIterator end) {
+      using value_type =
+        std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+      auto n_items = static_cast<size_t>(std::distance(begin, end));
+      // Padding depends only on the offset, which growing doesn't change
+      auto padding = Layout::template padding_for<value_type>(
+        data_spot_ - buffer_.data(), n_items
+      );
+      auto size = n_items * sizeof(value_type);
+      if(static_cast<size_t>(data_end_ - data_spot_) < padding + size) {
+        _grow_to_fit(padding + size);
+      }
+      if(padding != 0) {
+        std::memset(data_spot_, 0, padding);
+        data_spot_ += padding;
+      }
+      detail::copy_raw_data<layout_byte_order_t<Layout>, value_type>(
+        data_spot_, static_cast<void const*>(begin), n_items
+      );
       data_spot_ += size;
     }
 
@@ -164,10 +533,18 @@ class SimplePackingArchive {
       return _ask_serializer_to_pack(obj);
     }
 
+    /// Ids of the objects packed through shared pointers so far (see
+    /// serializers/standard_library/shared_ptr.h)
+    detail::PackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+
 };
 
-template <typename Allocator=std::allocator<char>>
-class SimpleUnpackingArchive {
+template <typename Allocator=std::allocator<char>, typename Layout=PackedLayout>
+class SimpleUnpackingArchive
+  : public detail::UnpackingArchiveMixin<
+      SimpleUnpackingArchive<Allocator, Layout>, Allocator
+    >
+{
   public:
 
     // Concept "shortcut" tag
@@ -179,6 +556,11 @@ class SimpleUnpackingArchive {
   protected:
 
     darma::utility::compressed_pair<char const*, allocator_type> data_spot_;
+    // Padding is relative to the start of the buffer
+    char const* buffer_begin_;
+    // Bounds how far ahead unpack_varint() can read
+    std::size_t buffer_size_;
+    detail::LazyObjectIdentityTable<detail::UnpackingObjectIdentityTable> object_identities_;
 
     template <typename BufferT>
     explicit SimpleUnpackingArchive(
@@ -187,14 +569,23 @@ class SimpleUnpackingArchive {
           std::piecewise_construct,
           std::forward_as_tuple(buffer.data()),
           std::forward_as_tuple(alloc)
-        )
+        ),
+        buffer_begin_(buffer.data()),
+        buffer_size_(buffer.capacity())
     { }
 
     char const*& _data_spot() { return data_spot_.first(); }
 
-    template <typename>
+    template <typename, typename>
     friend struct SimpleSerializationHandler;
 
+    template <typename RawDataType>
+    void _skip_padding_for(size_t n_items) {
+      data_spot_.first() += Layout::template padding_for<RawDataType>(
+        data_spot_.first() - buffer_begin_, n_items
+      );
+    }
+
   private:
 
     template <typename T>
@@ -238,20 +629,51 @@ class SimpleUnpackingArchive {
 
     // TODO Generate an iterator? (Maybe not for all types of archives)
 
+    using layout_type = Layout;
+
     static constexpr bool is_sizing() { return false; }
     static constexpr bool is_packing() { return false; }
     static constexpr bool is_unpacking() { return true; }
 
     template <typename RawDataType>
     void unpack_data_raw(void* allocated_dest, size_t n_items = 1) {
-      std::memcpy(
-        allocated_dest,
-        data_spot_.first(),
-        n_items * sizeof(RawDataType)
+      _skip_padding_for<std::remove_const_t<RawDataType>>(n_items);
+      detail::copy_raw_data<layout_byte_order_t<Layout>, std::remove_const_t<RawDataType>>(
+        allocated_dest, data_spot_.first(), n_items
       );
       data_spot_.first() += n_items * sizeof(RawDataType);
     }
 
+    /// Unpack a varint packed by pack_varint(), decoding it in place.  Short
+    /// varints are decoded with a single eight-byte load when the buffer's
+    /// capacity() says there's room for one.  A capacity() of SIZE_MAX (e.g.,
+    /// a ConstNonOwningSerializationBuffer made from just a pointer) means the
+    /// size is unknown, so those are decoded a byte at a time.
+    std::uint64_t unpack_varint() {
+      if(buffer_size_ == std::numeric_limits<std::size_t>::max()) {
+        return detail::decode_varint(data_spot_.first(), 0);
+      }
+      auto const offset = static_cast<std::size_t>(data_spot_.first() - buffer_begin_);
+      return detail::decode_varint(data_spot_.first(), buffer_size_ - offset);
+    }
+
+    /// Like unpack_data_raw(), but returns a pointer to the data in the buffer
+    /// rather than copying it out.  Data that isn't aligned for RawDataType, or
+    /// that runs past the end of the buffer, throws a std::runtime_error (or
+    /// aborts, without exceptions).
+    template <typename RawDataType>
+    RawDataType const* view_data_raw(size_t n_items = 1) {
+      static_assert(
+        not detail::swaps_bytes<layout_byte_order_t<Layout>, RawDataType>::value,
+        "raw data stored in a byte order other than the host's can't be viewed in place"
+      );
+      _skip_padding_for<std::remove_const_t<RawDataType>>(n_items);
+      auto const offset = static_cast<std::size_t>(data_spot_.first() - buffer_begin_);
+      return detail::_view_data_raw<std::remove_const_t<RawDataType>>(
+        data_spot_.first(), n_items,
+        offset <= buffer_size_ ? buffer_size_ - offset : 0
+      );
+    }
 
 
     template <typename T>
@@ -264,54 +686,6 @@ class SimpleUnpackingArchive {
       return _ask_serializer_to_unpack(obj);
     }
 
-    // TODO move these to a mixin so code isn't duplicated between this and PointerReference*Archive?
-
-    template <typename T>
-    inline T unpack_next_item_as(
-      std::enable_if_t<
-        (sizeof(T) > DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX),
-        darma::utility::_not_a_type_numbered<0>
-      > = { }
-    ) & {
-      using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
-      auto alloc = allocator_t(get_allocator());
-      auto* storage = std::allocator_traits<allocator_t>::allocate(
-        alloc, 1
-      );
-      darma_unpack(allocated_buffer_for<T>(storage), *this);
-      // Use a unique_ptr to delete the temporary storage after returning
-      std::unique_ptr<T> raii_holder(*reinterpret_cast<T*>(storage));
-      return *raii_holder.get();
-    }
-
-    template <typename T>
-    inline T unpack_next_item_as(
-      std::enable_if_t<
-        (sizeof(T) <= DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX),
-        darma::utility::_not_a_type_numbered<1>
-      > = { }
-    ) & {
-      char on_stack_buffer[sizeof(T)];
-      darma_unpack(allocated_buffer_for<T>(on_stack_buffer), *this);
-      // Use a unique_ptr to delete the temporary storage after returning
-      auto destroy_but_not_delete = [this](auto* ptr) {
-        using allocator_t = typename std::allocator_traits<allocator_type>::template rebind_alloc<T>;
-        allocator_t alloc{this->get_allocator()};
-        // Destroy but don't deallocate, since the data is allocated on the stack
-        std::allocator_traits<allocator_t>::destroy(alloc, ptr);
-      };
-      std::unique_ptr<T, decltype(destroy_but_not_delete)> raii_destroy(
-        reinterpret_cast<T*>(on_stack_buffer),
-        destroy_but_not_delete
-      );
-      return *raii_destroy.get();
-    }
-
-    template <typename T>
-    inline void unpack_next_item_at(void* allocated) & {
-      darma_unpack(allocated_buffer_for<T>(allocated), *this);
-    }
-
     auto const& get_allocator() const {
       return data_spot_.second();
     }
@@ -321,9 +695,16 @@ class SimpleUnpackingArchive {
 
     template <typename NeededAllocatorT>
     NeededAllocatorT get_allocator_as() const {
-      // Let's hope this is a compatible type
-      return data_spot_.second();
+      return detail::get_allocator_as<NeededAllocatorT>(data_spot_.second());
     }
+
+    /// The spot where the next item will be unpacked from, for serializers that
+    /// read from the buffer directly
+    void const*& data_pointer_reference() { return *reinterpret_cast<void const**>(&data_spot_.first()); }
+
+    /// Objects unpacked through shared pointers so far (see
+    /// serializers/standard_library/shared_ptr.h)
+    detail::UnpackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
 };
 
 } // end namespace serialization
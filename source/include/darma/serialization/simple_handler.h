@@ -47,22 +47,34 @@
 
 #include <darma/utility/not_a_type.h>
 
+#include <darma/serialization/allocators/over_aligned_allocator.h>
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/wire_layout.h>
+
 #include "simple_archive.h"
+#include "checked_archive.h"
+#include "scatter_gather_archive.h"
+#include "mapped_file_serialization_buffer.h"
 #include "archive_concept.h"
 #include "simple_handler_fwd.h"
 #include "pointer_reference_handler_fwd.h"
+#include "streaming_handler_fwd.h"
 #include "archive_concept.h"
 
 namespace darma {
 namespace serialization {
 
-/// A simple, allocator-aware serialization handler that only works with stateless allocators
-template <typename Allocator>
+/// A simple, allocator-aware serialization handler.  Stateful allocators (e.g.,
+/// a MonotonicArenaAllocator) can be given to the unpacking side, in which case
+/// they're passed along to the serializers through the archive's
+/// get_allocator_as().  Layout controls the padding around raw data (see
+/// PackedLayout and AlignedLayout); both sides have to use the same one.
+template <typename Allocator, typename Layout>
 struct SimpleSerializationHandler {
 
   private:
 
-    using this_t = SimpleSerializationHandler<Allocator>;
+    using this_t = SimpleSerializationHandler<Allocator, Layout>;
 
     using char_allocator_t =
       typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
@@ -89,13 +101,11 @@ struct SimpleSerializationHandler {
       this_t::_apply_pack_recursively(ar, rest...);
     };
 
-    static_assert(std::is_empty<Allocator>::value,
-      "SimpleSerializationHandler only works with stateless Allocators"
-    );
-
-    using sizing_archive_t = SimpleSizingArchive;
-    using unpacking_archive_t = SimpleUnpackingArchive<Allocator>;
+    using sizing_archive_t = BasicSimpleSizingArchive<Layout>;
+    using unpacking_archive_t = SimpleUnpackingArchive<char_allocator_t, Layout>;
     using serialization_buffer_t = DynamicSerializationBuffer<char_allocator_t>;
+    using growable_serialization_buffer_t = GrowableSerializationBuffer<char_allocator_t>;
+    using packing_archive_t = SimplePackingArchive<serialization_buffer_t, Layout>;
 
     // Not part of the interface; only applicable to SimpleSerializationHandler
     // Used by PointerReferenceSerializationHandler to adapt from archive types
@@ -124,22 +134,37 @@ struct SimpleSerializationHandler {
       >(*reinterpret_cast<T const**>(&const_cast<char const*&>(ar._data_spot())));
     }
 
+#ifdef DARMA_SERIALIZATION_HAS_MMAP
+    [[noreturn]] static void _file_too_short() {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      throw std::system_error(make_error_code(unpacking_errc::buffer_overrun));
+#else
+      detail::_fatal_error("serialization file ends before the object does");
+#endif
+    }
+#endif
+
     template <typename>
     friend struct PointerReferenceSerializationHandler;
 
+    template <typename>
+    friend struct StreamingSerializationHandler;
+
   public:
 
+    using layout_type = Layout;
+
     template <typename SizingArchive>
     static constexpr auto compatible_sizing_archive_v =
-      std::is_same<SizingArchive, SimpleSizingArchive>::value;
+      std::is_same<SizingArchive, sizing_archive_t>::value;
 
     template <typename PackingArchive>
     static constexpr auto compatible_packing_archive_v =
-      std::is_same<PackingArchive, SimplePackingArchive<>>::value;
+      std::is_same<PackingArchive, packing_archive_t>::value;
 
     template <typename UnpackingArchive>
     static constexpr auto compatible_unpacking_archive_v =
-      std::is_same<UnpackingArchive, SimpleUnpackingArchive<Allocator>>::value;
+      std::is_same<UnpackingArchive, unpacking_archive_t>::value;
 
 
     //==========================================================================
@@ -147,7 +172,7 @@ struct SimpleSerializationHandler {
 
     static auto
     make_sizing_archive() {
-      return SimpleSizingArchive{};
+      return sizing_archive_t{};
     }
 
     template <typename CompatibleSizingArchive>
@@ -157,7 +182,7 @@ struct SimpleSerializationHandler {
       std::enable_if_t<
         std::is_rvalue_reference<CompatibleSizingArchive&&>::value
         // Only the simple one is compatible for now:
-        and std::is_same<SimpleSizingArchive, CompatibleSizingArchive>::value,
+        and std::is_same<sizing_archive_t, CompatibleSizingArchive>::value,
         darma::utility::_not_a_type
       > = { }
     ) {
@@ -169,7 +194,14 @@ struct SimpleSerializationHandler {
     static auto
     make_packing_archive(size_t size) {
       serialization_buffer_t buffer(size);
-      return SimplePackingArchive<serialization_buffer_t>(std::move(buffer));
+      return packing_archive_t(std::move(buffer));
+    }
+
+    static auto
+    make_packing_archive(size_t size, Allocator const& alloc) {
+      char_allocator_t char_alloc(alloc);
+      serialization_buffer_t buffer(size, char_alloc);
+      return packing_archive_t(std::move(buffer));
     }
 
     template <typename SerializationBuffer>
@@ -183,13 +215,73 @@ struct SimpleSerializationHandler {
         darma::utility::_not_a_type
       > = { }
     ) {
-      return SimplePackingArchive<std::decay_t<SerializationBuffer>>(std::move(buffer));
+      return SimplePackingArchive<std::decay_t<SerializationBuffer>, Layout>(
+        std::move(buffer)
+      );
+    }
+
+    static auto
+    make_growable_packing_archive(
+      size_t initial_capacity = DARMA_SERIALIZATION_GROWABLE_BUFFER_INITIAL_CAPACITY
+    ) {
+      return GrowablePackingArchive<growable_serialization_buffer_t, Layout>(
+        growable_serialization_buffer_t(initial_capacity)
+      );
+    }
+
+    /// See ScatterGatherPackingArchive.  Its wire format is the packed one, so
+    /// this is only available with PackedLayout.  A min_external_size below
+    /// the archive's min_external_size_floor is raised to it.
+    static auto
+    make_scatter_gather_packing_archive(
+      size_t min_external_size = DARMA_SERIALIZATION_SCATTER_GATHER_MIN_EXTERNAL_SIZE,
+      size_t initial_capacity = DARMA_SERIALIZATION_GROWABLE_BUFFER_INITIAL_CAPACITY
+    ) {
+      static_assert(std::is_same<Layout, PackedLayout>::value,
+        "scatter-gather packing only supports the packed wire layout"
+      );
+      return ScatterGatherPackingArchive<char_allocator_t>(
+        growable_serialization_buffer_t(initial_capacity), min_external_size
+      );
     }
 
     template <typename SerializationBuffer>
     static auto
     make_unpacking_archive(SerializationBuffer const& buffer) {
-      return SimpleUnpackingArchive<char_allocator_t>(buffer, char_allocator_t{});
+      return unpacking_archive_t(buffer, char_allocator_t{});
+    }
+
+    template <typename SerializationBuffer>
+    static auto
+    make_unpacking_archive(
+      SerializationBuffer const& buffer, Allocator const& alloc
+    ) {
+      return unpacking_archive_t(buffer, char_allocator_t(alloc));
+    }
+
+    /// See CheckedUnpackingArchive.  If throws is false, errors are only
+    /// recorded in the archive's error().  A throwing archive leaks whatever
+    /// was unpacked before the error (there's no way to destroy half an
+    /// object), so deserialize_checked() unpacks without throwing and throws
+    /// afterwards instead.
+    template <typename SerializationBuffer>
+    static auto
+    make_checked_unpacking_archive(
+      SerializationBuffer const& buffer, bool throws = true
+    ) {
+      return CheckedUnpackingArchive<char_allocator_t, Layout>(
+        buffer, char_allocator_t{}, throws
+      );
+    }
+
+    template <typename SerializationBuffer>
+    static auto
+    make_checked_unpacking_archive(
+      SerializationBuffer const& buffer, Allocator const& alloc, bool throws = true
+    ) {
+      return CheckedUnpackingArchive<char_allocator_t, Layout>(
+        buffer, char_allocator_t(alloc), throws
+      );
     }
 
     // </editor-fold> end archive creation }}}1
@@ -215,6 +307,20 @@ struct SimpleSerializationHandler {
       return std::move(ar.buffer_);
     }
 
+    template <typename GrowableBuffer, typename ArchiveLayout>
+    static GrowableBuffer
+    extract_buffer(GrowablePackingArchive<GrowableBuffer, ArchiveLayout>&& ar) {
+      ar._commit_size();
+      ar.data_spot_ = ar.data_end_ = nullptr;  // As part of expiring the Archive
+      return std::move(ar.buffer_);
+    }
+
+    template <typename ArchiveAllocator>
+    static ScatterGatherSerializationBuffer<ArchiveAllocator>
+    extract_buffer(ScatterGatherPackingArchive<ArchiveAllocator>&& ar) {
+      return ar._extract();
+    }
+
     template <typename CompatiblePackingOrUnpackingArchive>
     /* requires requires(CompatibleUnpackingArchive a) { a._data_spot() => char*; } */
     static char*
@@ -239,9 +345,94 @@ struct SimpleSerializationHandler {
       }
       auto p_ar = this_t::make_packing_archive(size);
       this_t::_apply_pack_recursively(p_ar, objects...);
+      p_ar._check_packed_size(size);
       return this_t::extract_buffer(std::move(p_ar));
     }
 
+    /// Same as serialize(), but with the buffer allocated from (and returned
+    /// to, when it's destroyed) alloc; e.g., a PooledSerializationBufferAllocator
+    /// for a specific SerializationBufferPool
+    template <typename... Ts>
+    static
+    serialization_buffer_t
+    serialize_with_allocator(Allocator const& alloc, Ts const&... objects) {
+      size_t size;
+      {
+        auto s_ar = this_t::make_sizing_archive();
+        this_t::_apply_compute_size_recursively(s_ar, objects...);
+        size = this_t::get_size(s_ar);
+      }
+      auto p_ar = this_t::make_packing_archive(size, alloc);
+      this_t::_apply_pack_recursively(p_ar, objects...);
+      p_ar._check_packed_size(size);
+      return this_t::extract_buffer(std::move(p_ar));
+    }
+
+    /// Pack the objects in one traversal, growing the buffer as needed instead
+    /// of sizing them first.  This is usually faster for pointer-heavy types
+    /// (maps, lists, nested containers of strings), where the sizing pass costs
+    /// almost as much as packing.  The returned buffer's size() is the number
+    /// of bytes packed; its capacity() may be larger.
+    template <typename... Ts>
+    static
+    growable_serialization_buffer_t
+    serialize_single_pass(Ts const&... objects) {
+      auto p_ar = this_t::make_growable_packing_archive();
+      this_t::_apply_pack_recursively(p_ar, objects...);
+      return this_t::extract_buffer(std::move(p_ar));
+    }
+
+    /// Pack the objects without copying raw data of at least min_external_size
+    /// bytes (e.g., the contents of a large std::vector<double>); the result
+    /// refers to it instead, so the objects must outlive the returned buffer
+    /// (see ScatterGatherSerializationBuffer).  The segments, concatenated, can
+    /// be deserialize()d as usual.
+    template <typename... Ts>
+    static
+    ScatterGatherSerializationBuffer<char_allocator_t>
+    serialize_scatter_gather(Ts const&... objects) {
+      auto p_ar = this_t::make_scatter_gather_packing_archive();
+      this_t::_apply_pack_recursively(p_ar, objects...);
+      return this_t::extract_buffer(std::move(p_ar));
+    }
+
+    template <typename... Ts>
+    static
+    ScatterGatherSerializationBuffer<char_allocator_t>
+    serialize_scatter_gather_with_min_external_size(
+      size_t min_external_size, Ts const&... objects
+    ) {
+      auto p_ar = this_t::make_scatter_gather_packing_archive(min_external_size);
+      this_t::_apply_pack_recursively(p_ar, objects...);
+      return this_t::extract_buffer(std::move(p_ar));
+    }
+
+#ifdef DARMA_SERIALIZATION_HAS_MMAP
+    /// Pack the objects into the file at path (created or truncated, and sized
+    /// exactly from the sizing pass) through a memory mapping, for
+    /// checkpointing.  Call sync() on the result to wait for the data to reach
+    /// the disk.  See MappedFileSerializationBuffer.
+    template <typename... Ts>
+    static
+    MappedFileSerializationBuffer
+    serialize_to_file(
+      std::string const& path, MappedFileHints const& hints, Ts const&... objects
+    ) {
+      size_t size;
+      {
+        auto s_ar = this_t::make_sizing_archive();
+        this_t::_apply_compute_size_recursively(s_ar, objects...);
+        size = this_t::get_size(s_ar);
+      }
+      auto p_ar = this_t::make_packing_archive(
+        MappedFileSerializationBuffer(path, size, hints)
+      );
+      this_t::_apply_pack_recursively(p_ar, objects...);
+      p_ar._check_packed_size(size);
+      return this_t::extract_buffer(std::move(p_ar));
+    }
+#endif
+
     // </editor-fold> end serialize() overloads }}}1
     //==========================================================================
 
@@ -251,14 +442,7 @@ struct SimpleSerializationHandler {
 
     template <typename T, typename SerializationBuffer>
     static T deserialize(SerializationBuffer const& buffer) {
-      using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
-      allocator_t alloc{};
-      auto* dest = std::allocator_traits<allocator_t>::allocate(alloc, 1);
-      this_t::template deserialize<T>(buffer, dest);
-      auto rv = std::move(*dest);
-      std::allocator_traits<allocator_t>::destroy(alloc, dest);
-      std::allocator_traits<allocator_t>::deallocate(alloc, dest, 1);
-      return rv;
+      return this_t::template deserialize<T>(buffer, Allocator{});
     }
 
     template <typename T, typename SerializationBuffer>
@@ -269,13 +453,157 @@ struct SimpleSerializationHandler {
       darma_unpack<T>(destination, ar);
     }
 
+    /// Deserialize a T, giving alloc to the serializers of T and anything it
+    /// contains (via get_allocator_as()) for the memory they need
+    template <typename T, typename SerializationBuffer>
+    static T deserialize(SerializationBuffer const& buffer, Allocator const& alloc) {
+      using allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+      using traits_t = std::allocator_traits<allocator_t>;
+      allocator_t t_alloc(alloc);
+      auto deallocate = [&t_alloc](T* ptr) { traits_t::deallocate(t_alloc, ptr, 1); };
+      std::unique_ptr<T, decltype(deallocate)> dest(
+        traits_t::allocate(t_alloc, 1), deallocate
+      );
+      this_t::template deserialize<T>(buffer, dest.get(), alloc);
+      // Destroyed before the storage is deallocated
+      auto destroy = [&t_alloc](T* ptr) { traits_t::destroy(t_alloc, ptr); };
+      std::unique_ptr<T, decltype(destroy)> unpacked(dest.get(), destroy);
+      return std::move(*unpacked);
+    }
+
+    template <typename T, typename SerializationBuffer>
+    static void
+    deserialize(
+      SerializationBuffer const& buffer, void* destination, Allocator const& alloc
+    ) {
+      auto ar = this_t::make_unpacking_archive(buffer, alloc);
+      // invoke the customization point as an unqualified name, allowing ADL
+      darma_unpack<T>(destination, ar);
+    }
+
+    /// Like deserialize(), but for buffers that can't be trusted (see
+    /// CheckedUnpackingArchive): running past the end of the buffer throws a
+    /// std::system_error with unpacking_errc::buffer_overrun, rather than
+    /// reading whatever memory follows it
+    template <typename T, typename SerializationBuffer>
+    static T deserialize_checked(SerializationBuffer const& buffer) {
+      // Unpacking finishes (with zeros) before anything is thrown, so that rv
+      // is a whole object, and is destroyed on the way out
+      auto ar = this_t::make_checked_unpacking_archive(buffer, false);
+      auto rv = ar.template unpack_next_item_as<T>();
+      if(ar.error()) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+        throw std::system_error(ar.error());
+#else
+        detail::_fatal_error("unpacking untrusted data failed: " + ar.error().message());
+#endif
+      }
+      return rv;
+    }
+
+    /// Like deserialize_checked(), but doesn't throw (and works without
+    /// exceptions): an overrun is reported in error, and the T returned is
+    /// whatever could be unpacked, with zeros for the data that was missing
+    template <typename T, typename SerializationBuffer>
+    static T deserialize_checked(
+      SerializationBuffer const& buffer, std::error_code& error
+    ) {
+      auto ar = this_t::make_checked_unpacking_archive(buffer, false);
+      auto rv = ar.template unpack_next_item_as<T>();
+      error = ar.error();
+      return rv;
+    }
+
+#ifdef DARMA_SERIALIZATION_HAS_MMAP
+    /// Deserialize a T from a file written by serialize_to_file() (or anything
+    /// else containing a packed T), unpacking straight from its memory mapping
+    /// rather than read()ing it into a buffer first.  An empty file, or one that
+    /// turns out to end before the T does, throws a std::system_error with
+    /// unpacking_errc::buffer_overrun (or aborts, without exceptions).  The
+    /// size is checked before and after unpacking rather than on every read,
+    /// so a file cut short by more than what's left of its last page can
+    /// still fault; for files that can't be trusted, read them into a buffer
+    /// and use deserialize_checked() instead.
+    template <typename T>
+    static T deserialize_from_file(
+      std::string const& path, MappedFileHints const& hints = MappedFileHints{}
+    ) {
+      MappedFileSerializationBuffer const buffer(path, hints);
+      if(buffer.capacity() == 0) _file_too_short();
+      auto ar = this_t::make_unpacking_archive(buffer);
+      auto rv = ar.template unpack_next_item_as<T>();
+      // The mapping reads as zeros past the end of the file, up to the end of
+      // its last page
+      auto const* end = static_cast<char const*>(ar.data_pointer_reference());
+      if(end > buffer.data() + buffer.capacity()) _file_too_short();
+      return rv;
+    }
+#endif
+
+    /// Read a T from the start of buffer without copying it out (e.g., an
+    /// ArrayView<double> for a std::vector<double>; see ViewDeserializer).  The
+    /// view points into buffer, so buffer has to outlive it.  The viewed data
+    /// has to be aligned for its element type, which only the padding layouts
+    /// (e.g., AlignedSerializationHandler) guarantee; with other layouts it
+    /// depends on what was packed before it.  Misaligned data, or data that
+    /// runs past the end of buffer, throws a std::runtime_error (or aborts,
+    /// without exceptions) rather than handing out an unusable view.
+    template <typename T, typename SerializationBuffer>
+    static view_type_t<T>
+    deserialize_view(SerializationBuffer const& buffer) {
+      auto ar = this_t::make_unpacking_archive(buffer);
+      return ar.template unpack_next_item_as_view<T>();
+    }
+
+    // The view would dangle as soon as the temporary buffer is destroyed
+    template <typename T, typename SerializationBuffer>
+    static void deserialize_view(SerializationBuffer const&& buffer) = delete;
+
     // </editor-fold> end deserialize() overloads }}}1
     //==========================================================================
 
 
 };
 
-
+/// A SimpleSerializationHandler whose buffers are allocated with, and whose
+/// raw data is packed at offsets aligned for, in-place access (e.g., through
+/// deserialize_view()) and aligned vector loads.  The wire format differs from
+/// the default handler's, so both ends must use the same parameters.
+template <
+  std::size_t LargeArrayAlignment = DARMA_SERIALIZATION_LARGE_ARRAY_ALIGNMENT,
+  std::size_t LargeArrayMinSize = DARMA_SERIALIZATION_LARGE_ARRAY_MIN_SIZE
+>
+using AlignedSerializationHandler = SimpleSerializationHandler<
+  OverAlignedAllocator<char, LargeArrayAlignment>,
+  AlignedLayout<LargeArrayAlignment, LargeArrayMinSize>
+>;
+
+/// A SimpleSerializationHandler that writes container sizes (and, with
+/// VarintIntegers, all integers) as varints (see VarintLayout).  Messages of
+/// many small strings and containers get much smaller, at the cost of a little
+/// encoding and decoding work per size.  The wire format differs from the
+/// default handler's, so both ends must use the same IntegerEncoding.
+template <
+  typename IntegerEncoding = VarintSizes,
+  typename Allocator = std::allocator<char>
+>
+using VarintSerializationHandler = SimpleSerializationHandler<
+  Allocator, VarintLayout<IntegerEncoding>
+>;
+
+/// A SimpleSerializationHandler whose buffers can be unpacked on a host with
+/// either byte order: raw data is stored in WireOrder (see PortableLayout).
+/// When WireOrder is the host's order this costs nothing; otherwise arithmetic
+/// data is byte swapped on the way in and out, and neither views of it (e.g.,
+/// through deserialize_view()) nor polymorphic objects, which pack themselves
+/// in the host's order, are available.
+template <
+  typename WireOrder = LittleEndianByteOrder,
+  typename Allocator = std::allocator<char>
+>
+using PortableSerializationHandler = SimpleSerializationHandler<
+  Allocator, PortableLayout<WireOrder>
+>;
 
 } // end namespace serialization
 } // end namespace darma
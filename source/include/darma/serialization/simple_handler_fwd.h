@@ -50,7 +50,9 @@
 namespace darma {
 namespace serialization {
 
-template <typename Allocator=std::allocator<char>>
+struct PackedLayout;
+
+template <typename Allocator=std::allocator<char>, typename Layout=PackedLayout>
 struct SimpleSerializationHandler;
 
 } // end namespace serialization
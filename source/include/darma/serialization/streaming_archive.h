@@ -0,0 +1,489 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      streaming_archive.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_STREAMING_ARCHIVE_H
+#define DARMAFRONTEND_SERIALIZATION_STREAMING_ARCHIVE_H
+
+#include <darma/serialization/fatal_error.h>
+#include <darma/serialization/object_identity.h>
+#include <darma/serialization/serialization_traits.h>
+#include <darma/serialization/simple_archive.h>
+#include <darma/serialization/streaming_handler_fwd.h>
+#include <darma/serialization/wire_layout.h>
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+#  include <stdexcept>
+#endif
+
+#ifndef DARMA_SERIALIZATION_STREAMING_CHUNK_SIZE
+#  define DARMA_SERIALIZATION_STREAMING_CHUNK_SIZE (1 << 20)
+#endif
+// Chunks that can be packed into or waiting to be flushed at once; with more
+// than one, a background thread gives the full ones to the sink
+#ifndef DARMA_SERIALIZATION_STREAMING_N_CHUNKS
+#  define DARMA_SERIALIZATION_STREAMING_N_CHUNKS 4
+#endif
+// Size of the buffer a StreamingUnpackingArchive reads small items through
+#ifndef DARMA_SERIALIZATION_STREAMING_STAGING_SIZE
+#  define DARMA_SERIALIZATION_STREAMING_STAGING_SIZE (64 * 1024)
+#endif
+
+namespace darma {
+namespace serialization {
+
+/// Receives packed bytes, in order, from a StreamingPackingArchive (e.g., by
+/// writing them to a file descriptor or socket).  Exceptions it throws are
+/// rethrown on the packing thread.
+using streaming_sink_t = std::function<void(char const* data, std::size_t size)>;
+
+/// Gives a StreamingUnpackingArchive the next packed bytes: fills up to size
+/// bytes of dest (e.g., with a read() from a file descriptor) and returns how
+/// many it filled, which is 0 only at the end of the stream.
+using streaming_source_t = std::function<std::size_t(char* dest, std::size_t size)>;
+
+namespace detail {
+
+/// A bounded ring of chunk buffers between the packing thread and the sink.
+/// The packer fills the chunk at n_submitted_ % n_chunks, which is free as
+/// long as fewer than n_chunks chunks are waiting to be flushed; otherwise it
+/// blocks until the sink catches up, so memory use is bounded no matter how
+/// much is packed.  With a single chunk, full chunks are flushed on the packing
+/// thread instead.
+class StreamingChunkRing {
+  private:
+
+    streaming_sink_t sink_;
+    std::size_t chunk_size_;
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::vector<std::size_t> chunk_sizes_;
+
+    std::mutex mutex_;
+    std::condition_variable chunk_submitted_;
+    std::condition_variable chunk_flushed_;
+    std::size_t n_submitted_ = 0;
+    std::size_t n_flushed_ = 0;
+    bool finishing_ = false;
+    std::exception_ptr error_ = nullptr;
+    std::thread flusher_;
+
+    void _flush_loop() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while(true) {
+        chunk_submitted_.wait(lock, [this]{
+          return n_flushed_ < n_submitted_ or finishing_;
+        });
+        if(n_flushed_ == n_submitted_) return;  // finishing, and nothing left
+        auto slot = n_flushed_ % chunks_.size();
+        auto* data = chunks_[slot].get();
+        auto size = chunk_sizes_[slot];
+        bool failed = error_ != nullptr;
+        lock.unlock();
+        // After the sink fails, the rest of the chunks are just discarded
+        if(not failed) {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+          try {
+#endif
+            sink_(data, size);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+          }
+          catch(...) {
+            lock.lock();
+            error_ = std::current_exception();
+            lock.unlock();
+          }
+#endif
+        }
+        lock.lock();
+        ++n_flushed_;
+        chunk_flushed_.notify_one();
+      }
+    }
+
+    // The error stays set, so that the flusher keeps discarding chunks
+    void _rethrow_error() {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      if(error_ != nullptr) std::rethrow_exception(error_);
+#endif
+    }
+
+    void _stop_flusher() {
+      if(not flusher_.joinable()) return;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finishing_ = true;
+      }
+      chunk_submitted_.notify_one();
+      flusher_.join();
+    }
+
+  public:
+
+    StreamingChunkRing(
+      streaming_sink_t sink, std::size_t chunk_size, std::size_t n_chunks
+    ) : sink_(std::move(sink)),
+        chunk_size_(chunk_size),
+        chunks_(std::max<std::size_t>(n_chunks, 1)),
+        chunk_sizes_(chunks_.size(), 0)
+    {
+      assert(chunk_size > 0);
+      for(auto& chunk : chunks_) chunk.reset(new char[chunk_size_]);
+      if(chunks_.size() > 1) flusher_ = std::thread([this]{ _flush_loop(); });
+    }
+
+    StreamingChunkRing(StreamingChunkRing const&) = delete;
+    StreamingChunkRing& operator=(StreamingChunkRing const&) = delete;
+
+    std::size_t chunk_size() const { return chunk_size_; }
+
+    /// The chunk to pack into next; blocks while every chunk is waiting to be
+    /// flushed
+    char* acquire() {
+      if(chunks_.size() == 1) return chunks_[0].get();
+      std::unique_lock<std::mutex> lock(mutex_);
+      chunk_flushed_.wait(lock, [this]{
+        return n_submitted_ - n_flushed_ < chunks_.size();
+      });
+      _rethrow_error();
+      return chunks_[n_submitted_ % chunks_.size()].get();
+    }
+
+    /// Hand the chunk from the last acquire() to the sink, with size bytes
+    /// packed into it
+    void submit(std::size_t size) {
+      if(size == 0) return;
+      if(chunks_.size() == 1) {
+        sink_(chunks_[0].get(), size);
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        chunk_sizes_[n_submitted_ % chunks_.size()] = size;
+        ++n_submitted_;
+      }
+      chunk_submitted_.notify_one();
+    }
+
+    /// Wait for everything submitted to be flushed
+    void finish() {
+      _stop_flusher();
+      _rethrow_error();
+    }
+
+    ~StreamingChunkRing() { _stop_flusher(); }
+};
+
+} // end namespace detail
+
+/// A packing archive that writes through a bounded ring of chunk buffers to a
+/// sink, so that objects of any size can be packed (e.g., to a checkpoint
+/// file) with only chunk_size * n_chunks bytes of buffering, and without a
+/// sizing pass.  When the sink falls behind, packing blocks until it catches
+/// up.  The bytes the sink receives are the same as the packing archive of a
+/// SimpleSerializationHandler would produce; only the packed wire layout is
+/// supported.
+///
+/// Use StreamingSerializationHandler::make_streaming_packing_archive() and
+/// finish_streaming() (or just serialize_streaming()).
+class StreamingPackingArchive {
+  protected:
+
+    std::unique_ptr<detail::StreamingChunkRing> ring_;
+    char* chunk_begin_ = nullptr;
+    char* data_spot_ = nullptr;
+    char* data_end_ = nullptr;
+    std::size_t bytes_in_previous_chunks_ = 0;
+    detail::LazyObjectIdentityTable<detail::PackingObjectIdentityTable> object_identities_;
+
+    StreamingPackingArchive(
+      streaming_sink_t sink, std::size_t chunk_size, std::size_t n_chunks
+    ) : ring_(std::make_unique<detail::StreamingChunkRing>(
+          std::move(sink), chunk_size, n_chunks
+        ))
+    {
+      _start_chunk();
+    }
+
+    void _start_chunk() {
+      chunk_begin_ = data_spot_ = ring_->acquire();
+      data_end_ = chunk_begin_ + ring_->chunk_size();
+    }
+
+    // Kept out of line so that the common path in pack_data_raw stays small
+    void _next_chunk() {
+      auto size = static_cast<std::size_t>(data_spot_ - chunk_begin_);
+      ring_->submit(size);
+      bytes_in_previous_chunks_ += size;
+      _start_chunk();
+    }
+
+    /// Flush the last partial chunk and wait for the sink to receive
+    /// everything.  Returns the total number of bytes packed.
+    std::size_t _finish() {
+      auto size = static_cast<std::size_t>(data_spot_ - chunk_begin_);
+      ring_->submit(size);
+      bytes_in_previous_chunks_ += size;
+      chunk_begin_ = data_spot_ = data_end_ = nullptr;  // As part of expiring the Archive
+      ring_->finish();
+      return bytes_in_previous_chunks_;
+    }
+
+    template <typename>
+    friend struct StreamingSerializationHandler;
+
+  private:
+
+    template <typename T>
+    inline auto& _ask_serializer_to_pack(T const& obj) & {
+      darma_pack(obj, *this);
+      return *this;
+    }
+
+  public:
+
+    // Concept "shortcut" tag
+    using is_packing_archive_t = std::true_type;
+    using is_archive_t = std::true_type;
+
+    using layout_type = PackedLayout;
+
+    StreamingPackingArchive(StreamingPackingArchive&&) = default;
+
+    static constexpr bool is_sizing() { return false; }
+    static constexpr bool is_packing() { return true; }
+    static constexpr bool is_unpacking() { return false; }
+
+    template <typename ContiguousIterator>
+    void pack_data_raw(ContiguousIterator begin, ContiguousIterator end) {
+      using value_type =
+        std::remove_const_t<std::remove_reference_t<decltype(*begin)>>;
+      auto size = static_cast<std::size_t>(std::distance(begin, end)) * sizeof(value_type);
+      auto const* src = static_cast<char const*>(static_cast<void const*>(begin));
+      // Raw data can straddle chunks
+      while(size > 0) {
+        if(data_spot_ == data_end_) _next_chunk();
+        auto n = std::min(size, static_cast<std::size_t>(data_end_ - data_spot_));
+        std::memcpy(data_spot_, src, n);
+        data_spot_ += n;
+        src += n;
+        size -= n;
+      }
+    }
+
+    template <typename T>
+    inline auto& operator|(T const& obj) & {
+      return _ask_serializer_to_pack(obj);
+    }
+
+    template <typename T>
+    inline auto& operator<<(T const& obj) & {
+      return _ask_serializer_to_pack(obj);
+    }
+
+    /// Bytes packed so far (not all of which have necessarily reached the sink)
+    std::size_t bytes_packed() const {
+      return bytes_in_previous_chunks_ + (data_spot_ - chunk_begin_);
+    }
+
+    detail::PackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+
+};
+
+/// An unpacking archive that pulls packed bytes from a source as it needs
+/// them, rather than needing all of them in memory up front (e.g., to restart
+/// from a large checkpoint file while it's being read).  Small items are read
+/// through a staging buffer of staging_size bytes; raw data at least that big
+/// (e.g., the elements of a large std::vector<double>) is read from the source
+/// directly into its destination.  Only the packed wire layout is supported,
+/// and since there's no buffer to point into, views and polymorphic objects
+/// can't be unpacked from it.
+template <typename Allocator=std::allocator<char>>
+class StreamingUnpackingArchive
+  : public detail::UnpackingArchiveMixin<
+      StreamingUnpackingArchive<Allocator>, Allocator
+    >
+{
+  public:
+
+    // Concept "shortcut" tag
+    using is_unpacking_archive_t = std::true_type;
+    using is_archive_t = std::true_type;
+
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+
+  protected:
+
+    streaming_source_t source_;
+    std::unique_ptr<char[]> staging_;
+    std::size_t staging_size_;
+    // The unread bytes in the staging buffer are [staged_begin_, staged_end_)
+    std::size_t staged_begin_ = 0;
+    std::size_t staged_end_ = 0;
+    allocator_type alloc_;
+    detail::LazyObjectIdentityTable<detail::UnpackingObjectIdentityTable> object_identities_;
+
+    StreamingUnpackingArchive(
+      streaming_source_t source, std::size_t staging_size,
+      allocator_type const& alloc
+    ) : source_(std::move(source)),
+        staging_(new char[staging_size]),
+        staging_size_(staging_size),
+        alloc_(alloc)
+    {
+      assert(staging_size > 0);
+    }
+
+    template <typename>
+    friend struct StreamingSerializationHandler;
+
+    // Fill exactly size bytes of dest from the source
+    void _read_from_source(char* dest, std::size_t size) {
+      while(size > 0) {
+        auto n = source_(dest, size);
+        if(n == 0) _end_of_stream();
+        dest += n;
+        size -= n;
+      }
+    }
+
+    [[noreturn]] static void _end_of_stream() {
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+      throw std::runtime_error("serialized stream ended before unpacking finished");
+#else
+      detail::_fatal_error("serialized stream ended before unpacking finished");
+#endif
+    }
+
+    // Make at least size (<= staging_size_) bytes available in the staging
+    // buffer, reading as much as the source will give at once
+    void _stage(std::size_t size) {
+      auto n_staged = staged_end_ - staged_begin_;
+      if(n_staged >= size) return;
+      std::memmove(staging_.get(), staging_.get() + staged_begin_, n_staged);
+      staged_begin_ = 0;
+      staged_end_ = n_staged;
+      while(staged_end_ < size) {
+        auto n = source_(staging_.get() + staged_end_, staging_size_ - staged_end_);
+        if(n == 0) _end_of_stream();
+        staged_end_ += n;
+      }
+    }
+
+  private:
+
+    template <typename T>
+    inline auto& _ask_serializer_to_unpack(T& obj) & {
+      auto* buffer = static_cast<void*>(&obj);
+      using rebound_alloc = typename std::allocator_traits<allocator_type>::template rebind_alloc<T>;
+      rebound_alloc alloc{get_allocator()};
+      std::allocator_traits<rebound_alloc>::destroy(alloc, &obj);
+      darma_unpack(allocated_buffer_for<T>(buffer), *this);
+      return *this;
+    }
+
+  public:
+
+    using layout_type = PackedLayout;
+
+    StreamingUnpackingArchive(StreamingUnpackingArchive&&) = default;
+
+    static constexpr bool is_sizing() { return false; }
+    static constexpr bool is_packing() { return false; }
+    static constexpr bool is_unpacking() { return true; }
+
+    template <typename RawDataType>
+    void unpack_data_raw(void* allocated_dest, size_t n_items = 1) {
+      auto size = n_items * sizeof(RawDataType);
+      auto* dest = static_cast<char*>(allocated_dest);
+      if(size >= staging_size_) {
+        // Whatever's already staged, then straight from the source
+        auto n_staged = staged_end_ - staged_begin_;
+        std::memcpy(dest, staging_.get() + staged_begin_, n_staged);
+        staged_begin_ = staged_end_ = 0;
+        _read_from_source(dest + n_staged, size - n_staged);
+      }
+      else {
+        _stage(size);
+        std::memcpy(dest, staging_.get() + staged_begin_, size);
+        staged_begin_ += size;
+      }
+    }
+
+    template <typename T>
+    inline auto& operator|(T& obj) & {
+      return _ask_serializer_to_unpack(obj);
+    }
+
+    template <typename T>
+    inline auto& operator>>(T& obj) & {
+      return _ask_serializer_to_unpack(obj);
+    }
+
+    auto const& get_allocator() const { return alloc_; }
+    auto& get_allocator() { return alloc_; }
+
+    template <typename NeededAllocatorT>
+    NeededAllocatorT get_allocator_as() const {
+      return detail::get_allocator_as<NeededAllocatorT>(alloc_);
+    }
+
+    detail::UnpackingObjectIdentityTable& object_identities() { return object_identities_.get(); }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_STREAMING_ARCHIVE_H
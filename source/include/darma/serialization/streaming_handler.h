@@ -0,0 +1,149 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      streaming_handler.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_STREAMING_HANDLER_H
+#define DARMAFRONTEND_SERIALIZATION_STREAMING_HANDLER_H
+
+#include "simple_handler_fwd.h"
+#include "streaming_handler_fwd.h"
+
+#include <darma/serialization/simple_handler.h>
+#include <darma/serialization/streaming_archive.h>
+
+#include <cstddef>
+#include <utility>
+
+namespace darma {
+namespace serialization {
+
+/// A SimpleSerializationHandler (with the packed wire layout) that can also
+/// pack to a sink and unpack from a source without holding the whole buffer
+/// in memory (see StreamingPackingArchive and StreamingUnpackingArchive).
+/// StreamingPackingArchive flushes from a background thread, so this handler
+/// is kept out of simple_handler.h; link the
+/// darma_serialization::darma_serialization_streaming target (which brings in
+/// Threads) to use it.
+template <typename Allocator /*=std::allocator<char>*/>
+struct StreamingSerializationHandler
+  : SimpleSerializationHandler<Allocator>
+{
+  private:
+
+    using this_t = StreamingSerializationHandler<Allocator>;
+    using base_t = SimpleSerializationHandler<Allocator>;
+    using char_allocator_t = typename base_t::char_allocator_t;
+
+  public:
+
+    //==========================================================================
+    // <editor-fold desc="archive creation"> {{{1
+
+    /// See StreamingPackingArchive
+    static auto
+    make_streaming_packing_archive(
+      streaming_sink_t sink,
+      size_t chunk_size = DARMA_SERIALIZATION_STREAMING_CHUNK_SIZE,
+      size_t n_chunks = DARMA_SERIALIZATION_STREAMING_N_CHUNKS
+    ) {
+      return StreamingPackingArchive(std::move(sink), chunk_size, n_chunks);
+    }
+
+    /// See StreamingUnpackingArchive
+    static auto
+    make_streaming_unpacking_archive(
+      streaming_source_t source,
+      size_t staging_size = DARMA_SERIALIZATION_STREAMING_STAGING_SIZE
+    ) {
+      return StreamingUnpackingArchive<char_allocator_t>(
+        std::move(source), staging_size, char_allocator_t{}
+      );
+    }
+
+    static auto
+    make_streaming_unpacking_archive(
+      streaming_source_t source, size_t staging_size, Allocator const& alloc
+    ) {
+      return StreamingUnpackingArchive<char_allocator_t>(
+        std::move(source), staging_size, char_allocator_t(alloc)
+      );
+    }
+
+    // </editor-fold> end archive creation }}}1
+    //==========================================================================
+
+    /// The streaming counterpart of extract_buffer(): flush whatever is left
+    /// and wait for the sink to receive it (rethrowing anything the sink
+    /// threw).  Returns the total number of bytes packed.
+    static std::size_t
+    finish_streaming(StreamingPackingArchive&& ar) {
+      return ar._finish();
+    }
+
+    /// Pack the objects through a bounded ring of chunk_size buffers to sink,
+    /// rather than into one buffer (see StreamingPackingArchive).  Returns the
+    /// number of bytes packed.
+    template <typename... Ts>
+    static
+    std::size_t
+    serialize_streaming(streaming_sink_t sink, Ts const&... objects) {
+      auto p_ar = this_t::make_streaming_packing_archive(std::move(sink));
+      base_t::_apply_pack_recursively(p_ar, objects...);
+      return this_t::finish_streaming(std::move(p_ar));
+    }
+
+    /// Deserialize a T from bytes pulled from source as they're needed (see
+    /// StreamingUnpackingArchive), rather than from a buffer.  Bytes the
+    /// source gave beyond the end of the T may have been consumed.
+    template <typename T>
+    static T deserialize_streaming(streaming_source_t source) {
+      auto ar = this_t::make_streaming_unpacking_archive(std::move(source));
+      return ar.template unpack_next_item_as<T>();
+    }
+
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_STREAMING_HANDLER_H
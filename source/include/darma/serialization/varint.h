@@ -0,0 +1,215 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      varint.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_VARINT_H
+#define DARMAFRONTEND_SERIALIZATION_VARINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__BMI2__)
+#  include <immintrin.h>
+#endif
+
+namespace darma {
+namespace serialization {
+
+// LEB128 ("varint") encoding of unsigned integers: seven bits per byte, least
+// significant group first, with the high bit of each byte set if another byte
+// follows.  Values below 128 take one byte; a 64-bit value takes at most ten.
+// Signed integers are zigzag encoded first, so that small negative numbers are
+// small too.
+
+namespace detail {
+
+constexpr std::size_t varint_max_size = 10;
+
+inline unsigned _count_leading_zeros64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return v == 0 ? 64 : static_cast<unsigned>(__builtin_clzll(v));
+#else
+  unsigned n = 0;
+  for(std::uint64_t bit = std::uint64_t(1) << 63; bit != 0 and (v & bit) == 0; bit >>= 1) ++n;
+  return n;
+#endif
+}
+
+inline unsigned _count_trailing_zeros64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return v == 0 ? 64 : static_cast<unsigned>(__builtin_ctzll(v));
+#else
+  unsigned n = 0;
+  for(std::uint64_t bit = 1; bit != 0 and (v & bit) == 0; bit <<= 1) ++n;
+  return n;
+#endif
+}
+
+/// The number of bytes encode_varint() will write for v
+inline std::size_t varint_size(std::uint64_t v) {
+  return 1 + (63 - _count_leading_zeros64(v | 1)) / 7;
+}
+
+/// Write v to dest (which must have room for varint_size(v) bytes); returns
+/// the number of bytes written
+inline std::size_t encode_varint(std::uint64_t v, unsigned char* dest) {
+  std::size_t n = 0;
+  while(v >= 0x80) {
+    dest[n++] = static_cast<unsigned char>(v | 0x80);
+    v >>= 7;
+  }
+  dest[n++] = static_cast<unsigned char>(v);
+  return n;
+}
+
+inline std::uint64_t _decode_varint_bytewise(char const*& spot) {
+  std::uint64_t rv = 0;
+  for(unsigned shift = 0; shift < 64; shift += 7) {
+    auto byte = static_cast<unsigned char>(*spot++);
+    rv |= std::uint64_t(byte & 0x7f) << shift;
+    if((byte & 0x80) == 0) break;
+  }
+  return rv;
+}
+
+/// Read a varint from spot and advance spot past it.  available is the number
+/// of readable bytes at spot; when there are at least eight, values of up to
+/// 56 bits (i.e., practically all sizes) are decoded from a single unaligned
+/// load without a loop or data-dependent branches per byte.
+inline std::uint64_t decode_varint(char const*& spot, std::size_t available) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  if(available >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, spot, sizeof(word));
+    // The high bit is clear in the last byte of the varint
+    auto const last_bytes = ~word & 0x8080808080808080ull;
+    if(last_bytes != 0) {
+      auto const n_bits = _count_trailing_zeros64(last_bytes) + 1;
+      spot += n_bits / 8;
+      if(n_bits < 64) word &= (std::uint64_t(1) << n_bits) - 1;
+#if defined(__BMI2__)
+      return _pext_u64(word, 0x7f7f7f7f7f7f7f7full);
+#else
+      // Squeeze out the continuation bits: pairs of 7-bit groups, then pairs
+      // of 14-bit groups, then the two 28-bit groups
+      word &= 0x7f7f7f7f7f7f7f7full;
+      word = (word & 0x007f007f007f007full) | ((word & 0x7f007f007f007f00ull) >> 1);
+      word = (word & 0x00003fff00003fffull) | ((word & 0x3fff00003fff0000ull) >> 2);
+      word = (word & 0x000000000fffffffull) | ((word & 0x0fffffff00000000ull) >> 4);
+      return word;
+#endif
+    }
+  }
+#endif
+  return _decode_varint_bytewise(spot);
+}
+
+enum class varint_decode_result {
+  ok,
+  // available ran out before the last byte of the varint
+  truncated,
+  // more than ten bytes, or a tenth byte with more than the 64th bit in it
+  overlong
+};
+
+/// Like decode_varint(), but for bytes that can't be trusted: value is only
+/// set (and spot only advanced) if a whole varint that fits in 64 bits is
+/// there.  (Only encode_varint() output is accepted, other than redundant
+/// trailing zero groups.)
+inline varint_decode_result
+decode_varint_checked(
+  char const*& spot, std::size_t available, std::uint64_t& value
+) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // A varint that ends within the first eight bytes always fits, so the fast
+  // decode can be used for it
+  if(available >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, spot, sizeof(word));
+    if((~word & 0x8080808080808080ull) != 0) {
+      value = decode_varint(spot, available);
+      return varint_decode_result::ok;
+    }
+  }
+#endif
+  std::uint64_t rv = 0;
+  for(std::size_t i = 0; i < varint_max_size; ++i) {
+    if(i == available) return varint_decode_result::truncated;
+    auto byte = static_cast<unsigned char>(spot[i]);
+    // Only the 64th bit is left for the tenth byte, and it has to be the last
+    if(i == varint_max_size - 1 and byte > 1) return varint_decode_result::overlong;
+    rv |= std::uint64_t(byte & 0x7f) << (7 * i);
+    if((byte & 0x80) == 0) {
+      spot += i + 1;
+      value = rv;
+      return varint_decode_result::ok;
+    }
+  }
+  return varint_decode_result::overlong;
+}
+
+template <typename Integer>
+std::uint64_t zigzag_encode(Integer v) {
+  static_assert(std::is_signed<Integer>::value, "zigzag encoding is for signed integers");
+  auto const wide = static_cast<std::int64_t>(v);
+  // The right shift of a negative number is arithmetic in every implementation
+  // we care about (and guaranteed as of C++20)
+  return (static_cast<std::uint64_t>(wide) << 1) ^ static_cast<std::uint64_t>(wide >> 63);
+}
+
+template <typename Integer>
+Integer zigzag_decode(std::uint64_t v) {
+  static_assert(std::is_signed<Integer>::value, "zigzag encoding is for signed integers");
+  return static_cast<Integer>(
+    static_cast<std::int64_t>((v >> 1) ^ (~(v & 1) + 1))
+  );
+}
+
+} // end namespace detail
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_VARINT_H
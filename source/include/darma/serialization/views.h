@@ -0,0 +1,244 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      views.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_VIEWS_H
+#define DARMAFRONTEND_SERIALIZATION_VIEWS_H
+
+#include <darma/serialization/serialization_fwd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace darma {
+namespace serialization {
+
+//==============================================================================
+// <editor-fold desc="view types"> {{{1
+
+/// A non-owning, read-only view of a contiguous run of T in a serialization
+/// buffer (like a C++20 std::span<T const>).  Only valid as long as the
+/// buffer it was unpacked from.
+template <typename T>
+class ArrayView {
+  public:
+
+    using element_type = T const;
+    using value_type = T;
+    using size_type = std::size_t;
+    using const_pointer = T const*;
+    using const_reference = T const&;
+    using const_iterator = T const*;
+    using iterator = const_iterator;
+
+    constexpr ArrayView() noexcept = default;
+
+    constexpr ArrayView(T const* data, size_type size) noexcept
+      : data_(data), size_(size)
+    { }
+
+    constexpr const_pointer data() const noexcept { return data_; }
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr size_type size_bytes() const noexcept { return size_ * sizeof(T); }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr const_reference operator[](size_type i) const { return data_[i]; }
+    constexpr const_reference front() const { return data_[0]; }
+    constexpr const_reference back() const { return data_[size_ - 1]; }
+
+    constexpr const_iterator begin() const noexcept { return data_; }
+    constexpr const_iterator end() const noexcept { return data_ + size_; }
+    constexpr const_iterator cbegin() const noexcept { return data_; }
+    constexpr const_iterator cend() const noexcept { return data_ + size_; }
+
+  private:
+
+    T const* data_ = nullptr;
+    size_type size_ = 0;
+};
+
+template <typename T>
+bool operator==(ArrayView<T> const& a, ArrayView<T> const& b) {
+  return a.size() == b.size() and std::equal(a.begin(), a.end(), b.begin());
+}
+
+template <typename T>
+bool operator!=(ArrayView<T> const& a, ArrayView<T> const& b) {
+  return not (a == b);
+}
+
+/// A non-owning, read-only view of a string in a serialization buffer (like a
+/// C++17 std::basic_string_view).  Not null-terminated.  Only valid as long as
+/// the buffer it was unpacked from.
+template <typename CharT, typename Traits=std::char_traits<CharT>>
+class BasicStringView {
+  public:
+
+    using traits_type = Traits;
+    using value_type = CharT;
+    using size_type = std::size_t;
+    using const_pointer = CharT const*;
+    using const_reference = CharT const&;
+    using const_iterator = CharT const*;
+    using iterator = const_iterator;
+
+    constexpr BasicStringView() noexcept = default;
+
+    constexpr BasicStringView(CharT const* data, size_type size) noexcept
+      : data_(data), size_(size)
+    { }
+
+    constexpr const_pointer data() const noexcept { return data_; }
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr size_type length() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr const_reference operator[](size_type i) const { return data_[i]; }
+
+    constexpr const_iterator begin() const noexcept { return data_; }
+    constexpr const_iterator end() const noexcept { return data_ + size_; }
+    constexpr const_iterator cbegin() const noexcept { return data_; }
+    constexpr const_iterator cend() const noexcept { return data_ + size_; }
+
+    int compare(BasicStringView other) const {
+      auto rv = Traits::compare(data_, other.data_, std::min(size_, other.size_));
+      if(rv != 0) return rv;
+      return size_ == other.size_ ? 0 : (size_ < other.size_ ? -1 : 1);
+    }
+
+    /// Copy the viewed characters into an owning string
+    template <typename Allocator=std::allocator<CharT>>
+    std::basic_string<CharT, Traits, Allocator>
+    to_string(Allocator const& alloc = Allocator{}) const {
+      return std::basic_string<CharT, Traits, Allocator>(data_, size_, alloc);
+    }
+
+    template <typename Allocator>
+    explicit operator std::basic_string<CharT, Traits, Allocator>() const {
+      return to_string<Allocator>();
+    }
+
+  private:
+
+    CharT const* data_ = nullptr;
+    size_type size_ = 0;
+};
+
+template <typename CharT, typename Traits>
+bool operator==(
+  BasicStringView<CharT, Traits> a, BasicStringView<CharT, Traits> b
+) {
+  return a.compare(b) == 0;
+}
+
+template <typename CharT, typename Traits>
+bool operator!=(
+  BasicStringView<CharT, Traits> a, BasicStringView<CharT, Traits> b
+) {
+  return a.compare(b) != 0;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+bool operator==(
+  BasicStringView<CharT, Traits> a,
+  std::basic_string<CharT, Traits, Allocator> const& b
+) {
+  return a.compare(BasicStringView<CharT, Traits>(b.data(), b.size())) == 0;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+bool operator==(
+  std::basic_string<CharT, Traits, Allocator> const& a,
+  BasicStringView<CharT, Traits> b
+) {
+  return b == a;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+bool operator!=(
+  BasicStringView<CharT, Traits> a,
+  std::basic_string<CharT, Traits, Allocator> const& b
+) {
+  return not (a == b);
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+bool operator!=(
+  std::basic_string<CharT, Traits, Allocator> const& a,
+  BasicStringView<CharT, Traits> b
+) {
+  return not (b == a);
+}
+
+using StringView = BasicStringView<char>;
+
+// </editor-fold> end view types }}}1
+//==============================================================================
+
+//==============================================================================
+// <editor-fold desc="ViewDeserializer customization point"> {{{1
+
+/// Specialize this for types whose packed representation can be read in place.
+/// Specializations provide a `view_type` and a
+///
+///   template <typename Archive>
+///   static view_type unpack_view(Archive& ar);
+///
+/// that advances the archive past the packed object exactly as unpack() would
+/// have, usually by way of the archive's view_data_raw<T>(n_items).  Serializers
+/// for the standard library types provide these where it makes sense (e.g.,
+/// std::vector and std::basic_string of directly serializable types).
+template <typename T, typename Enable>
+struct ViewDeserializer;
+
+template <typename T>
+using view_type_t = typename ViewDeserializer<T>::view_type;
+
+// </editor-fold> end ViewDeserializer customization point }}}1
+//==============================================================================
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_VIEWS_H
@@ -0,0 +1,225 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      wire_layout.h
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#ifndef DARMAFRONTEND_SERIALIZATION_WIRE_LAYOUT_H
+#define DARMAFRONTEND_SERIALIZATION_WIRE_LAYOUT_H
+
+#include <tinympl/detection.hpp>
+
+#include <cstddef>
+#include <type_traits>
+
+// Raw data blocks of at least this many bytes get the large array alignment
+// of an AlignedLayout (e.g., the data of a std::vector<double>), so that they
+// can be loaded in place with aligned SIMD instructions
+#ifndef DARMA_SERIALIZATION_LARGE_ARRAY_ALIGNMENT
+#  define DARMA_SERIALIZATION_LARGE_ARRAY_ALIGNMENT 64
+#endif
+#ifndef DARMA_SERIALIZATION_LARGE_ARRAY_MIN_SIZE
+#  define DARMA_SERIALIZATION_LARGE_ARRAY_MIN_SIZE 1024
+#endif
+
+namespace darma {
+namespace serialization {
+
+// Integer encoding policies, given by a layout's integer_encoding (see
+// VarintLayout).  Container serializers write their sizes with
+// pack_size_prefix() and friends (see integer_encoding.h), which ask for it.
+
+/// The default: sizes and integers are written at their full width
+struct FixedWidthIntegers {
+  static constexpr bool varint_sizes = false;
+  static constexpr bool varint_integers = false;
+};
+
+/// Container size prefixes are written as LEB128 varints
+struct VarintSizes {
+  static constexpr bool varint_sizes = true;
+  static constexpr bool varint_integers = false;
+};
+
+/// Container size prefixes and all integers wider than a byte are written as
+/// varints, zigzag encoded if they're signed.  (Contiguous arrays of integers,
+/// e.g., the data of a std::vector<int>, are still copied raw.)
+struct VarintIntegers {
+  static constexpr bool varint_sizes = true;
+  static constexpr bool varint_integers = true;
+};
+
+// Byte orders, given by a layout's byte_order (see PortableLayout).  Raw data
+// is converted to the layout's byte order when it's packed and back when it's
+// unpacked (see byte_order.h).
+
+/// The default: raw data is copied as is, in whatever order the host uses
+struct NativeByteOrder { };
+
+struct LittleEndianByteOrder {
+  static constexpr bool is_little_endian = true;
+};
+
+struct BigEndianByteOrder {
+  static constexpr bool is_little_endian = false;
+};
+
+// Wire layout policies for the Simple archives (see SimpleSerializationHandler).
+// A layout decides how much padding goes in front of each block of raw data,
+// given the block's offset from the start of the buffer.  Sizing, packing and
+// unpacking all ask the same layout, so they always agree.
+
+/// The default: raw data is packed back to back, with no padding
+struct PackedLayout {
+  using integer_encoding = FixedWidthIntegers;
+  using byte_order = NativeByteOrder;
+
+  static constexpr bool pads_raw_data = false;
+  static constexpr std::size_t buffer_alignment = 1;
+
+  template <typename RawDataType>
+  static constexpr std::size_t padding_for(std::size_t, std::size_t) {
+    return 0;
+  }
+};
+
+/// Each block of raw data starts at an offset that's a multiple of its type's
+/// alignment, and large blocks at a multiple of LargeArrayAlignment.  As long
+/// as the buffer itself is allocated with buffer_alignment (e.g., with an
+/// OverAlignedAllocator), packed data can then be used in place (see
+/// ViewDeserializer) and loaded with aligned vector instructions.
+template <
+  std::size_t LargeArrayAlignment = DARMA_SERIALIZATION_LARGE_ARRAY_ALIGNMENT,
+  std::size_t LargeArrayMinSize = DARMA_SERIALIZATION_LARGE_ARRAY_MIN_SIZE
+>
+struct AlignedLayout {
+  static_assert((LargeArrayAlignment & (LargeArrayAlignment - 1)) == 0,
+    "large array alignment must be a power of two"
+  );
+
+  using integer_encoding = FixedWidthIntegers;
+  using byte_order = NativeByteOrder;
+
+  static constexpr bool pads_raw_data = true;
+  static constexpr std::size_t buffer_alignment = LargeArrayAlignment;
+
+  template <typename RawDataType>
+  static constexpr std::size_t alignment_for(std::size_t n_items) {
+    return (n_items * sizeof(RawDataType) >= LargeArrayMinSize
+      and LargeArrayAlignment > alignof(RawDataType)
+    ) ? LargeArrayAlignment : alignof(RawDataType);
+  }
+
+  template <typename RawDataType>
+  static constexpr std::size_t padding_for(std::size_t offset, std::size_t n_items) {
+    return (alignment_for<RawDataType>(n_items)
+      - offset % alignment_for<RawDataType>(n_items)
+    ) % alignment_for<RawDataType>(n_items);
+  }
+};
+
+/// BaseLayout, with sizes (and, optionally, integers) varint encoded.  This
+/// usually shrinks messages of many small strings and containers a lot, since
+/// each of their size prefixes goes from eight bytes to one.
+template <
+  typename IntegerEncoding = VarintSizes,
+  typename BaseLayout = PackedLayout
+>
+struct VarintLayout : BaseLayout {
+  using integer_encoding = IntegerEncoding;
+};
+
+/// BaseLayout, with raw data of arithmetic types (and arrays, pairs and tuples
+/// of them) stored in WireOrder regardless of the host's byte order, so that
+/// buffers can be exchanged between, or stored and read back on, machines with
+/// different byte orders.  Polymorphic objects pack themselves in the host's
+/// byte order, so they can only be serialized when WireOrder is the host's.
+template <
+  typename WireOrder = LittleEndianByteOrder,
+  typename BaseLayout = PackedLayout
+>
+struct PortableLayout : BaseLayout {
+  using byte_order = WireOrder;
+};
+
+namespace detail {
+
+template <typename Archive>
+using _archive_layout_archetype = typename Archive::layout_type;
+
+template <typename Layout>
+using _layout_integer_encoding_archetype = typename Layout::integer_encoding;
+
+template <typename Layout>
+using _layout_byte_order_archetype = typename Layout::byte_order;
+
+} // end namespace detail
+
+/// The byte order a layout stores raw data in; NativeByteOrder for layouts
+/// that don't say
+template <typename Layout>
+using layout_byte_order_t = tinympl::detected_or_t<
+  NativeByteOrder, detail::_layout_byte_order_archetype, Layout
+>;
+
+/// The wire layout an archive uses; PackedLayout for archives that don't say
+template <typename Archive>
+using archive_layout_t = tinympl::detected_or_t<
+  PackedLayout, detail::_archive_layout_archetype, std::decay_t<Archive>
+>;
+
+/// The integer encoding an archive uses; FixedWidthIntegers for archives (or
+/// layouts) that don't say
+template <typename Archive>
+using archive_integer_encoding_t = tinympl::detected_or_t<
+  FixedWidthIntegers, detail::_layout_integer_encoding_archetype,
+  archive_layout_t<Archive>
+>;
+
+template <typename Archive>
+struct archive_pads_raw_data
+  : std::integral_constant<bool, archive_layout_t<Archive>::pads_raw_data>
+{ };
+
+} // end namespace serialization
+} // end namespace darma
+
+#endif //DARMAFRONTEND_SERIALIZATION_WIRE_LAYOUT_H
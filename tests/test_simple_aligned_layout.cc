@@ -0,0 +1,138 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_aligned_layout.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <cstdint>
+#include <cstring>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+using aligned_handler_t = AlignedSerializationHandler<>;
+
+using aligned_sizing_archive_t = BasicSimpleSizingArchive<AlignedLayout<>>;
+using aligned_packing_archive_t =
+  SimplePackingArchive<DynamicSerializationBuffer<>, AlignedLayout<>>;
+using aligned_unpacking_archive_t =
+  SimpleUnpackingArchive<std::allocator<char>, AlignedLayout<>>;
+
+STATIC_ASSERT_SIZABLE(aligned_sizing_archive_t, std::vector<double>);
+STATIC_ASSERT_PACKABLE(aligned_packing_archive_t, std::vector<double>);
+STATIC_ASSERT_UNPACKABLE(aligned_unpacking_archive_t, std::vector<double>);
+
+static_assert(AlignedLayout<64, 1024>::padding_for<double>(9, 1) == 7, "");
+static_assert(AlignedLayout<64, 1024>::padding_for<double>(16, 1) == 0, "");
+static_assert(AlignedLayout<64, 1024>::padding_for<double>(16, 128) == 48, "");
+static_assert(AlignedLayout<64, 1024>::padding_for<char>(3, 2000) == 61, "");
+static_assert(PackedLayout::padding_for<double>(9, 1000) == 0, "");
+
+namespace {
+
+bool is_aligned(void const* ptr, std::size_t alignment) {
+  return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, aligned_buffer_is_aligned) {
+  auto buffer = aligned_handler_t::serialize('a');
+  EXPECT_TRUE(is_aligned(buffer.data(), 64));
+}
+
+TEST_F(TestSimpleSerializationHandler, aligned_mixed_round_trip) {
+  char c = 'x';
+  std::vector<double> small{1.0, 2.0, 3.0};
+  std::string name = "pressure";
+  std::vector<float> large(1000, 0.5f);
+  std::unordered_map<int, double> table{{1, 1.5}, {2, 2.5}};
+  std::map<short, std::vector<double>> nested{{1, {1.0}}, {2, {2.0, 3.0}}};
+  auto buffer = aligned_handler_t::serialize(c, small, name, large, table, nested);
+
+  auto ar = aligned_handler_t::make_unpacking_archive(buffer);
+  EXPECT_EQ(ar.unpack_next_item_as<char>(), c);
+  EXPECT_EQ(ar.unpack_next_item_as<std::vector<double>>(), small);
+  EXPECT_EQ(ar.unpack_next_item_as<std::string>(), name);
+  EXPECT_EQ(ar.unpack_next_item_as<std::vector<float>>(), large);
+  EXPECT_EQ((ar.unpack_next_item_as<std::unordered_map<int, double>>()), table);
+  EXPECT_EQ((ar.unpack_next_item_as<std::map<short, std::vector<double>>>()), nested);
+}
+
+TEST_F(TestSimpleSerializationHandler, aligned_views_in_place) {
+  std::vector<double> small{1.0, 2.0, 3.0};
+  std::vector<double> large(512, 3.0);
+  auto buffer = aligned_handler_t::serialize('x', small, 'y', large);
+  auto ar = aligned_handler_t::make_unpacking_archive(buffer);
+  ar.unpack_next_item_as<char>();
+  auto small_view = ar.unpack_next_item_as_view<std::vector<double>>();
+  ar.unpack_next_item_as<char>();
+  auto large_view = ar.unpack_next_item_as_view<std::vector<double>>();
+  EXPECT_TRUE(is_aligned(small_view.data(), alignof(double)));
+  EXPECT_TRUE(is_aligned(large_view.data(), 64));
+  EXPECT_THAT(small_view, ElementsAre(1.0, 2.0, 3.0));
+  EXPECT_THAT(large_view, Each(DoubleEq(3.0)));
+}
+
+TEST_F(TestSimpleSerializationHandler, aligned_size_is_exact) {
+  // The sizing pass has to add exactly the padding that packing does, which
+  // the single-pass archive doesn't need a sizing pass to know
+  std::vector<double> large(300, 1.0);
+  std::unordered_set<long> ids{1, 2, 3, 4};
+  auto two_pass = aligned_handler_t::serialize('a', large, ids, 'b', std::string(2000, 'c'));
+  auto single_pass = aligned_handler_t::serialize_single_pass('a', large, ids, 'b', std::string(2000, 'c'));
+  ASSERT_EQ(two_pass.capacity(), single_pass.size());
+  EXPECT_EQ(0, std::memcmp(two_pass.data(), single_pass.data(), single_pass.size()));
+}
+
+TEST_F(TestSimpleSerializationHandler, packed_layout_unchanged) {
+  // The default handler doesn't pad: a char followed by a double takes 9 bytes
+  auto buffer = SimpleSerializationHandler<>::serialize('a', 1.0);
+  EXPECT_EQ(buffer.capacity(), 9u);
+  auto aligned_buffer = aligned_handler_t::serialize('a', 1.0);
+  EXPECT_EQ(aligned_buffer.capacity(), 16u);
+}
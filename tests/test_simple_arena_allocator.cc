@@ -0,0 +1,211 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_arena_allocator.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/map.h>
+#include <darma/serialization/serializers/standard_library/set.h>
+#include <darma/serialization/serializers/standard_library/list.h>
+#include <darma/serialization/serializers/standard_library/vector.h>
+#include <darma/serialization/serializers/standard_library/string.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+
+#include <darma/serialization/allocators/monotonic_arena_allocator.h>
+
+#include <darma/serialization/simple_handler.h>
+#include <darma/serialization/pointer_reference_handler.h>
+
+#include "test_simple_common.h"
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+template <typename T>
+using arena_alloc_t = MonotonicArenaAllocator<T>;
+using arena_string_t = std::basic_string<char, std::char_traits<char>, arena_alloc_t<char>>;
+template <typename T>
+using arena_vector_t = std::vector<T, arena_alloc_t<T>>;
+using arena_handler_t = SimpleSerializationHandler<arena_alloc_t<char>>;
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, arena_vector_t<arena_string_t>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, arena_vector_t<arena_string_t>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<arena_alloc_t<char>>, arena_vector_t<arena_string_t>);
+
+// Each arena starts from a buffer owned by the fixture, which makes it easy to
+// check whether a given pointer came from the arena
+class TestArenaAllocator
+  : public TestSimpleSerializationHandler
+{
+  protected:
+
+    static constexpr std::size_t arena_buffer_size = 1 << 16;
+    alignas(std::max_align_t) char arena_buffer[arena_buffer_size];
+
+    bool in_arena(void const* ptr) const {
+      auto* p = static_cast<char const*>(ptr);
+      return p >= arena_buffer and p < arena_buffer + arena_buffer_size;
+    }
+};
+
+TEST_F(TestArenaAllocator, vector_of_strings) {
+  // Same wire format as the std::allocator versions
+  std::vector<std::string> input{
+    "hello", "world",
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit. Duis laoreet dui"
+  };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+
+  MonotonicArena arena(arena_buffer, arena_buffer_size);
+  using T = arena_vector_t<arena_string_t>;
+  auto output = arena_handler_t::deserialize<T>(buffer, arena_alloc_t<char>(arena));
+
+  ASSERT_THAT(output.size(), Eq(input.size()));
+  EXPECT_TRUE(in_arena(output.data()));
+  for(std::size_t i = 0; i < input.size(); ++i) {
+    EXPECT_THAT(std::string(output[i].begin(), output[i].end()), Eq(input[i]));
+    EXPECT_THAT(&output[i].get_allocator().arena(), Eq(&arena));
+  }
+  // The long string can't use the small string optimization
+  EXPECT_TRUE(in_arena(output[2].data()));
+  EXPECT_THAT(arena.bytes_allocated(), Gt(input[2].size()));
+}
+
+TEST_F(TestArenaAllocator, map_and_set) {
+  std::map<int, std::vector<double>> input_map{
+    {1, {1.0, 2.0}}, {2, {}}, {3, {3.0}}
+  };
+  std::set<int> input_set{5, 6, 7};
+  auto buffer = SimpleSerializationHandler<>::serialize(input_map, input_set);
+
+  MonotonicArena arena(arena_buffer, arena_buffer_size);
+  using pair_t = std::pair<int const, arena_vector_t<double>>;
+  using map_t = std::map<int, arena_vector_t<double>, std::less<int>, arena_alloc_t<pair_t>>;
+  using set_t = std::set<int, std::less<int>, arena_alloc_t<int>>;
+  auto ar = arena_handler_t::make_unpacking_archive(buffer, arena_alloc_t<char>(arena));
+  auto output_map = ar.unpack_next_item_as<map_t>();
+  auto output_set = ar.unpack_next_item_as<set_t>();
+
+  EXPECT_THAT(&output_map.get_allocator().arena(), Eq(&arena));
+  EXPECT_THAT(&output_set.get_allocator().arena(), Eq(&arena));
+  EXPECT_TRUE(in_arena(&*output_map.begin()));
+  EXPECT_TRUE(in_arena(&*output_set.begin()));
+  EXPECT_TRUE(in_arena(output_map.at(1).data()));
+  EXPECT_THAT(output_map.at(1), ElementsAre(1.0, 2.0));
+  EXPECT_TRUE(output_map.at(2).empty());
+  EXPECT_THAT(output_map.at(3), ElementsAre(3.0));
+  EXPECT_THAT(output_set, ElementsAre(5, 6, 7));
+}
+
+TEST_F(TestArenaAllocator, std_allocator_falls_back) {
+  std::list<int> input{1, 2, 3};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+
+  MonotonicArena arena(arena_buffer, arena_buffer_size);
+  auto output = arena_handler_t::deserialize<std::list<int>>(
+    buffer, arena_alloc_t<char>(arena)
+  );
+  EXPECT_THAT(output, ElementsAre(1, 2, 3));
+  EXPECT_FALSE(in_arena(&output.front()));
+}
+
+TEST_F(TestArenaAllocator, pointer_reference_handler) {
+  std::vector<std::string> input{ "hello", "world" };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+
+  MonotonicArena arena(arena_buffer, arena_buffer_size);
+  char const* data = buffer.data();
+  auto ar = PointerReferenceSerializationHandler<>::make_unpacking_archive(
+    data, arena_alloc_t<char>(arena)
+  );
+  auto output = ar.unpack_next_item_as<arena_vector_t<arena_string_t>>();
+  EXPECT_TRUE(in_arena(output.data()));
+  EXPECT_THAT(output.size(), Eq(2));
+  EXPECT_THAT(data, Eq(buffer.data() + buffer.capacity()));
+}
+
+TEST_F(TestArenaAllocator, arena_grows_and_releases) {
+  MonotonicArena arena(64);
+  arena_alloc_t<double> alloc(arena);
+  auto* small = alloc.allocate(2);
+  auto* big = alloc.allocate(1000);
+  EXPECT_THAT(reinterpret_cast<std::uintptr_t>(big) % alignof(double), Eq(0));
+  EXPECT_THAT(arena.bytes_allocated(), Eq(1002 * sizeof(double)));
+  big[999] = small[0] = 1.0;
+  arena.release();
+  EXPECT_THAT(arena.bytes_allocated(), Eq(0));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestArenaAllocator, arena_huge_allocation_throws) {
+  // Doubling the block size up to these would overflow rather than terminate
+  MonotonicArena arena(64);
+  auto const max_size = std::numeric_limits<std::size_t>::max();
+  EXPECT_THROW(arena.allocate(max_size / 2 + 1, 8), std::bad_alloc);
+  EXPECT_THROW(arena.allocate(max_size - 8, 8), std::bad_alloc);
+  // and the arena is still usable afterwards
+  EXPECT_THAT(arena.allocate(16, 8), NotNull());
+}
+
+TEST_F(TestArenaAllocator, allocator_overflowing_count_throws) {
+  // The byte count for these wraps around to something small
+  MonotonicArena arena(64);
+  arena_alloc_t<double> alloc(arena);
+  auto const max_count = std::numeric_limits<std::size_t>::max() / sizeof(double);
+  EXPECT_THROW(alloc.allocate(max_count + 1), std::bad_alloc);
+  EXPECT_THROW(alloc.allocate(max_count / 2 + 3), std::bad_alloc);
+  EXPECT_THAT(arena.bytes_allocated(), Eq(0));
+}
+#endif
+
+TEST_F(TestArenaAllocator, arena_released_and_reused) {
+  // A per-message arena is released and reused for every message, so each
+  // reuse has to start over from the initial block size rather than keep
+  // doubling it until the blocks can't be allocated
+  MonotonicArena arena(64);
+  arena_alloc_t<double> alloc(arena);
+  for(int message = 0; message < 100; ++message) {
+    auto* values = alloc.allocate(1000);
+    values[999] = values[0] = 1.0;
+    EXPECT_THAT(arena.bytes_allocated(), Eq(1000 * sizeof(double)));
+    arena.release();
+  }
+}
@@ -0,0 +1,176 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_buffer_pool.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/vector.h>
+#include <darma/serialization/serializers/standard_library/string.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+
+#include <darma/serialization/serialization_buffer_pool.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <limits>
+#include <memory>
+#include <thread>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+using pooled_handler_t = SimpleSerializationHandler<PooledSerializationBufferAllocator<>>;
+
+TEST_F(TestSimpleSerializationHandler, buffer_pool_reuses_buffers) {
+  SerializationBufferPool pool;
+  PooledSerializationBufferAllocator<> alloc(pool);
+  std::vector<int> input{1, 2, 3, 4, 5};
+  char const* first_data = nullptr;
+  {
+    auto buffer = pooled_handler_t::serialize_with_allocator(alloc, input);
+    first_data = buffer.data();
+    EXPECT_THAT(pool.misses(), Eq(1));
+    EXPECT_THAT(pool.bytes_retained(), Eq(0));
+  }
+  EXPECT_THAT(pool.bytes_retained(), Eq(DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS));
+  auto buffer = pooled_handler_t::serialize_with_allocator(alloc, input);
+  EXPECT_THAT(buffer.data(), Eq(first_data));
+  EXPECT_THAT(pool.hits(), Eq(1));
+  EXPECT_THAT(pool.hit_rate(), DoubleEq(0.5));
+  EXPECT_THAT(pool.bytes_retained(), Eq(0));
+  auto output = pooled_handler_t::deserialize<std::vector<int>>(buffer);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, buffer_pool_size_classes) {
+  SerializationBufferPool pool;
+  PooledSerializationBufferAllocator<> alloc(pool);
+  {
+    // 65 bytes goes in the 128 byte class
+    auto buffer = pooled_handler_t::serialize_with_allocator(
+      alloc, std::string(65 - sizeof(std::size_t), 'a')
+    );
+  }
+  EXPECT_THAT(pool.bytes_retained(), Eq(2 * DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS));
+  {
+    // Smaller buffers don't take from larger classes
+    auto buffer = pooled_handler_t::serialize_with_allocator(alloc, 42);
+  }
+  EXPECT_THAT(pool.hits(), Eq(0));
+  {
+    // Anything over the largest class isn't pooled
+    auto buffer = pooled_handler_t::serialize_with_allocator(
+      alloc, std::string(DARMA_SERIALIZATION_BUFFER_POOL_MAX_SIZE_CLASS, 'a')
+    );
+  }
+  EXPECT_THAT(pool.bytes_retained(), Eq(3 * DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS));
+  pool.release();
+  EXPECT_THAT(pool.bytes_retained(), Eq(0));
+}
+
+TEST_F(TestSimpleSerializationHandler, buffer_pool_max_buffers_per_class) {
+  SerializationBufferPool pool(2);
+  PooledSerializationBufferAllocator<> alloc(pool);
+  {
+    auto b1 = pooled_handler_t::serialize_with_allocator(alloc, 1);
+    auto b2 = pooled_handler_t::serialize_with_allocator(alloc, 2);
+    auto b3 = pooled_handler_t::serialize_with_allocator(alloc, 3);
+  }
+  EXPECT_THAT(pool.bytes_retained(), Eq(2 * DARMA_SERIALIZATION_BUFFER_POOL_MIN_SIZE_CLASS));
+}
+
+TEST_F(TestSimpleSerializationHandler, buffer_pool_global) {
+  auto& pool = SerializationBufferPool::global();
+  { auto buffer = pooled_handler_t::serialize(3.14); }
+  auto hits_before = pool.hits();
+  auto buffer = pooled_handler_t::serialize(2.71);
+  EXPECT_THAT(pool.hits(), Eq(hits_before + 1));
+  EXPECT_THAT(pooled_handler_t::deserialize<double>(buffer), DoubleEq(2.71));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, buffer_pool_overflowing_count_throws) {
+  // The byte count for this wraps around to something small
+  SerializationBufferPool pool;
+  PooledSerializationBufferAllocator<double> alloc(pool);
+  auto const max_count = std::numeric_limits<std::size_t>::max() / sizeof(double);
+  EXPECT_THROW(alloc.allocate(max_count + 1), std::bad_alloc);
+  EXPECT_THAT(pool.misses(), Eq(0));
+}
+#endif
+
+// Constructed before the global pool is first used, so destroyed after the
+// pool would be if the pool were an ordinary function-local static
+using pooled_buffer_t = DynamicSerializationBuffer<PooledSerializationBufferAllocator<>>;
+static std::unique_ptr<pooled_buffer_t> static_pooled_buffer;
+
+TEST_F(TestSimpleSerializationHandler, buffer_pool_global_outlives_statics) {
+  static_pooled_buffer = std::make_unique<pooled_buffer_t>(
+    pooled_handler_t::serialize(std::string("hello"))
+  );
+  EXPECT_THAT(
+    pooled_handler_t::deserialize<std::string>(*static_pooled_buffer), Eq("hello")
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, buffer_pool_threads) {
+  SerializationBufferPool pool;
+  PooledSerializationBufferAllocator<> alloc(pool);
+  std::vector<std::thread> threads;
+  std::vector<int> results(4, 0);
+  for(int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t]{
+      for(int i = 0; i < 1000; ++i) {
+        auto buffer = pooled_handler_t::serialize_with_allocator(
+          alloc, std::vector<int>(i % 100, t)
+        );
+        auto output = pooled_handler_t::deserialize<std::vector<int>>(buffer);
+        if(output == std::vector<int>(i % 100, t)) ++results[t];
+      }
+    });
+  }
+  for(auto& thread : threads) thread.join();
+  EXPECT_THAT(results, Each(Eq(1000)));
+  EXPECT_THAT(pool.hits() + pool.misses(), Eq(4000));
+  EXPECT_THAT(pool.hits(), Gt(0));
+}
@@ -0,0 +1,302 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_checked.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/checked_archive.h>
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+using checked_unpacking_archive_t = CheckedUnpackingArchive<>;
+
+STATIC_ASSERT_UNPACKABLE(checked_unpacking_archive_t, std::vector<double>);
+STATIC_ASSERT_UNPACKABLE(checked_unpacking_archive_t, std::map<std::string, std::vector<int>>);
+
+namespace {
+
+// A buffer holding input, with its (leading, fixed width) size prefix
+// replaced by bogus_size
+template <typename T>
+auto with_bogus_size_prefix(T const& input, std::uint64_t bogus_size) {
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  std::memcpy(buffer.data(), &bogus_size, sizeof(bogus_size));
+  return buffer;
+}
+
+// Elements that aren't directly serializable go through the archive one at a
+// time, so a bogus size has to be caught before the loop (or the allocation)
+// rather than by the first read past the end
+template <typename T>
+void expect_bogus_size_rejected(T const& input) {
+  for(std::uint64_t bogus_size : { std::uint64_t(1) << 30, std::uint64_t(1) << 34 }) {
+    auto buffer = with_bogus_size_prefix(input, bogus_size);
+    std::error_code error;
+    auto output = SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+    EXPECT_EQ(error, unpacking_errc::buffer_overrun) << "size prefix " << bogus_size;
+    EXPECT_EQ(output.size(), 0u) << "size prefix " << bogus_size;
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+    try {
+      SimpleSerializationHandler<>::deserialize_checked<T>(buffer);
+      ADD_FAILURE() << "unpacking a bogus size prefix didn't throw";
+    }
+    catch(std::system_error const& e) {
+      EXPECT_EQ(e.code(), make_error_code(unpacking_errc::buffer_overrun));
+    }
+#endif
+  }
+}
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, checked_round_trip) {
+  using T = std::map<std::string, std::vector<double>>;
+  T input{ { "hello", { 1.0, 2.0, 3.0 } }, { "world", { } }, { "", { 4.5 } } };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_FALSE(error);
+  EXPECT_THAT(output, ContainerEq(input));
+  EXPECT_THAT(SimpleSerializationHandler<>::deserialize_checked<T>(buffer), ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_aligned_round_trip) {
+  using T = std::vector<std::vector<double>>;
+  T input{ std::vector<double>(100, 1.5), { 2.0 }, std::vector<double>(37, 3.0) };
+  auto buffer = AlignedSerializationHandler<>::serialize(input);
+  std::error_code error;
+  auto output = AlignedSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_FALSE(error);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, checked_truncated_throws) {
+  using T = std::vector<double>;
+  T input{ 1.0, 2.0, 3.0, 4.0 };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  ConstNonOwningSerializationBuffer truncated(buffer.data(), buffer.capacity() - 1);
+  try {
+    SimpleSerializationHandler<>::deserialize_checked<T>(truncated);
+    FAIL() << "unpacking a truncated buffer didn't throw";
+  }
+  catch(std::system_error const& e) {
+    EXPECT_EQ(e.code(), make_error_code(unpacking_errc::buffer_overrun));
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_truncated_throws_partial_object) {
+  // The first vector is whole when the second one runs out, and has to be
+  // freed before the exception gets out (LeakSanitizer checks this)
+  using T = std::pair<std::vector<double>, std::vector<double>>;
+  T input{ std::vector<double>(50, 1.0), std::vector<double>(50, 2.0) };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  ConstNonOwningSerializationBuffer truncated(buffer.data(), buffer.capacity() - 8);
+  try {
+    SimpleSerializationHandler<>::deserialize_checked<T>(truncated);
+    FAIL() << "unpacking a truncated buffer didn't throw";
+  }
+  catch(std::system_error const& e) {
+    EXPECT_EQ(e.code(), make_error_code(unpacking_errc::buffer_overrun));
+  }
+}
+#endif
+
+TEST_F(TestSimpleSerializationHandler, checked_growable_buffer_bounded_by_size) {
+  using T = std::vector<double>;
+  T input{ 1.0, 2.0, 3.0, 4.0 };
+  auto buffer = SimpleSerializationHandler<>::serialize_single_pass(input);
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_FALSE(error);
+  EXPECT_THAT(output, ContainerEq(input));
+  // The bytes past size() are still allocated, but they aren't packed data
+  buffer.resize(buffer.size() - 1);
+  ASSERT_GT(buffer.capacity(), buffer.size());
+  SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_EQ(error, unpacking_errc::buffer_overrun);
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, checked_unknown_size_rejected) {
+  auto buffer = SimpleSerializationHandler<>::serialize(std::vector<double>{ 1.0 });
+  ConstNonOwningSerializationBuffer pointer_only(buffer.data());
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize_checked<std::vector<double>>(pointer_only),
+    std::invalid_argument
+  );
+}
+#endif
+
+TEST_F(TestSimpleSerializationHandler, checked_every_truncation) {
+  using T = std::map<std::string, std::vector<int>>;
+  T input{ { "hello", { 1, 2, 3 } }, { "world", { 4 } } };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  for(std::size_t size = 0; size < buffer.capacity(); ++size) {
+    ConstNonOwningSerializationBuffer truncated(buffer.data(), size);
+    std::error_code error;
+    SimpleSerializationHandler<>::deserialize_checked<T>(truncated, error);
+    EXPECT_EQ(error, unpacking_errc::buffer_overrun) << "truncated to " << size << " bytes";
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_corrupt_size_prefix) {
+  using T = std::vector<double>;
+  T input{ 1.0, 2.0, 3.0 };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  // Nothing should be allocated for the bogus size before it's rejected
+  auto bogus_size = std::numeric_limits<T::size_type>::max() / 2;
+  std::memcpy(buffer.data(), &bogus_size, sizeof(bogus_size));
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_EQ(error, unpacking_errc::buffer_overrun);
+  EXPECT_EQ(output.size(), 0);
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_corrupt_element_count) {
+  expect_bogus_size_rejected(std::vector<std::string>{ "hello", "world" });
+  expect_bogus_size_rejected(std::map<int, int>{ { 1, 2 }, { 3, 4 } });
+  expect_bogus_size_rejected(std::map<std::string, int>{ { "hello", 2 } });
+  expect_bogus_size_rejected(std::list<int>{ 1, 2, 3 });
+  expect_bogus_size_rejected(std::unordered_map<int, std::string>{ { 1, "hello" } });
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_corrupt_bucket_count) {
+  using T = std::unordered_map<int, double>;
+  T input{ { 1, 2.0 }, { 3, 4.0 } };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  // The bucket count is only a hint, so a bogus one isn't an error, but it
+  // shouldn't be allocated for either
+  auto bogus_bucket_count = std::uint64_t(1) << 40;
+  std::memcpy(buffer.data() + sizeof(std::uint64_t),
+    &bogus_bucket_count, sizeof(bogus_bucket_count)
+  );
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_FALSE(error);
+  EXPECT_EQ(output, input);
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_varint_truncated) {
+  using T = std::vector<std::string>;
+  // The second string's size prefix takes two bytes, and is cut off after one
+  T input{ "hello", std::string(300, 'x') };
+  auto buffer = VarintSerializationHandler<>::serialize(input);
+  ConstNonOwningSerializationBuffer truncated(buffer.data(), 1 + 1 + 5 + 1);
+  std::error_code error;
+  auto output = VarintSerializationHandler<>::deserialize_checked<T>(truncated, error);
+  EXPECT_EQ(error, unpacking_errc::buffer_overrun);
+  ASSERT_EQ(output.size(), 2);
+  EXPECT_EQ(output[0], "hello");
+  EXPECT_EQ(output[1], "");
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_varint_malformed) {
+  using T = std::vector<int>;
+  // A tenth byte with more than the 64th bit in it
+  std::vector<char> too_large(9, static_cast<char>(0xff));
+  too_large.push_back(0x02);
+  // Eleven bytes
+  std::vector<char> too_long(10, static_cast<char>(0x80));
+  too_long.push_back(0x00);
+  for(auto bytes : { too_large, too_long }) {
+    // With only the varint there, and with enough after it that the whole
+    // varint is sure to be in the buffer
+    for(std::size_t padding : { 0, 16 }) {
+      bytes.resize(bytes.size() + padding, 0);
+      ConstNonOwningSerializationBuffer buffer(bytes.data(), bytes.size());
+      std::error_code error;
+      auto output = VarintSerializationHandler<>::deserialize_checked<T>(buffer, error);
+      EXPECT_EQ(error, unpacking_errc::malformed_varint) << "padding " << padding;
+      EXPECT_EQ(output.size(), 0u) << "padding " << padding;
+    }
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_bogus_object_reference) {
+  // A shared pointer tag of 5 refers back to an object with id 3, which
+  // doesn't exist
+  auto buffer = SimpleSerializationHandler<>::serialize(std::uint64_t(5));
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<
+    std::shared_ptr<int>
+  >(buffer, error);
+  EXPECT_EQ(error, unpacking_errc::invalid_object_reference);
+  EXPECT_EQ(output, nullptr);
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize<std::shared_ptr<int>>(buffer),
+    std::runtime_error
+  );
+#endif
+}
+
+TEST_F(TestSimpleSerializationHandler, checked_mistyped_object_reference) {
+  auto shared = std::make_shared<int>(42);
+  auto buffer = SimpleSerializationHandler<>::serialize(std::make_pair(shared, shared));
+  // The second pointer refers back to the first, which was unpacked as an int
+  using T = std::pair<std::shared_ptr<int>, std::shared_ptr<float>>;
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<T>(buffer, error);
+  EXPECT_EQ(error, unpacking_errc::invalid_object_reference);
+  ASSERT_NE(output.first, nullptr);
+  EXPECT_EQ(*output.first, 42);
+  EXPECT_EQ(output.second, nullptr);
+}
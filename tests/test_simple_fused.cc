@@ -0,0 +1,158 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_fused.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/fused.h>
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+namespace {
+
+struct Particle {
+  std::int32_t id = 0;
+  std::int16_t kind = 0;
+  std::string name;
+  double x = 0, y = 0, z = 0;
+  char tag = 0;
+
+  bool operator==(Particle const& other) const {
+    return id == other.id and kind == other.kind and name == other.name
+      and x == other.x and y == other.y and z == other.z and tag == other.tag;
+  }
+};
+
+// Same wire format, one item at a time
+struct FusedParticle : Particle {
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | fused(id, kind, name, x, y, z, tag); }
+};
+
+struct UnfusedParticle : Particle {
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | id | kind | name | x | y | z | tag; }
+};
+
+FusedParticle make_fused() {
+  FusedParticle rv;
+  rv.id = 42; rv.kind = -3; rv.name = "electron";
+  rv.x = 1.5; rv.y = -2.25; rv.z = 1e100; rv.tag = 'e';
+  return rv;
+}
+
+UnfusedParticle make_unfused() {
+  UnfusedParticle rv;
+  static_cast<Particle&>(rv) = make_fused();
+  return rv;
+}
+
+template <typename Handler>
+void expect_same_wire_format() {
+  auto fused_buffer = Handler::serialize(make_fused());
+  auto unfused_buffer = Handler::serialize(make_unfused());
+  ASSERT_EQ(fused_buffer.capacity(), unfused_buffer.capacity());
+  EXPECT_EQ(0, std::memcmp(
+    fused_buffer.data(), unfused_buffer.data(), fused_buffer.capacity()
+  ));
+  auto output = Handler::template deserialize<FusedParticle>(unfused_buffer);
+  EXPECT_EQ(output, make_fused());
+}
+
+} // end anonymous namespace
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, FusedParticle);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, FusedParticle);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, FusedParticle);
+
+static_assert(detail::_fused_runs<SimplePackingArchive<>,
+  std::int32_t, std::int16_t, std::string, double, double, double, char
+>::run_size(3) == 3 * sizeof(double) + 1, "");
+
+TEST_F(TestSimpleSerializationHandler, fused_round_trip) {
+  auto buffer = SimpleSerializationHandler<>::serialize(make_fused());
+  auto output = SimpleSerializationHandler<>::deserialize<FusedParticle>(buffer);
+  EXPECT_EQ(output, make_fused());
+}
+
+TEST_F(TestSimpleSerializationHandler, fused_vector_round_trip) {
+  std::vector<FusedParticle> input(10, make_fused());
+  for(std::size_t i = 0; i < input.size(); ++i) input[i].id = static_cast<std::int32_t>(i);
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<std::vector<FusedParticle>>(buffer);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, fused_same_wire_format) {
+  expect_same_wire_format<SimpleSerializationHandler<>>();
+}
+
+TEST_F(TestSimpleSerializationHandler, fused_same_wire_format_unfusable_layouts) {
+  // Padding, varint integers and byte swapping all fall back to one item at
+  // a time
+  expect_same_wire_format<AlignedSerializationHandler<>>();
+  expect_same_wire_format<VarintSerializationHandler<VarintIntegers>>();
+  expect_same_wire_format<PortableSerializationHandler<BigEndianByteOrder>>();
+}
+
+TEST_F(TestSimpleSerializationHandler, fused_single_pass_and_checked) {
+  auto buffer = SimpleSerializationHandler<>::serialize_single_pass(make_fused());
+  std::error_code error;
+  auto output = SimpleSerializationHandler<>::deserialize_checked<FusedParticle>(buffer, error);
+  EXPECT_FALSE(error);
+  EXPECT_EQ(output, make_fused());
+  // The last run is cut off
+  ConstNonOwningSerializationBuffer truncated(buffer.data(), buffer.size() - 1);
+  SimpleSerializationHandler<>::deserialize_checked<FusedParticle>(truncated, error);
+  EXPECT_EQ(error, unpacking_errc::buffer_overrun);
+}
@@ -0,0 +1,198 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_mapped_file.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/polymorphic/polymorphic_serialization_adapter.h>
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#ifdef DARMA_SERIALIZATION_HAS_MMAP
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+namespace {
+
+struct TestMappedFile : TestSimpleSerializationHandler {
+  void SetUp() override {
+    path = "darma_serialization_test_mapped_file." + std::to_string(::getpid());
+  }
+  void TearDown() override {
+    std::remove(path.c_str());
+  }
+  std::string path;
+};
+
+struct Shape : PolymorphicSerializableObject<Shape> {
+  virtual ~Shape() = default;
+  virtual double area() const = 0;
+};
+
+struct Square : PolymorphicSerializationAdapter<Square, Shape> {
+  double side = 0.0;
+  Square() = default;
+  explicit Square(double s) : side(s) { }
+  double area() const override { return side * side; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | side; }
+};
+
+} // end anonymous namespace
+
+TEST_F(TestMappedFile, round_trip) {
+  using T = std::map<std::string, std::vector<double>>;
+  T input{ { "hello", { 1.0, 2.0, 3.0 } }, { "world", std::vector<double>(10000, 3.14) } };
+  {
+    auto buffer = SimpleSerializationHandler<>::serialize_to_file(
+      path, MappedFileHints{}, input
+    );
+    EXPECT_THAT(buffer.capacity(), Eq(SimpleSerializationHandler<>::serialize(input).capacity()));
+    buffer.sync();
+  }
+  auto output = SimpleSerializationHandler<>::deserialize_from_file<T>(path);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestMappedFile, file_contents_match_serialize) {
+  std::vector<int> input{ 1, 2, 3, 4, 5 };
+  SimpleSerializationHandler<>::serialize_to_file(path, MappedFileHints{}, input, std::string("hello"));
+  auto expected = SimpleSerializationHandler<>::serialize(input, std::string("hello"));
+  std::ifstream file(path, std::ios::binary);
+  std::vector<char> contents{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+  ASSERT_THAT(contents.size(), Eq(expected.capacity()));
+  EXPECT_THAT(std::memcmp(contents.data(), expected.data(), contents.size()), Eq(0));
+}
+
+TEST_F(TestMappedFile, hints) {
+  std::vector<double> input(1 << 16, 2.5);
+  MappedFileHints hints;
+  hints.huge_pages = true;
+  hints.populate = true;
+  SimpleSerializationHandler<>::serialize_to_file(path, hints, input);
+  auto output = SimpleSerializationHandler<>::deserialize_from_file<std::vector<double>>(path, hints);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestMappedFile, polymorphic_round_trip) {
+  std::vector<std::unique_ptr<Shape>> input;
+  input.emplace_back(new Square(2.0));
+  input.emplace_back(nullptr);
+  input.emplace_back(new Square(3.0));
+  std::unique_ptr<Shape> single(new Square(4.0));
+  SimpleSerializationHandler<>::serialize_to_file(path, MappedFileHints{}, input);
+  auto output = SimpleSerializationHandler<>::deserialize_from_file<
+    std::vector<std::unique_ptr<Shape>>
+  >(path);
+  ASSERT_THAT(output.size(), Eq(3u));
+  EXPECT_THAT(output[0]->area(), DoubleEq(4.0));
+  EXPECT_THAT(output[1], IsNull());
+  EXPECT_THAT(output[2]->area(), DoubleEq(9.0));
+
+  SimpleSerializationHandler<>::serialize_to_file(path, MappedFileHints{}, single);
+  auto single_output =
+    SimpleSerializationHandler<>::deserialize_from_file<std::unique_ptr<Shape>>(path);
+  ASSERT_THAT(single_output, NotNull());
+  EXPECT_THAT(single_output->area(), DoubleEq(16.0));
+}
+
+TEST_F(TestMappedFile, empty_file) {
+  { MappedFileSerializationBuffer buffer(path, 0); }
+  MappedFileSerializationBuffer const buffer(path);
+  EXPECT_THAT(buffer.capacity(), Eq(0u));
+  EXPECT_FALSE(buffer.writable());
+}
+
+TEST_F(TestMappedFile, move) {
+  MappedFileSerializationBuffer buffer(path, 16);
+  std::memset(buffer.data(), 'x', 16);
+  MappedFileSerializationBuffer moved(std::move(buffer));
+  EXPECT_THAT(buffer.capacity(), Eq(0u));
+  ASSERT_THAT(moved.capacity(), Eq(16u));
+  EXPECT_THAT(moved.data()[15], Eq('x'));
+  auto& same = moved;
+  moved = std::move(same);
+  ASSERT_THAT(moved.capacity(), Eq(16u));
+  EXPECT_THAT(moved.data()[15], Eq('x'));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestMappedFile, missing_file) {
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize_from_file<int>("/nonexistent/darma_serialization_file"),
+    std::system_error
+  );
+}
+
+TEST_F(TestMappedFile, empty_or_truncated_file) {
+  { MappedFileSerializationBuffer buffer(path, 0); }
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize_from_file<std::vector<double>>(path),
+    std::system_error
+  );
+  // Cut short within the mapping's last page
+  std::vector<double> input(1000, 1.5);
+  SimpleSerializationHandler<>::serialize_to_file(path, MappedFileHints{}, input);
+  ASSERT_THAT(::truncate(path.c_str(), 8000), Eq(0));
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize_from_file<std::vector<double>>(path),
+    std::system_error
+  );
+}
+#endif
+
+#endif // DARMA_SERIALIZATION_HAS_MMAP
@@ -0,0 +1,216 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_packing_checks.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/polymorphic/polymorphic_serialization_adapter.h>
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/fused.h>
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+// Serializers whose compute_size() doesn't match their pack()
+namespace {
+
+struct UnderReportsSize {
+  std::vector<double> values;
+};
+
+struct OverReportsSize {
+  std::vector<double> values;
+};
+
+struct Shape : PolymorphicSerializableObject<Shape> {
+  virtual ~Shape() = default;
+};
+
+struct Square : PolymorphicSerializationAdapter<Square, Shape> {
+  double side = 0.0;
+  Square() = default;
+  explicit Square(double s) : side(s) { }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | side; }
+};
+
+struct PolymorphicUnderReportsSize {
+  std::unique_ptr<Shape> shape;
+};
+
+struct FusedUnderReportsSize {
+  int a;
+  double b;
+  std::int64_t c;
+};
+
+} // end anonymous namespace
+
+namespace darma {
+namespace serialization {
+
+template <>
+struct Serializer<UnderReportsSize> {
+  template <typename Archive>
+  static void compute_size(UnderReportsSize const& obj, Archive& ar) {
+    // Forgot the size prefix
+    add_to_size_raw(ar, obj.values.data(), obj.values.data() + obj.values.size());
+  }
+  template <typename Archive>
+  static void pack(UnderReportsSize const& obj, Archive& ar) { ar | obj.values; }
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    new (allocated) UnderReportsSize{ar.template unpack_next_item_as<std::vector<double>>()};
+  }
+};
+
+template <>
+struct Serializer<OverReportsSize> {
+  template <typename Archive>
+  static void compute_size(OverReportsSize const& obj, Archive& ar) {
+    ar | obj.values;
+    ar | obj.values.size();
+  }
+  template <typename Archive>
+  static void pack(OverReportsSize const& obj, Archive& ar) { ar | obj.values; }
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    new (allocated) OverReportsSize{ar.template unpack_next_item_as<std::vector<double>>()};
+  }
+};
+
+template <>
+struct Serializer<PolymorphicUnderReportsSize> {
+  template <typename Archive>
+  static void compute_size(PolymorphicUnderReportsSize const&, Archive& ar) {
+    // Only the presence flag, not the object
+    ar | true;
+  }
+  template <typename Archive>
+  static void pack(PolymorphicUnderReportsSize const& obj, Archive& ar) {
+    ar | obj.shape;
+  }
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    new (allocated) PolymorphicUnderReportsSize{
+      ar.template unpack_next_item_as<std::unique_ptr<Shape>>()
+    };
+  }
+};
+
+template <>
+struct Serializer<FusedUnderReportsSize> {
+  template <typename Archive>
+  static void compute_size(FusedUnderReportsSize const& obj, Archive& ar) {
+    // Forgot c
+    ar | fused(obj.a, obj.b);
+  }
+  template <typename Archive>
+  static void pack(FusedUnderReportsSize const& obj, Archive& ar) {
+    ar | fused(obj.a, obj.b, obj.c);
+  }
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    auto* obj = new (allocated) FusedUnderReportsSize{};
+    ar | fused(obj->a, obj->b, obj->c);
+  }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+TEST_F(TestSimpleSerializationHandler, packing_checks_pass) {
+  using T = std::vector<std::string>;
+  T input{ "hello", "world", std::string(1000, 'x') };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  EXPECT_THAT(SimpleSerializationHandler<>::deserialize<T>(buffer), ContainerEq(input));
+  auto aligned_buffer = AlignedSerializationHandler<>::serialize(input);
+  EXPECT_THAT(AlignedSerializationHandler<>::deserialize<T>(aligned_buffer), ContainerEq(input));
+  auto varint_buffer = VarintSerializationHandler<>::serialize(input);
+  EXPECT_THAT(VarintSerializationHandler<>::deserialize<T>(varint_buffer), ContainerEq(input));
+}
+
+#if DARMA_SERIALIZATION_CHECK_PACKING
+TEST_F(TestSimpleSerializationHandler, packing_past_capacity_dies) {
+  UnderReportsSize input{ { 1.0, 2.0, 3.0 } };
+  EXPECT_DEATH(
+    SimpleSerializationHandler<>::serialize(input),
+    "packing ran past the end of the buffer"
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, fused_packing_past_capacity_dies) {
+  // fused() copies its runs straight into the buffer, so it has to check the
+  // capacity itself
+  FusedUnderReportsSize input{ 1, 2.0, 3 };
+  EXPECT_DEATH(
+    SimpleSerializationHandler<>::serialize(input),
+    "packing ran past the end of the buffer"
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_packing_past_capacity_dies) {
+  // Polymorphic objects are also packed straight into the buffer
+  PolymorphicUnderReportsSize input{ std::make_unique<Square>(2.0) };
+  EXPECT_DEATH(
+    SimpleSerializationHandler<>::serialize(input),
+    "packing ran past the end of the buffer"
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, packing_size_mismatch_dies) {
+  OverReportsSize input{ { 1.0, 2.0, 3.0 } };
+  EXPECT_DEATH(
+    SimpleSerializationHandler<>::serialize(input),
+    "packed size doesn't match the sizing pass"
+  );
+}
+#endif
@@ -0,0 +1,395 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_polymorphic.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/polymorphic/polymorphic_serialization_adapter.h>
+#include <darma/serialization/serializers/all.h>
+
+#include "test_simple_common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+namespace {
+
+struct Shape : PolymorphicSerializableObject<Shape> {
+  virtual ~Shape() = default;
+  virtual double area() const = 0;
+};
+
+struct Named : PolymorphicSerializableObject<Named> {
+  virtual ~Named() = default;
+  virtual std::string name() const = 0;
+};
+
+struct Circle : PolymorphicSerializationAdapter<Circle, Shape> {
+  double radius = 0.0;
+  Circle() = default;
+  explicit Circle(double r) : radius(r) { }
+  double area() const override { return 3.0 * radius * radius; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | radius; }
+};
+
+struct Rectangle : PolymorphicSerializationAdapter<Rectangle, Shape> {
+  double width = 0.0;
+  double height = 0.0;
+  Rectangle() = default;
+  Rectangle(double w, double h) : width(w), height(h) { }
+  double area() const override { return width * height; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | width | height; }
+};
+
+struct NamedSquareBase : Shape, Named { };
+
+struct NamedSquare
+  : PolymorphicSerializationAdapter<NamedSquare,
+      tinympl::vector<Shape, Named>, NamedSquareBase
+    >
+{
+  double side = 0.0;
+  std::string label;
+  NamedSquare() = default;
+  NamedSquare(double s, std::string l) : side(s), label(std::move(l)) { }
+  double area() const override { return side * side; }
+  std::string name() const override { return label; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | side | label; }
+};
+
+struct CompactCircle : CompactPolymorphicSerializationAdapter<CompactCircle, Shape> {
+  double radius = 0.0;
+  CompactCircle() = default;
+  explicit CompactCircle(double r) : radius(r) { }
+  double area() const override { return 3.0 * radius * radius; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | radius; }
+};
+
+struct CompactNamedSquare
+  : CompactPolymorphicSerializationAdapter<CompactNamedSquare,
+      tinympl::vector<Shape, Named>, NamedSquareBase
+    >
+{
+  double side = 0.0;
+  std::string label;
+  CompactNamedSquare() = default;
+  CompactNamedSquare(double s, std::string l) : side(s), label(std::move(l)) { }
+  double area() const override { return side * side; }
+  std::string name() const override { return label; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | side | label; }
+};
+
+struct ThrowsOnUnpack : PolymorphicSerializationAdapter<ThrowsOnUnpack, Shape> {
+  double area() const override { return 0.0; }
+  template <typename Archive>
+  void serialize(Archive& ar) {
+    if(ar.is_unpacking()) throw std::runtime_error("unpack failed");
+  }
+};
+
+// Keeps track of what's outstanding
+struct CountingMemoryResource : MemoryResource {
+  std::size_t n_outstanding = 0;
+  std::size_t bytes_outstanding = 0;
+  std::size_t n_allocations = 0;
+  void* allocate(std::size_t size, std::size_t) override {
+    ++n_outstanding;
+    ++n_allocations;
+    bytes_outstanding += size;
+    return ::operator new(size);
+  }
+  void deallocate(void* ptr, std::size_t size, std::size_t) noexcept override {
+    --n_outstanding;
+    bytes_outstanding -= size;
+    ::operator delete(ptr);
+  }
+};
+
+template <typename... Objects>
+std::vector<char> pack_all(Objects const&... objs) {
+  std::size_t size = 0;
+  std::initializer_list<int>{ (size += objs.get_packed_size(), 0)... };
+  std::vector<char> rv(size);
+  char* spot = rv.data();
+  std::initializer_list<int>{ (objs.pack(spot), 0)... };
+  EXPECT_EQ(spot, rv.data() + rv.size());
+  return rv;
+}
+
+} // end anonymous namespace
+
+namespace darma {
+namespace serialization {
+
+template <>
+struct polymorphic_type_id<Rectangle> {
+  static constexpr std::uint64_t value() {
+    return polymorphic_type_name_hash("darma::test::Rectangle");
+  }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+static_assert(polymorphic_type_name_hash("") == 0xcbf29ce484222325ull, "");
+static_assert(polymorphic_type_name_hash("a") == 0xaf63dc4c8601ec8cull, "");
+static_assert(polymorphic_type_name_hash("foobar") == 0x85944171f73967e8ull, "");
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_single_base) {
+  auto buffer = pack_all(Circle(2.0), Rectangle(3.0, 4.0), Circle(1.0));
+  char const* spot = buffer.data();
+  auto c1 = Shape::unpack(spot);
+  auto r = Shape::unpack(spot);
+  auto c2 = Shape::unpack(spot);
+  EXPECT_EQ(spot, buffer.data() + buffer.size());
+  EXPECT_THAT(c1->area(), DoubleEq(12.0));
+  EXPECT_THAT(r->area(), DoubleEq(12.0));
+  EXPECT_THAT(c2->area(), DoubleEq(3.0));
+  EXPECT_NE(dynamic_cast<Circle*>(c1.get()), nullptr);
+  EXPECT_NE(dynamic_cast<Rectangle*>(r.get()), nullptr);
+  EXPECT_NE(dynamic_cast<Circle*>(c2.get()), nullptr);
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_multiple_bases) {
+  NamedSquare input(5.0, "hello world");
+  auto buffer = pack_all(input, Rectangle(1.0, 2.0), input);
+  char const* spot = buffer.data();
+  std::unique_ptr<Shape> as_shape = Shape::unpack(spot);
+  auto r = Shape::unpack(spot);
+  std::unique_ptr<Named> as_named = Named::unpack(spot);
+  EXPECT_EQ(spot, buffer.data() + buffer.size());
+  EXPECT_THAT(as_shape->area(), DoubleEq(25.0));
+  EXPECT_THAT(r->area(), DoubleEq(2.0));
+  EXPECT_EQ(as_named->name(), "hello world");
+  EXPECT_EQ(dynamic_cast<NamedSquare&>(*as_shape).label, "hello world");
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_explicit_type_id) {
+  auto buffer = pack_all(Rectangle(3.0, 4.0));
+  detail::PolymorphicAbstractBasesTableEntry entry;
+  std::memcpy(&entry,
+    buffer.data() + sizeof(detail::SerializedPolymorphicObjectHeader), sizeof(entry)
+  );
+  EXPECT_EQ(entry.concrete_id, polymorphic_type_name_hash("darma::test::Rectangle"));
+  EXPECT_EQ(entry.abstract_id, polymorphic_type_id<Shape>::value());
+  char const* spot = buffer.data();
+  auto r = Shape::unpack(spot);
+  EXPECT_THAT(r->area(), DoubleEq(12.0));
+}
+
+namespace {
+
+template <int N>
+polymorphic_unique_ptr<Shape> return_null(char const*&, MemoryResource*) { return nullptr; }
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_registry_lookup) {
+  using function_t = detail::polymorphic_unpack_function_t<Shape>;
+  function_t functions[] = { &return_null<0>, &return_null<1>, &return_null<2> };
+  detail::abstract_base_unpack_registry<Shape> reg;
+  // Enough entries to grow the table a few times, with ids that all land in
+  // the same slot to begin with
+  for(std::uint64_t i = 1; i <= 100; ++i) {
+    EXPECT_TRUE(reg.insert(i << 40, functions[i % 3], typeid(int)));
+  }
+  EXPECT_FALSE(reg.insert(7ull << 40, functions[0], typeid(int)));
+  EXPECT_EQ(reg.size(), 100u);
+  for(std::uint64_t i = 1; i <= 100; ++i) {
+    EXPECT_EQ(reg.find(i << 40), functions[i % 3]);
+  }
+  EXPECT_EQ(reg.find(101ull << 40), nullptr);
+  EXPECT_EQ(reg.find(12345), nullptr);
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, polymorphic_registry_collisions) {
+  detail::abstract_base_unpack_registry<Shape> reg;
+  std::uint64_t const id = 0x1234567800000000ull;
+  EXPECT_TRUE(reg.insert(id, &return_null<0>, typeid(int)));
+  // Same id as a different type
+  EXPECT_THROW(reg.insert(id, &return_null<1>, typeid(long)), std::logic_error);
+  // A different id with the same compact id
+  auto compact_twin = id ^ 0xff000000ffull;
+  ASSERT_NE(compact_twin, id);
+  ASSERT_EQ(detail::compact_polymorphic_type_id(compact_twin),
+    detail::compact_polymorphic_type_id(id)
+  );
+  EXPECT_THROW(reg.insert(compact_twin, &return_null<1>, typeid(long)), std::logic_error);
+  // Neither failed insert changed anything
+  EXPECT_EQ(reg.size(), 1u);
+  EXPECT_EQ(reg.find(compact_twin), nullptr);
+  EXPECT_EQ(reg.find_compact(detail::compact_polymorphic_type_id(id)), &return_null<0>);
+  // Ids whose compact id is zero can't be used at all
+  EXPECT_THROW(reg.insert(0x0000000100000001ull, &return_null<1>, typeid(long)), std::logic_error);
+  // Registering the same type again is fine
+  EXPECT_FALSE(reg.insert(id, &return_null<0>, typeid(int)));
+}
+#endif
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_compact_header_size) {
+  // 8 bytes of data, plus a 40 byte wide header or a 5 byte compact one
+  EXPECT_EQ(Circle(1.0).get_packed_size(), 48u);
+  EXPECT_EQ(CompactCircle(1.0).get_packed_size(), 13u);
+  auto wide_square_size = NamedSquare(1.0, "abc").get_packed_size();
+  auto compact_square_size = CompactNamedSquare(1.0, "abc").get_packed_size();
+  EXPECT_EQ(wide_square_size - compact_square_size, (24u + 2 * 16u) - (1u + 2 * 8u));
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_compact_header) {
+  CompactNamedSquare square(5.0, "hello world");
+  auto buffer = pack_all(
+    CompactCircle(2.0), Circle(1.0), square, Rectangle(1.0, 2.0), square
+  );
+  char const* spot = buffer.data();
+  auto c1 = Shape::unpack(spot);
+  auto c2 = Shape::unpack(spot);
+  auto as_shape = Shape::unpack(spot);
+  auto r = Shape::unpack(spot);
+  auto as_named = Named::unpack(spot);
+  EXPECT_EQ(spot, buffer.data() + buffer.size());
+  EXPECT_THAT(c1->area(), DoubleEq(12.0));
+  EXPECT_NE(dynamic_cast<CompactCircle*>(c1.get()), nullptr);
+  EXPECT_THAT(c2->area(), DoubleEq(3.0));
+  EXPECT_THAT(as_shape->area(), DoubleEq(25.0));
+  EXPECT_THAT(r->area(), DoubleEq(2.0));
+  EXPECT_EQ(as_named->name(), "hello world");
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_memory_resource) {
+  CountingMemoryResource resource;
+  {
+    NamedSquare square(5.0, "hello world");
+    auto buffer = pack_all(Circle(2.0), square, CompactCircle(1.0));
+    char const* spot = buffer.data();
+    auto c1 = Shape::unpack(spot, resource);
+    auto as_named = Named::unpack(spot, resource);
+    auto c2 = Shape::unpack(spot, resource);
+    EXPECT_EQ(spot, buffer.data() + buffer.size());
+    EXPECT_EQ(resource.n_outstanding, 3u);
+    EXPECT_EQ(resource.bytes_outstanding,
+      sizeof(Circle) + sizeof(NamedSquare) + sizeof(CompactCircle)
+    );
+    EXPECT_EQ(c1.get_deleter().resource(), &resource);
+    EXPECT_THAT(c1->area(), DoubleEq(12.0));
+    EXPECT_EQ(as_named->name(), "hello world");
+    EXPECT_THAT(c2->area(), DoubleEq(3.0));
+    // Named isn't the first base of NamedSquare, so this also checks that the
+    // right address is given back to the resource
+    as_named.reset();
+    EXPECT_EQ(resource.n_outstanding, 2u);
+  }
+  EXPECT_EQ(resource.n_outstanding, 0u);
+  EXPECT_EQ(resource.bytes_outstanding, 0u);
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_allocator_memory_resource) {
+  AllocatorMemoryResource<std::allocator<char>> resource;
+  auto buffer = pack_all(Rectangle(3.0, 4.0));
+  char const* spot = buffer.data();
+  auto r = Shape::unpack(spot, resource);
+  EXPECT_THAT(r->area(), DoubleEq(12.0));
+  EXPECT_EQ(r.get_deleter().resource(), &resource);
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, polymorphic_memory_resource_unpack_throws) {
+  CountingMemoryResource resource;
+  auto buffer = pack_all(ThrowsOnUnpack());
+  char const* spot = buffer.data();
+  EXPECT_THROW(Shape::unpack(spot, resource), std::runtime_error);
+  EXPECT_EQ(resource.n_allocations, 1u);
+  EXPECT_EQ(resource.n_outstanding, 0u);
+}
+
+TEST_F(TestSimpleSerializationHandler, polymorphic_allocator_memory_resource_over_aligned) {
+  AllocatorMemoryResource<std::allocator<char>> resource;
+  MemoryResource& as_resource = resource;
+  EXPECT_THROW(
+    as_resource.allocate(64, 2 * alignof(std::max_align_t)), std::invalid_argument
+  );
+  void* ptr = as_resource.allocate(64, alignof(std::max_align_t));
+  EXPECT_THAT(reinterpret_cast<std::uintptr_t>(ptr) % alignof(std::max_align_t), Eq(0u));
+  as_resource.deallocate(ptr, 64, alignof(std::max_align_t));
+}
+#endif
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, polymorphic_unknown_type) {
+  {
+    // Not registered with Named as a base
+    auto buffer = pack_all(Rectangle(3.0, 4.0));
+    char const* spot = buffer.data();
+    EXPECT_THROW(Named::unpack(spot), std::runtime_error);
+  }
+  {
+    // A concrete id that nothing is registered with (e.g., from a binary
+    // with types that this one doesn't have)
+    auto buffer = pack_all(Rectangle(3.0, 4.0));
+    auto const id_offset = sizeof(detail::SerializedPolymorphicObjectHeader)
+      + offsetof(detail::PolymorphicAbstractBasesTableEntry, concrete_id);
+    std::uint64_t unknown_id = polymorphic_type_name_hash("darma::test::Unknown");
+    std::memcpy(buffer.data() + id_offset, &unknown_id, sizeof(unknown_id));
+    char const* spot = buffer.data();
+    EXPECT_THROW(Shape::unpack(spot), std::runtime_error);
+  }
+  {
+    auto buffer = pack_all(CompactCircle(1.0));
+    char const* spot = buffer.data();
+    EXPECT_THROW(Named::unpack(spot), std::runtime_error);
+  }
+}
+#endif
@@ -0,0 +1,174 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_portable.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+#include <darma/serialization/serializers/enum.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+using little_endian_handler_t = PortableSerializationHandler<LittleEndianByteOrder>;
+using big_endian_handler_t = PortableSerializationHandler<BigEndianByteOrder>;
+
+using big_endian_packing_archive_t =
+  SimplePackingArchive<DynamicSerializationBuffer<>, PortableLayout<BigEndianByteOrder>>;
+using big_endian_unpacking_archive_t =
+  SimpleUnpackingArchive<std::allocator<char>, PortableLayout<BigEndianByteOrder>>;
+
+STATIC_ASSERT_PACKABLE(big_endian_packing_archive_t, std::vector<double>);
+STATIC_ASSERT_UNPACKABLE(big_endian_unpacking_archive_t, std::vector<double>);
+
+static_assert(detail::is_byte_swappable<double>::value, "");
+static_assert(detail::is_byte_swappable<std::pair<int const, short>>::value, "");
+static_assert(detail::is_byte_swappable<std::tuple<char, long, float>>::value, "");
+static_assert(detail::is_byte_swappable<int[4]>::value, "");
+static_assert(not detail::is_byte_swappable<long double>::value, "");
+
+namespace {
+
+enum struct Color : std::uint16_t { red = 0x0102, green = 0x0304 };
+
+template <typename Integer>
+Integer read_big_endian(char const* data) {
+  Integer rv = 0;
+  for(std::size_t i = 0; i < sizeof(Integer); ++i) {
+    rv = static_cast<Integer>((rv << 8) | static_cast<unsigned char>(data[i]));
+  }
+  return rv;
+}
+
+template <typename Integer>
+Integer read_little_endian(char const* data) {
+  Integer rv = 0;
+  for(std::size_t i = sizeof(Integer); i > 0; --i) {
+    rv = static_cast<Integer>((rv << 8) | static_cast<unsigned char>(data[i - 1]));
+  }
+  return rv;
+}
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, portable_wire_order) {
+  std::uint32_t value = 0x01020304;
+  auto big = big_endian_handler_t::serialize(value, std::uint16_t(0x0506));
+  EXPECT_THAT(read_big_endian<std::uint32_t>(big.data()), Eq(value));
+  EXPECT_THAT(read_big_endian<std::uint16_t>(big.data() + 4), Eq(0x0506));
+  auto little = little_endian_handler_t::serialize(value, std::uint16_t(0x0506));
+  EXPECT_THAT(read_little_endian<std::uint32_t>(little.data()), Eq(value));
+  EXPECT_THAT(read_little_endian<std::uint16_t>(little.data() + 4), Eq(0x0506));
+}
+
+TEST_F(TestSimpleSerializationHandler, portable_size_prefixes) {
+  // Container sizes go through the same path, so they're in wire order too
+  std::vector<std::int64_t> values{ -1, 2, 0x0102030405060708 };
+  auto buffer = big_endian_handler_t::serialize(values);
+  EXPECT_THAT(read_big_endian<std::uint64_t>(buffer.data()), Eq(3u));
+  EXPECT_THAT(read_big_endian<std::int64_t>(buffer.data() + 8), Eq(-1));
+  EXPECT_THAT(read_big_endian<std::int64_t>(buffer.data() + 24), Eq(0x0102030405060708));
+}
+
+TEST_F(TestSimpleSerializationHandler, portable_round_trip) {
+  // Long enough to go through the vectorized swaps, and odd lengths so that
+  // there's a scalar tail
+  std::vector<double> doubles(1001);
+  std::vector<std::uint16_t> shorts(77);
+  std::vector<float> floats(33);
+  for(std::size_t i = 0; i < doubles.size(); ++i) doubles[i] = 1.5 * i - 100.25;
+  for(std::size_t i = 0; i < shorts.size(); ++i) shorts[i] = static_cast<std::uint16_t>(i * 771);
+  for(std::size_t i = 0; i < floats.size(); ++i) floats[i] = 0.25f * i;
+  std::map<std::string, std::pair<int, double>> map{ { "one", { 1, 1.0 } }, { "two", { -2, 2.5 } } };
+  std::vector<std::tuple<char, long, float>> tuples{ std::make_tuple('a', -5L, 0.5f) };
+  std::unordered_map<int, long> table{ { 1, 10 }, { -2, 20 } };
+  int array[3] = { 7, -8, 9 };
+  Color color = Color::green;
+
+  auto buffer = big_endian_handler_t::serialize(doubles, shorts, floats, map, tuples, table, array, color);
+  auto ar = big_endian_handler_t::make_unpacking_archive(buffer);
+  EXPECT_THAT(ar.unpack_next_item_as<std::vector<double>>(), ContainerEq(doubles));
+  EXPECT_THAT(ar.unpack_next_item_as<std::vector<std::uint16_t>>(), ContainerEq(shorts));
+  EXPECT_THAT(ar.unpack_next_item_as<std::vector<float>>(), ContainerEq(floats));
+  EXPECT_THAT((ar.unpack_next_item_as<std::map<std::string, std::pair<int, double>>>()), ContainerEq(map));
+  EXPECT_THAT((ar.unpack_next_item_as<std::vector<std::tuple<char, long, float>>>()), ContainerEq(tuples));
+  EXPECT_THAT((ar.unpack_next_item_as<std::unordered_map<int, long>>()), ContainerEq(table));
+  int array_out[3];
+  ar.unpack_next_item_at<int[3]>(&array_out);
+  EXPECT_THAT(array_out, ElementsAre(7, -8, 9));
+  EXPECT_THAT(ar.unpack_next_item_as<Color>(), Eq(color));
+}
+
+TEST_F(TestSimpleSerializationHandler, portable_orders_differ) {
+  // Exactly one of the two orders is the host's, and the other is its mirror
+  std::vector<std::uint32_t> values{ 0x01020304, 0x05060708 };
+  auto big = big_endian_handler_t::serialize(values);
+  auto little = little_endian_handler_t::serialize(values);
+  ASSERT_THAT(big.capacity(), Eq(little.capacity()));
+  EXPECT_THAT(read_big_endian<std::uint64_t>(big.data()),
+    Eq(read_little_endian<std::uint64_t>(little.data())));
+  for(std::size_t i = sizeof(std::uint64_t); i < big.capacity(); i += 4) {
+    EXPECT_THAT(read_big_endian<std::uint32_t>(big.data() + i),
+      Eq(read_little_endian<std::uint32_t>(little.data() + i)));
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, portable_single_pass_matches) {
+  std::map<int, std::vector<double>> input{ { 1, { 1.0, 2.0 } }, { 2, std::vector<double>(100, 3.0) } };
+  auto two_pass = big_endian_handler_t::serialize(input);
+  auto single_pass = big_endian_handler_t::serialize_single_pass(input);
+  ASSERT_THAT(single_pass.size(), Eq(two_pass.capacity()));
+  EXPECT_THAT(std::memcmp(two_pass.data(), single_pass.data(), single_pass.size()), Eq(0));
+}
@@ -0,0 +1,179 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_scatter_gather.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+STATIC_ASSERT_PACKABLE(ScatterGatherPackingArchive<>, int);
+STATIC_ASSERT_PACKABLE(ScatterGatherPackingArchive<>, std::string);
+STATIC_ASSERT_PACKABLE(ScatterGatherPackingArchive<>, std::vector<double>);
+
+namespace {
+
+template <typename Allocator>
+std::vector<char> gather(ScatterGatherSerializationBuffer<Allocator> const& buffer) {
+  std::vector<char> rv(buffer.size());
+  buffer.copy_to(rv.data());
+  return rv;
+}
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, scatter_gather_large_vector_not_copied) {
+  using T = std::vector<double>;
+  T input(10000, 3.14);
+  auto buffer = SimpleSerializationHandler<>::serialize_scatter_gather(input);
+  // The size is copied; the elements are referred to
+  ASSERT_THAT(buffer.segments().size(), Eq(2));
+  EXPECT_THAT(buffer.segments()[0].size, Eq(sizeof(std::size_t)));
+  EXPECT_THAT(buffer.segments()[1].data, Eq(static_cast<void const*>(input.data())));
+  EXPECT_THAT(buffer.segments()[1].size, Eq(input.size() * sizeof(double)));
+  EXPECT_THAT(buffer.inline_size(), Eq(sizeof(std::size_t)));
+  auto output = SimpleSerializationHandler<>::deserialize<T>(gather(buffer));
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, scatter_gather_same_bytes_as_contiguous) {
+  using T = std::map<std::string, std::vector<double>>;
+  T input{
+    { "small", { 1.0, 2.0 } },
+    { "large", std::vector<double>(2000, 0.5) },
+    { "empty", { } },
+    { "also large", std::vector<double>(1000, -1.0) }
+  };
+  auto contiguous = SimpleSerializationHandler<>::serialize(input);
+  auto buffer = SimpleSerializationHandler<>::serialize_scatter_gather(input);
+  ASSERT_THAT(buffer.size(), Eq(contiguous.capacity()));
+  auto gathered = gather(buffer);
+  EXPECT_THAT(
+    std::string(gathered.data(), gathered.size()),
+    Eq(std::string(contiguous.data(), contiguous.capacity()))
+  );
+  // Two external segments, each surrounded by inline ones
+  EXPECT_THAT(buffer.segments().size(), Eq(5));
+  EXPECT_THAT(buffer.inline_size(), Lt(buffer.size() - 2000 * sizeof(double)));
+  auto output = SimpleSerializationHandler<>::deserialize<T>(gathered);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, scatter_gather_min_external_size) {
+  using T = std::vector<std::string>;
+  T input{ "hello", "world", "Lorem ipsum dolor sit amet, consectetur adipiscing elit." };
+  auto everything_inline = SimpleSerializationHandler<>::serialize_scatter_gather(input);
+  EXPECT_THAT(everything_inline.segments().size(), Eq(1));
+  EXPECT_THAT(everything_inline.inline_size(), Eq(everything_inline.size()));
+  auto long_strings_external =
+    SimpleSerializationHandler<>::serialize_scatter_gather_with_min_external_size(
+      16, input
+    );
+  // Everything up to the long string, then the long string itself
+  EXPECT_THAT(long_strings_external.segments().size(), Eq(2));
+  EXPECT_THAT(long_strings_external.size(), Eq(everything_inline.size()));
+  auto output = SimpleSerializationHandler<>::deserialize<T>(gather(long_strings_external));
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, scatter_gather_small_min_external_size) {
+  // Size prefixes, shared pointer tags, and unique pointer flags are packed
+  // from temporaries, which mustn't be referred to however small the minimum
+  std::vector<std::string> strings{
+    "hello", "world", "Lorem ipsum dolor sit amet, consectetur adipiscing elit."
+  };
+  auto shared = std::make_shared<int>(42);
+  auto unique = std::make_unique<double>(2.5);
+  std::unordered_map<int, double> table{ { 1, 2.0 }, { 3, 4.0 } };
+  std::vector<double> values(100, 0.5);
+  auto contiguous = SimpleSerializationHandler<>::serialize(
+    strings, shared, shared, unique, table, values
+  );
+  for(std::size_t min_external_size : { 1, 8 }) {
+    auto buffer =
+      SimpleSerializationHandler<>::serialize_scatter_gather_with_min_external_size(
+        min_external_size, strings, shared, shared, unique, table, values
+      );
+    // Only the long string and the vector of doubles are referred to
+    EXPECT_THAT(buffer.inline_size(), Eq(
+      buffer.size() - strings[2].size() - values.size() * sizeof(double)
+    ));
+    auto gathered = gather(buffer);
+    EXPECT_THAT(
+      std::string(gathered.data(), gathered.size()),
+      Eq(std::string(contiguous.data(), contiguous.capacity()))
+    );
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, scatter_gather_inline_buffer_grows) {
+  using T = std::vector<std::string>;
+  T input(1000, "hello world");
+  auto buffer = SimpleSerializationHandler<>::serialize_scatter_gather(input);
+  EXPECT_THAT(buffer.segments().size(), Eq(1));
+  auto output = SimpleSerializationHandler<>::deserialize<T>(gather(buffer));
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+#ifdef DARMA_SERIALIZATION_HAS_IOVEC
+TEST_F(TestSimpleSerializationHandler, scatter_gather_iovecs) {
+  std::vector<double> input(10000, 2.5);
+  auto buffer = SimpleSerializationHandler<>::serialize_scatter_gather(input);
+  auto iovecs = buffer.iovecs();
+  ASSERT_THAT(iovecs.size(), Eq(buffer.segments().size()));
+  for(std::size_t i = 0; i < iovecs.size(); ++i) {
+    EXPECT_THAT(iovecs[i].iov_base, Eq(buffer.segments()[i].data));
+    EXPECT_THAT(iovecs[i].iov_len, Eq(buffer.segments()[i].size));
+  }
+}
+#endif
@@ -0,0 +1,157 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_single_pass.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/map.h>
+#include <darma/serialization/serializers/standard_library/vector.h>
+#include <darma/serialization/serializers/standard_library/string.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+STATIC_ASSERT_PACKABLE(GrowablePackingArchive<>, int);
+STATIC_ASSERT_PACKABLE(GrowablePackingArchive<>, std::string);
+STATIC_ASSERT_PACKABLE(GrowablePackingArchive<>, std::vector<int>);
+STATIC_ASSERT_PACKABLE(GrowablePackingArchive<>, std::map<std::string, std::vector<std::string>>);
+
+TEST_F(TestSimpleSerializationHandler, single_pass_int) {
+  int input = 42;
+  auto buffer = SimpleSerializationHandler<>::serialize_single_pass(input);
+  EXPECT_THAT(buffer.size(), Eq(sizeof(int)));
+  auto output = SimpleSerializationHandler<>::deserialize<int>(buffer);
+  EXPECT_THAT(output, Eq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, single_pass_same_bytes_as_two_pass) {
+  using T = std::map<std::string, std::vector<std::string>>;
+  T input{
+    { "hello", { "world", "there" } },
+    { "goodbye", { } },
+    { "", { "", "Lorem ipsum dolor sit amet, consectetur adipiscing elit." } }
+  };
+  auto two_pass = SimpleSerializationHandler<>::serialize(input);
+  auto single_pass = SimpleSerializationHandler<>::serialize_single_pass(input);
+  ASSERT_THAT(single_pass.size(), Eq(two_pass.capacity()));
+  EXPECT_THAT(
+    std::string(single_pass.data(), single_pass.size()),
+    Eq(std::string(two_pass.data(), two_pass.capacity()))
+  );
+  auto output = SimpleSerializationHandler<>::deserialize<T>(single_pass);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, single_pass_grows_past_initial_capacity) {
+  using T = std::vector<std::string>;
+  T input;
+  for(int i = 0; i < 1000; ++i) {
+    input.emplace_back(i % 37, static_cast<char>('a' + i % 26));
+  }
+  auto buffer = SimpleSerializationHandler<>::serialize_single_pass(input);
+  EXPECT_THAT(buffer.size(), Gt(DARMA_SERIALIZATION_GROWABLE_BUFFER_INITIAL_CAPACITY));
+  EXPECT_THAT(buffer.capacity(), Ge(buffer.size()));
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, single_pass_multiple_objects) {
+  auto buffer = SimpleSerializationHandler<>::serialize_single_pass(
+    std::string("hello"), 42, std::vector<double>{1.0, 2.0, 3.0}
+  );
+  auto ar = SimpleSerializationHandler<>::make_unpacking_archive(buffer);
+  auto str = ar.unpack_next_item_as<std::string>();
+  auto i = ar.unpack_next_item_as<int>();
+  auto vec = ar.unpack_next_item_as<std::vector<double>>();
+  EXPECT_THAT(str, Eq("hello"));
+  EXPECT_THAT(i, Eq(42));
+  EXPECT_THAT(vec, ElementsAre(1.0, 2.0, 3.0));
+}
+
+TEST_F(TestSimpleSerializationHandler, growable_buffer_move) {
+  GrowableSerializationBuffer<> buffer(4);
+  buffer.resize(3);
+  std::memcpy(buffer.data(), "abc", 3);
+  buffer.reserve(1024);
+  EXPECT_THAT(std::string(buffer.data(), buffer.size()), Eq("abc"));
+  GrowableSerializationBuffer<> other(std::move(buffer));
+  EXPECT_THAT(buffer.data(), IsNull());
+  EXPECT_THAT(buffer.size(), Eq(0));
+  EXPECT_THAT(other.capacity(), Ge(1024));
+  EXPECT_THAT(std::string(other.data(), other.size()), Eq("abc"));
+}
+
+TEST_F(TestSimpleSerializationHandler, growable_buffer_resize_grows_geometrically) {
+  GrowableSerializationBuffer<> buffer(1);
+  int reallocations = 0;
+  for(std::size_t size = 1; size <= 1 << 16; ++size) {
+    auto const* data = buffer.data();
+    buffer.resize(size);
+    buffer.data()[size - 1] = static_cast<char>(size);
+    if(buffer.data() != data) ++reallocations;
+  }
+  EXPECT_THAT(reallocations, Le(16));
+  EXPECT_THAT(buffer.data()[255], Eq(static_cast<char>(256)));
+  // reserve() doesn't over-allocate
+  buffer.reserve(1 << 20);
+  EXPECT_THAT(buffer.capacity(), Eq(1 << 20));
+}
+
+TEST_F(TestSimpleSerializationHandler, growable_buffer_self_move_assign) {
+  GrowableSerializationBuffer<> buffer(4);
+  buffer.resize(3);
+  std::memcpy(buffer.data(), "abc", 3);
+  auto& same = buffer;
+  buffer = std::move(same);
+  EXPECT_THAT(buffer.size(), Eq(3));
+  EXPECT_THAT(std::string(buffer.data(), buffer.size()), Eq("abc"));
+
+  DynamicSerializationBuffer<> dynamic(3);
+  std::memcpy(dynamic.data(), "xyz", 3);
+  auto& same_dynamic = dynamic;
+  dynamic = std::move(same_dynamic);
+  EXPECT_THAT(std::string(dynamic.data(), dynamic.capacity()), Eq("xyz"));
+}
@@ -50,6 +50,8 @@
 
 #include "test_simple_common.h"
 
+#include <functional>
+
 using namespace darma::serialization;
 using namespace ::testing;
 
@@ -63,4 +65,15 @@ TEST_F(TestSimpleSerializationHandler, map_int_int) {
   auto buffer = SimpleSerializationHandler<>::serialize(input);
   auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
   EXPECT_THAT(input, ContainerEq(output));
-}
\ No newline at end of file
+}
+
+TEST_F(TestSimpleSerializationHandler, map_int_int_many_greater) {
+  // Elements are inserted at the end on unpack, so make sure that ordering
+  // still comes out right with a lot of elements and a non-default comparator
+  using T = std::map<int, int, std::greater<int>>;
+  T input;
+  for(int i = 0; i < 10000; ++i) input.emplace(i * 7 % 10007, i);
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(input, ContainerEq(output));
+}
@@ -51,6 +51,8 @@
 
 #include "test_simple_common.h"
 
+#include <functional>
+
 using namespace darma::serialization;
 using namespace ::testing;
 
@@ -70,6 +72,17 @@ TEST_F(TestSimpleSerializationHandler, set_int) {
   EXPECT_THAT(input, ContainerEq(output));
 }
 
+TEST_F(TestSimpleSerializationHandler, set_int_many_greater) {
+  // Elements are inserted at the end on unpack, so make sure that ordering
+  // still comes out right with a lot of elements and a non-default comparator
+  using T = std::set<int, std::greater<int>>;
+  T input;
+  for(int i = 0; i < 10000; ++i) input.insert(i * 7 % 10007);
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(input, ContainerEq(output));
+}
+
 TEST_F(TestSimpleSerializationHandler, set_string) {
   using T = std::set<std::string>;
   T input{"hello", "there", "world", "goodbye"};
@@ -0,0 +1,204 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_std_shared_ptr.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/polymorphic/polymorphic_serialization_adapter.h>
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+namespace {
+
+struct Shape : PolymorphicSerializableObject<Shape> {
+  virtual ~Shape() = default;
+  virtual double area() const = 0;
+};
+
+struct Circle : PolymorphicSerializationAdapter<Circle, Shape> {
+  double radius = 0.0;
+  Circle() = default;
+  explicit Circle(double r) : radius(r) { }
+  double area() const override { return 3.0 * radius * radius; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | radius; }
+};
+
+struct MeshBlock {
+  std::vector<double> values;
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | values; }
+};
+
+struct Element {
+  int id = 0;
+  std::shared_ptr<MeshBlock> block;
+  std::weak_ptr<MeshBlock> neighbor_block;
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | id | block | neighbor_block; }
+};
+
+} // end anonymous namespace
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::shared_ptr<int>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::shared_ptr<int>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::shared_ptr<int>);
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::weak_ptr<int>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::weak_ptr<int>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::weak_ptr<int>);
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_string) {
+  using T = std::shared_ptr<std::string>;
+  T input = std::make_shared<std::string>("hello world");
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output, Ne(nullptr));
+  EXPECT_THAT(*output, Eq("hello world"));
+  EXPECT_THAT(output.use_count(), Eq(1));
+}
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_null) {
+  using T = std::shared_ptr<std::string>;
+  T input;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(output, Eq(nullptr));
+}
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_sharing_preserved) {
+  using T = std::vector<std::shared_ptr<std::string>>;
+  auto hello = std::make_shared<std::string>("hello");
+  auto world = std::make_shared<std::string>("world");
+  T input{ hello, world, hello, nullptr, world, hello };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output.size(), Eq(6));
+  EXPECT_THAT(*output[0], Eq("hello"));
+  EXPECT_THAT(*output[1], Eq("world"));
+  EXPECT_THAT(output[2], Eq(output[0]));
+  EXPECT_THAT(output[3], Eq(nullptr));
+  EXPECT_THAT(output[4], Eq(output[1]));
+  EXPECT_THAT(output[5], Eq(output[0]));
+  EXPECT_THAT(output[0].use_count(), Eq(3));
+}
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_packed_once) {
+  using T = std::vector<std::shared_ptr<MeshBlock>>;
+  auto block = std::make_shared<MeshBlock>();
+  block->values.assign(1000, 1.5);
+  T shared(10, block);
+  T separate;
+  for(int i = 0; i < 10; ++i) separate.push_back(std::make_shared<MeshBlock>(*block));
+  auto shared_buffer = SimpleSerializationHandler<>::serialize(shared);
+  auto separate_buffer = SimpleSerializationHandler<>::serialize(separate);
+  auto block_size = SimpleSerializationHandler<>::serialize(*block).capacity();
+  EXPECT_THAT(shared_buffer.capacity(),
+    Eq(sizeof(std::size_t) + 10 * sizeof(std::size_t) + block_size)
+  );
+  EXPECT_THAT(separate_buffer.capacity(),
+    Eq(sizeof(std::size_t) + 10 * (sizeof(std::size_t) + block_size))
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_in_members) {
+  using T = std::vector<Element>;
+  auto a = std::make_shared<MeshBlock>(MeshBlock{ { 1.0, 2.0 } });
+  auto b = std::make_shared<MeshBlock>(MeshBlock{ { 3.0 } });
+  T input{ { 0, a, b }, { 1, b, a }, { 2, a, { } } };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output.size(), Eq(3));
+  EXPECT_THAT(output[0].block->values, ElementsAre(1.0, 2.0));
+  EXPECT_THAT(output[1].block->values, ElementsAre(3.0));
+  EXPECT_THAT(output[2].block, Eq(output[0].block));
+  EXPECT_THAT(output[0].neighbor_block.lock(), Eq(output[1].block));
+  EXPECT_THAT(output[1].neighbor_block.lock(), Eq(output[0].block));
+  EXPECT_TRUE(output[2].neighbor_block.expired());
+}
+
+TEST_F(TestSimpleSerializationHandler, weak_ptr_only_reference_expires) {
+  using T = std::weak_ptr<std::string>;
+  auto str = std::make_shared<std::string>("hello");
+  T input = str;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  // Nothing else owns the unpacked object
+  EXPECT_TRUE(output.expired());
+}
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_polymorphic) {
+  using T = std::vector<std::shared_ptr<Shape>>;
+  std::shared_ptr<Shape> circle = std::make_shared<Circle>(2.0);
+  T input{ circle, circle };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output.size(), Eq(2));
+  ASSERT_THAT(output[0], Ne(nullptr));
+  EXPECT_TRUE(typeid(*output[0]) == typeid(Circle));
+  EXPECT_THAT(output[0]->area(), DoubleEq(12.0));
+  EXPECT_THAT(output[1], Eq(output[0]));
+}
+
+TEST_F(TestSimpleSerializationHandler, shared_ptr_single_pass) {
+  using T = std::vector<std::shared_ptr<std::string>>;
+  auto hello = std::make_shared<std::string>("hello");
+  T input{ hello, nullptr, hello };
+  auto two_pass = SimpleSerializationHandler<>::serialize(input);
+  auto single_pass = SimpleSerializationHandler<>::serialize_single_pass(input);
+  ASSERT_THAT(single_pass.size(), Eq(two_pass.capacity()));
+  auto output = SimpleSerializationHandler<>::deserialize<T>(single_pass);
+  ASSERT_THAT(output.size(), Eq(3));
+  EXPECT_THAT(*output[0], Eq("hello"));
+  EXPECT_THAT(output[2], Eq(output[0]));
+}
@@ -0,0 +1,298 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_std_unique_ptr.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/polymorphic/polymorphic_serializable_object.h>
+#include <darma/serialization/polymorphic/polymorphic_serialization_adapter.h>
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+namespace {
+
+struct Shape : PolymorphicSerializableObject<Shape> {
+  virtual ~Shape() = default;
+  virtual double area() const = 0;
+};
+
+struct Circle : PolymorphicSerializationAdapter<Circle, Shape> {
+  double radius = 0.0;
+  Circle() = default;
+  explicit Circle(double r) : radius(r) { }
+  double area() const override { return 3.0 * radius * radius; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | radius; }
+};
+
+struct Rectangle : PolymorphicSerializationAdapter<Rectangle, Shape> {
+  double width = 0.0;
+  double height = 0.0;
+  Rectangle() = default;
+  Rectangle(double w, double h) : width(w), height(h) { }
+  double area() const override { return width * height; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | width | height; }
+};
+
+struct CompactCircle : CompactPolymorphicSerializationAdapter<CompactCircle, Shape> {
+  double radius = 0.0;
+  CompactCircle() = default;
+  explicit CompactCircle(double r) : radius(r) { }
+  double area() const override { return 3.0 * radius * radius; }
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | radius; }
+};
+
+// A separate hierarchy, whose types aren't registered as Shapes
+struct Labeled : PolymorphicSerializableObject<Labeled> {
+  virtual ~Labeled() = default;
+};
+
+struct Tag : PolymorphicSerializationAdapter<Tag, Labeled> {
+  int value = 0;
+  template <typename Archive>
+  void serialize(Archive& ar) { ar | value; }
+};
+
+using shape_vector_t = std::vector<std::unique_ptr<Shape>>;
+
+shape_vector_t make_shapes(std::vector<int> const& kinds) {
+  shape_vector_t rv;
+  double value = 1.0;
+  for(auto kind : kinds) {
+    switch(kind) {
+      case 0: rv.emplace_back(nullptr); break;
+      case 1: rv.emplace_back(new Circle(value)); break;
+      case 2: rv.emplace_back(new Rectangle(value, value + 1.0)); break;
+      case 3: rv.emplace_back(new CompactCircle(value)); break;
+    }
+    value += 1.0;
+  }
+  return rv;
+}
+
+void expect_same_shapes(shape_vector_t const& expected, shape_vector_t const& actual) {
+  ASSERT_THAT(actual.size(), Eq(expected.size()));
+  for(size_t i = 0; i < expected.size(); ++i) {
+    if(expected[i] == nullptr) {
+      EXPECT_THAT(actual[i], Eq(nullptr));
+    }
+    else {
+      ASSERT_THAT(actual[i], Ne(nullptr));
+      EXPECT_TRUE(typeid(*actual[i]) == typeid(*expected[i]));
+      EXPECT_THAT(actual[i]->area(), DoubleEq(expected[i]->area()));
+    }
+  }
+}
+
+} // end anonymous namespace
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unique_ptr<int>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unique_ptr<int>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unique_ptr<int>);
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unique_ptr<Shape>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unique_ptr<Shape>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unique_ptr<Shape>);
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, shape_vector_t);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, shape_vector_t);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, shape_vector_t);
+
+TEST_F(TestSimpleSerializationHandler, unique_ptr_int) {
+  using T = std::unique_ptr<int>;
+  T input(new int(42));
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output, Ne(nullptr));
+  EXPECT_THAT(*output, Eq(42));
+}
+
+TEST_F(TestSimpleSerializationHandler, unique_ptr_string) {
+  using T = std::unique_ptr<std::string>;
+  T input(new std::string("hello world"));
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output, Ne(nullptr));
+  EXPECT_THAT(*output, Eq("hello world"));
+}
+
+TEST_F(TestSimpleSerializationHandler, unique_ptr_null) {
+  using T = std::unique_ptr<std::string>;
+  T input;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(output, Eq(nullptr));
+}
+
+TEST_F(TestSimpleSerializationHandler, unique_ptr_polymorphic) {
+  using T = std::unique_ptr<Shape>;
+  T input(new Rectangle(2.0, 3.5));
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output, Ne(nullptr));
+  EXPECT_TRUE(typeid(*output) == typeid(Rectangle));
+  EXPECT_THAT(output->area(), DoubleEq(7.0));
+}
+
+TEST_F(TestSimpleSerializationHandler, unique_ptr_polymorphic_null) {
+  using T = std::unique_ptr<Shape>;
+  T input;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(output, Eq(nullptr));
+}
+
+TEST_F(TestSimpleSerializationHandler, vector_unique_ptr_polymorphic_mixed) {
+  auto input = make_shapes({ 1, 1, 1, 0, 2, 2, 3, 3, 0, 0, 1, 2, 3 });
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<shape_vector_t>(buffer);
+  expect_same_shapes(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, vector_unique_ptr_polymorphic_empty) {
+  shape_vector_t input;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<shape_vector_t>(buffer);
+  expect_same_shapes(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, vector_unique_ptr_polymorphic_groups_headers) {
+  auto input = make_shapes(std::vector<int>(100, 1));
+  size_t individually = sizeof(size_t);
+  for(auto const& shape : input) {
+    individually += sizeof(bool) + shape->get_packed_size();
+  }
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  // One run, with one header
+  auto header_size = input[0]->get_packed_header_size();
+  EXPECT_THAT(buffer.capacity(),
+    Eq(2 * sizeof(size_t) + sizeof(std::uint8_t) + header_size + 100 * sizeof(double))
+  );
+  EXPECT_THAT(buffer.capacity(), Lt(individually));
+  auto output = SimpleSerializationHandler<>::deserialize<shape_vector_t>(buffer);
+  expect_same_shapes(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, vector_unique_ptr_polymorphic_single_pass) {
+  auto input = make_shapes({ 2, 2, 0, 1, 3, 3, 3 });
+  auto two_pass = SimpleSerializationHandler<>::serialize(input);
+  auto single_pass = SimpleSerializationHandler<>::serialize_single_pass(input);
+  ASSERT_THAT(single_pass.size(), Eq(two_pass.capacity()));
+  EXPECT_THAT(
+    std::string(single_pass.data(), single_pass.size()),
+    Eq(std::string(two_pass.data(), two_pass.capacity()))
+  );
+  auto output = SimpleSerializationHandler<>::deserialize<shape_vector_t>(single_pass);
+  expect_same_shapes(input, output);
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, vector_unique_ptr_polymorphic_corrupt_runs) {
+  // One run of two nulls: the size, the run length, then the run kind
+  auto input = make_shapes({ 0, 0 });
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  ASSERT_THAT(buffer.capacity(), Eq(2 * sizeof(size_t) + sizeof(std::uint8_t)));
+  auto with_run = [&](size_t run_length, std::uint8_t kind) {
+    std::vector<char> corrupt(buffer.data(), buffer.data() + buffer.capacity());
+    std::memcpy(corrupt.data() + sizeof(size_t), &run_length, sizeof(size_t));
+    std::memcpy(corrupt.data() + 2 * sizeof(size_t), &kind, sizeof(kind));
+    return corrupt;
+  };
+  // An empty run, one longer than what's left, and an unknown kind
+  for(auto corrupt : { with_run(0, 0), with_run(3, 0), with_run(2, 7) }) {
+    EXPECT_THROW(
+      SimpleSerializationHandler<>::deserialize<shape_vector_t>(
+        ConstNonOwningSerializationBuffer(corrupt.data(), corrupt.size())
+      ),
+      std::runtime_error
+    );
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, unique_ptr_polymorphic_unknown_type) {
+  auto buffer = SimpleSerializationHandler<>::serialize(
+    std::unique_ptr<Labeled>(new Tag())
+  );
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize<std::unique_ptr<Shape>>(buffer),
+    std::runtime_error
+  );
+  std::vector<std::unique_ptr<Labeled>> tags;
+  tags.emplace_back(new Tag());
+  tags.emplace_back(new Tag());
+  auto vector_buffer = SimpleSerializationHandler<>::serialize(tags);
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize<shape_vector_t>(vector_buffer),
+    std::runtime_error
+  );
+}
+#endif
+
+TEST_F(TestSimpleSerializationHandler, vector_unique_ptr_int) {
+  using T = std::vector<std::unique_ptr<int>>;
+  T input;
+  input.emplace_back(new int(1));
+  input.emplace_back(nullptr);
+  input.emplace_back(new int(3));
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  ASSERT_THAT(output.size(), Eq(3));
+  ASSERT_THAT(output[0], Ne(nullptr));
+  EXPECT_THAT(*output[0], Eq(1));
+  EXPECT_THAT(output[1], Eq(nullptr));
+  ASSERT_THAT(output[2], Ne(nullptr));
+  EXPECT_THAT(*output[2], Eq(3));
+}
@@ -0,0 +1,113 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_std_unordered_map.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/unordered_map.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+
+#include <darma/serialization/serializers/standard_library/string.h>
+#include <darma/serialization/serializers/standard_library/vector.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unordered_map<int, double>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unordered_map<int, double>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unordered_map<int, double>);
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unordered_map<std::string, std::vector<int>>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unordered_map<std::string, std::vector<int>>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unordered_map<std::string, std::vector<int>>);
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unordered_multimap<int, std::string>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unordered_multimap<int, std::string>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unordered_multimap<int, std::string>);
+
+TEST_F(TestSimpleSerializationHandler, unordered_map_int_double) {
+  using T = std::unordered_map<int, double>;
+  T input{{1, 2.5}, {3, 4.5}, {5, 6.5}};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_map_int_double_empty) {
+  using T = std::unordered_map<int, double>;
+  T input;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_map_string_vector) {
+  using T = std::unordered_map<std::string, std::vector<int>>;
+  T input{{"hello", {1, 2, 3}}, {"world", {}}, {"", {4}}};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_multimap_int_string) {
+  using T = std::unordered_multimap<int, std::string>;
+  T input{{1, "hello"}, {1, "world"}, {2, "hello"}, {1, "hello"}};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_map_table_shape) {
+  using T = std::unordered_map<int, double>;
+  T input;
+  input.max_load_factor(0.5f);
+  input.reserve(1000);
+  for(int i = 0; i < 700; ++i) input.emplace(i * 13, i);
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+  EXPECT_EQ(input.bucket_count(), output.bucket_count());
+  EXPECT_EQ(input.max_load_factor(), output.max_load_factor());
+}
@@ -0,0 +1,99 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_std_unordered_set.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/unordered_set.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+
+#include <darma/serialization/serializers/standard_library/string.h>
+
+#include <darma/serialization/simple_handler.h>
+
+#include "test_simple_common.h"
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unordered_set<int>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unordered_set<int>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unordered_set<int>);
+
+STATIC_ASSERT_SIZABLE(SimpleSizingArchive, std::unordered_set<std::string>);
+STATIC_ASSERT_PACKABLE(SimplePackingArchive<>, std::unordered_set<std::string>);
+STATIC_ASSERT_UNPACKABLE(SimpleUnpackingArchive<>, std::unordered_set<std::string>);
+
+TEST_F(TestSimpleSerializationHandler, unordered_set_int) {
+  using T = std::unordered_set<int>;
+  T input{1, 2, 3, 4, 5};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_set_string) {
+  using T = std::unordered_set<std::string>;
+  T input{"hello", "there", "world", "goodbye"};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_multiset_string) {
+  using T = std::unordered_multiset<std::string>;
+  T input{"hello", "world", "hello", "hello"};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+}
+
+TEST_F(TestSimpleSerializationHandler, unordered_set_table_shape) {
+  using T = std::unordered_set<std::string>;
+  T input(2000);
+  input.max_load_factor(2.0f);
+  for(int i = 0; i < 500; ++i) input.emplace(std::to_string(i));
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_EQ(input, output);
+  EXPECT_EQ(input.bucket_count(), output.bucket_count());
+  EXPECT_EQ(input.max_load_factor(), output.max_load_factor());
+}
@@ -51,6 +51,8 @@
 
 #include "test_simple_common.h"
 
+#include <stdexcept>
+
 using namespace darma::serialization;
 using namespace ::testing;
 
@@ -107,3 +109,84 @@ TEST_F(TestSimpleSerializationHandler, vector_long_strings) {
   auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
   EXPECT_THAT(input, ContainerEq(output));
 }
+
+TEST_F(TestSimpleSerializationHandler, vector_vector_string) {
+  using T = std::vector<std::vector<std::string>>;
+  T input{ { "hello", "world" }, { }, { "Lorem ipsum dolor sit amet, consectetur adipiscing elit." } };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(input, ContainerEq(output));
+}
+
+// Element types that can't be unpacked in place, and one whose unpack throws
+namespace {
+
+struct NotDefaultConstructible {
+  explicit NotDefaultConstructible(std::string v) : value(std::move(v)) { }
+  std::string value;
+  bool operator==(NotDefaultConstructible const& other) const { return value == other.value; }
+};
+
+struct ThrowsOnUnpack {
+  std::string value;
+  static int unpacks_before_throwing;
+};
+int ThrowsOnUnpack::unpacks_before_throwing = 0;
+
+} // end anonymous namespace
+
+namespace darma {
+namespace serialization {
+
+template <>
+struct Serializer<NotDefaultConstructible> {
+  template <typename Archive>
+  static void compute_size(NotDefaultConstructible const& obj, Archive& ar) { ar | obj.value; }
+  template <typename Archive>
+  static void pack(NotDefaultConstructible const& obj, Archive& ar) { ar | obj.value; }
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    new (allocated) NotDefaultConstructible(ar.template unpack_next_item_as<std::string>());
+  }
+};
+
+template <>
+struct Serializer<ThrowsOnUnpack> {
+  template <typename Archive>
+  static void compute_size(ThrowsOnUnpack const& obj, Archive& ar) { ar | obj.value; }
+  template <typename Archive>
+  static void pack(ThrowsOnUnpack const& obj, Archive& ar) { ar | obj.value; }
+  template <typename Archive>
+  static void unpack(void* allocated, Archive& ar) {
+    if(ThrowsOnUnpack::unpacks_before_throwing-- == 0) {
+      throw std::runtime_error("unpack failed");
+    }
+    new (allocated) ThrowsOnUnpack{ar.template unpack_next_item_as<std::string>()};
+  }
+};
+
+} // end namespace serialization
+} // end namespace darma
+
+TEST_F(TestSimpleSerializationHandler, vector_not_default_constructible) {
+  using T = std::vector<NotDefaultConstructible>;
+  T input{ NotDefaultConstructible("hello"), NotDefaultConstructible("world") };
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto output = SimpleSerializationHandler<>::deserialize<T>(buffer);
+  EXPECT_THAT(input, ContainerEq(output));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, vector_unpack_throws) {
+  using T = std::vector<ThrowsOnUnpack>;
+  T input(4, ThrowsOnUnpack{ "Lorem ipsum dolor sit amet, consectetur adipiscing elit." });
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  ThrowsOnUnpack::unpacks_before_throwing = 2;
+  // The partially unpacked vector has to be cleaned up properly (checked
+  // under sanitizers or valgrind)
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize<T>(buffer),
+    std::runtime_error
+  );
+}
+#endif
@@ -0,0 +1,313 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_streaming.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/all.h>
+
+#include <darma/serialization/simple_handler.h>
+#include <darma/serialization/streaming_handler.h>
+
+#include "test_simple_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+STATIC_ASSERT_PACKABLE(StreamingPackingArchive, int);
+STATIC_ASSERT_PACKABLE(StreamingPackingArchive, std::string);
+STATIC_ASSERT_PACKABLE(StreamingPackingArchive, std::vector<double>);
+STATIC_ASSERT_UNPACKABLE(StreamingUnpackingArchive<>, int);
+STATIC_ASSERT_UNPACKABLE(StreamingUnpackingArchive<>, std::string);
+STATIC_ASSERT_UNPACKABLE(StreamingUnpackingArchive<>, std::vector<double>);
+
+namespace {
+
+using nested_t = std::map<std::string, std::vector<std::string>>;
+
+nested_t make_nested() {
+  nested_t rv;
+  for(int i = 0; i < 100; ++i) {
+    auto& values = rv[std::to_string(i)];
+    for(int j = 0; j < i % 7; ++j) {
+      values.emplace_back(5 + (i * j) % 40, static_cast<char>('a' + j));
+    }
+  }
+  return rv;
+}
+
+// A source that gives at most max_read bytes of data at a time
+struct StringSource {
+  std::string const& data;
+  std::size_t max_read;
+  std::size_t offset = 0;
+  std::size_t largest_request = 0;
+
+  std::size_t operator()(char* dest, std::size_t size) {
+    largest_request = std::max(largest_request, size);
+    auto n = std::min({ size, max_read, data.size() - offset });
+    std::memcpy(dest, data.data() + offset, n);
+    offset += n;
+    return n;
+  }
+};
+
+struct allocation_counts {
+  std::size_t allocations = 0;
+  std::size_t deallocations = 0;
+};
+
+// A stateful allocator that counts the allocations made through it (and
+// through all of its rebound copies)
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  explicit CountingAllocator(allocation_counts& counts) : counts(&counts) { }
+  template <typename U>
+  CountingAllocator(CountingAllocator<U> const& other) : counts(other.counts) { }
+
+  T* allocate(std::size_t n) {
+    ++counts->allocations;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T* ptr, std::size_t n) {
+    ++counts->deallocations;
+    std::allocator<T>{}.deallocate(ptr, n);
+  }
+
+  template <typename U>
+  bool operator==(CountingAllocator<U> const& other) const { return counts == other.counts; }
+  template <typename U>
+  bool operator!=(CountingAllocator<U> const& other) const { return counts != other.counts; }
+
+  allocation_counts* counts;
+};
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, streaming_same_bytes_as_contiguous) {
+  auto input = make_nested();
+  auto contiguous = SimpleSerializationHandler<>::serialize(input);
+  std::string streamed;
+  auto size = StreamingSerializationHandler<>::serialize_streaming(
+    [&](char const* data, std::size_t n) { streamed.append(data, n); },
+    input
+  );
+  EXPECT_THAT(size, Eq(contiguous.capacity()));
+  EXPECT_THAT(streamed, Eq(std::string(contiguous.data(), contiguous.capacity())));
+  auto output = SimpleSerializationHandler<>::deserialize<nested_t>(streamed);
+  EXPECT_THAT(output, ContainerEq(input));
+}
+
+TEST_F(TestSimpleSerializationHandler, streaming_small_chunks) {
+  // Raw data straddles many chunks, and the packer has to wait for the sink
+  // almost every time
+  std::vector<double> input(10000);
+  for(std::size_t i = 0; i < input.size(); ++i) input[i] = 0.5 * i;
+  auto contiguous = SimpleSerializationHandler<>::serialize(input);
+  for(std::size_t n_chunks : { 1, 2, 3 }) {
+    std::string streamed;
+    std::size_t max_chunk = 0;
+    auto ar = StreamingSerializationHandler<>::make_streaming_packing_archive(
+      [&](char const* data, std::size_t n) {
+        streamed.append(data, n);
+        max_chunk = std::max(max_chunk, n);
+      },
+      /* chunk_size = */ 100, n_chunks
+    );
+    ar | input;
+    auto size = StreamingSerializationHandler<>::finish_streaming(std::move(ar));
+    EXPECT_THAT(size, Eq(contiguous.capacity()));
+    EXPECT_THAT(max_chunk, Eq(100));
+    EXPECT_THAT(streamed, Eq(std::string(contiguous.data(), contiguous.capacity())));
+  }
+}
+
+TEST_F(TestSimpleSerializationHandler, streaming_backpressure) {
+  std::string input(100000, 'x');
+  std::atomic<std::size_t> received{0};
+  std::size_t max_ahead = 0;
+  auto ar = StreamingSerializationHandler<>::make_streaming_packing_archive(
+    [&](char const*, std::size_t n) {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+      received += n;
+    },
+    /* chunk_size = */ 1000, /* n_chunks = */ 4
+  );
+  // Pack in pieces, checking that the packer never gets more than the ring's
+  // worth of bytes ahead of the sink
+  for(std::size_t i = 0; i < input.size(); i += 500) {
+    ar.pack_data_raw(input.data() + i, input.data() + i + 500);
+    max_ahead = std::max(max_ahead, ar.bytes_packed() - received.load());
+  }
+  EXPECT_THAT(max_ahead, Le(4 * 1000));
+  EXPECT_THAT(StreamingSerializationHandler<>::finish_streaming(std::move(ar)), Eq(input.size()));
+  EXPECT_THAT(received.load(), Eq(input.size()));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, streaming_sink_throws) {
+  std::vector<double> input(10000, 1.0);
+  for(std::size_t n_chunks : { 1, 4 }) {
+    int calls = 0;
+    EXPECT_THROW(
+      {
+        auto ar = StreamingSerializationHandler<>::make_streaming_packing_archive(
+          [&](char const*, std::size_t) {
+            if(++calls == 3) throw std::runtime_error("disk full");
+          },
+          /* chunk_size = */ 256, n_chunks
+        );
+        ar | input;
+        StreamingSerializationHandler<>::finish_streaming(std::move(ar));
+      },
+      std::runtime_error
+    );
+    EXPECT_THAT(calls, Eq(3));
+  }
+}
+#endif
+
+TEST_F(TestSimpleSerializationHandler, streaming_unpack_small_reads) {
+  auto input = make_nested();
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  std::string packed(buffer.data(), buffer.capacity());
+  StringSource source{ packed, 7 };
+  auto output = StreamingSerializationHandler<>::deserialize_streaming<nested_t>(
+    std::ref(source)
+  );
+  EXPECT_THAT(output, ContainerEq(input));
+  EXPECT_THAT(source.offset, Eq(packed.size()));
+}
+
+TEST_F(TestSimpleSerializationHandler, streaming_unpack_large_raw_data_direct) {
+  std::vector<double> input(10000);
+  for(std::size_t i = 0; i < input.size(); ++i) input[i] = 0.25 * i;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  std::string packed(buffer.data(), buffer.capacity());
+  StringSource source{ packed, packed.size() };
+  auto ar = StreamingSerializationHandler<>::make_streaming_unpacking_archive(
+    std::ref(source), /* staging_size = */ 1024
+  );
+  auto output = ar.unpack_next_item_as<std::vector<double>>();
+  EXPECT_THAT(output, ContainerEq(input));
+  // The elements were read straight into the vector, not through staging
+  EXPECT_THAT(source.largest_request, Gt(1024));
+}
+
+TEST_F(TestSimpleSerializationHandler, streaming_round_trip) {
+  auto input = make_nested();
+  std::string streamed;
+  StreamingSerializationHandler<>::serialize_streaming(
+    [&](char const* data, std::size_t n) { streamed.append(data, n); },
+    input, std::vector<double>(5000, 1.5)
+  );
+  StringSource source{ streamed, 4096 };
+  auto ar = StreamingSerializationHandler<>::make_streaming_unpacking_archive(
+    std::ref(source), /* staging_size = */ 256
+  );
+  auto output = ar.unpack_next_item_as<nested_t>();
+  auto output_values = ar.unpack_next_item_as<std::vector<double>>();
+  EXPECT_THAT(output, ContainerEq(input));
+  EXPECT_THAT(output_values, ContainerEq(std::vector<double>(5000, 1.5)));
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, streaming_unpack_end_of_stream) {
+  std::vector<double> input(1000, 1.0);
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  // Cut off partway through the elements
+  std::string packed(buffer.data(), buffer.capacity() / 2);
+  StringSource source{ packed, 100 };
+  EXPECT_THROW(
+    StreamingSerializationHandler<>::deserialize_streaming<std::vector<double>>(std::ref(source)),
+    std::runtime_error
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, streaming_unpack_end_of_stream_string) {
+  std::string input(1000, 'x');
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  std::string packed(buffer.data(), buffer.capacity() / 2);
+  StringSource source{ packed, 100 };
+  EXPECT_THROW(
+    StreamingSerializationHandler<>::deserialize_streaming<std::string>(std::ref(source)),
+    std::runtime_error
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, streaming_unpack_end_of_stream_map) {
+  using counting_string_t = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+  using pair_t = std::pair<int const, counting_string_t>;
+  using map_t = std::map<int, counting_string_t, std::less<int>, CountingAllocator<pair_t>>;
+  std::map<int, std::string> input;
+  for(int i = 0; i < 20; ++i) {
+    // Long enough to defeat the small string optimization
+    input[i] = std::string(100, static_cast<char>('a' + i));
+  }
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  // Cut off partway through the elements
+  std::string packed(buffer.data(), buffer.capacity() / 2);
+  StringSource source{ packed, 100 };
+  allocation_counts counts;
+  {
+    auto ar = StreamingSerializationHandler<CountingAllocator<char>>::make_streaming_unpacking_archive(
+      std::ref(source), /* staging_size = */ 256, CountingAllocator<char>(counts)
+    );
+    EXPECT_THROW(ar.unpack_next_item_as<map_t>(), std::runtime_error);
+  }
+  // The nodes and strings that were unpacked before the stream ran out
+  // were all freed
+  EXPECT_THAT(counts.allocations, Gt(2));
+  EXPECT_THAT(counts.deallocations, Eq(counts.allocations));
+}
+#endif
@@ -0,0 +1,161 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_unpack_allocations.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/map.h>
+#include <darma/serialization/serializers/standard_library/vector.h>
+#include <darma/serialization/serializers/standard_library/string.h>
+#include <darma/serialization/serializers/standard_library/tuple.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+#include <darma/serialization/serializers/array.h>
+
+#include <darma/serialization/simple_handler.h>
+#include <darma/serialization/pointer_reference_handler.h>
+
+#include "test_simple_common.h"
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+struct allocation_counts {
+  std::size_t allocations = 0;
+  std::size_t deallocations = 0;
+};
+
+// A stateful allocator that counts the allocations made through it (and
+// through all of its rebound copies)
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+
+  explicit CountingAllocator(allocation_counts& counts) : counts(&counts) { }
+  template <typename U>
+  CountingAllocator(CountingAllocator<U> const& other) : counts(other.counts) { }
+
+  T* allocate(std::size_t n) {
+    ++counts->allocations;
+    return std::allocator<T>{}.allocate(n);
+  }
+  void deallocate(T* ptr, std::size_t n) {
+    ++counts->deallocations;
+    std::allocator<T>{}.deallocate(ptr, n);
+  }
+
+  template <typename U>
+  bool operator==(CountingAllocator<U> const& other) const { return counts == other.counts; }
+  template <typename U>
+  bool operator!=(CountingAllocator<U> const& other) const { return counts != other.counts; }
+
+  allocation_counts* counts;
+};
+
+using counting_string_t = std::basic_string<char, std::char_traits<char>, CountingAllocator<char>>;
+template <typename T>
+using counting_vector_t = std::vector<T, CountingAllocator<T>>;
+using counting_handler_t = SimpleSerializationHandler<CountingAllocator<char>>;
+
+// Long enough to defeat the small string optimization
+static const std::string long_string(100, 'x');
+
+TEST_F(TestSimpleSerializationHandler, unpack_vector_of_strings_allocates_once_per_string) {
+  std::vector<std::string> input(10, long_string);
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+
+  allocation_counts counts;
+  {
+    auto ar = counting_handler_t::make_unpacking_archive(
+      buffer, CountingAllocator<char>(counts)
+    );
+    auto output = ar.unpack_next_item_as<counting_vector_t<counting_string_t>>();
+    // One for the vector's storage and one for each string
+    EXPECT_THAT(counts.allocations, Eq(1 + input.size()));
+    ASSERT_THAT(output.size(), Eq(input.size()));
+    EXPECT_THAT(std::string(output[9].begin(), output[9].end()), Eq(long_string));
+  }
+  EXPECT_THAT(counts.deallocations, Eq(counts.allocations));
+}
+
+TEST_F(TestSimpleSerializationHandler, unpack_map_of_strings_allocates_once_per_string) {
+  using pair_t = std::pair<int const, counting_string_t>;
+  using map_t = std::map<int, counting_string_t, std::less<int>, CountingAllocator<pair_t>>;
+  std::map<int, std::string> input{{1, long_string}, {2, long_string}, {3, long_string}};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+
+  allocation_counts counts;
+  {
+    auto ar = counting_handler_t::make_unpacking_archive(
+      buffer, CountingAllocator<char>(counts)
+    );
+    auto output = ar.unpack_next_item_as<map_t>();
+    // One for each node and one for each string
+    EXPECT_THAT(counts.allocations, Eq(2 * input.size()));
+    EXPECT_THAT(std::string(output.at(2).begin(), output.at(2).end()), Eq(long_string));
+  }
+  EXPECT_THAT(counts.deallocations, Eq(counts.allocations));
+}
+
+TEST_F(TestSimpleSerializationHandler, unpack_large_item_uses_archive_allocator) {
+  using T = std::tuple<counting_string_t, double[200]>;
+  static_assert(sizeof(T) > DARMA_SERIALIZATION_SIMPLE_ARCHIVE_UNPACK_STACK_ALLOCATION_MAX,
+    "test needs a type that isn't unpacked on the stack"
+  );
+  std::tuple<std::string, double[200]> input;
+  std::get<0>(input) = long_string;
+  for(int i = 0; i < 200; ++i) std::get<1>(input)[i] = i;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+
+  allocation_counts counts;
+  {
+    char const* data = buffer.data();
+    auto ar = PointerReferenceSerializationHandler<>::make_unpacking_archive(
+      data, CountingAllocator<char>(counts)
+    );
+    auto output = ar.unpack_next_item_as<T>();
+    // One for the temporary storage (which is freed again) and one for the string
+    EXPECT_THAT(counts.allocations, Eq(2));
+    EXPECT_THAT(counts.deallocations, Eq(1));
+    EXPECT_THAT(std::get<1>(output)[199], DoubleEq(199));
+    EXPECT_THAT(data, Eq(buffer.data() + buffer.capacity()));
+  }
+  EXPECT_THAT(counts.deallocations, Eq(2));
+}
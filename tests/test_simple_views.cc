@@ -0,0 +1,169 @@
+/*
+//@HEADER
+// ************************************************************************
+//
+//                      test_simple_views.cc
+//                         DARMA
+//              Copyright (C) 2018 Sandia Corporation
+//
+// Under the terms of Contract DE-NA-0003525 with NTESS, LLC,
+// the U.S. Government retains certain rights in this software.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+//
+// 3. Neither the name of the Corporation nor the names of the
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY SANDIA CORPORATION "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL SANDIA CORPORATION OR THE
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+// EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Questions? Contact darma@sandia.gov
+//
+// ************************************************************************
+//@HEADER
+*/
+
+#include <darma/serialization/serializers/standard_library/vector.h>
+#include <darma/serialization/serializers/standard_library/string.h>
+#include <darma/serialization/serializers/arithmetic_types.h>
+#include <darma/serialization/serializers/array.h>
+
+#include <darma/serialization/simple_handler.h>
+#include <darma/serialization/pointer_reference_handler.h>
+
+#include "test_simple_common.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace darma::serialization;
+using namespace ::testing;
+
+static_assert(std::is_same<view_type_t<std::vector<double>>, ArrayView<double>>::value, "");
+static_assert(std::is_same<view_type_t<std::string>, StringView>::value, "");
+static_assert(std::is_same<view_type_t<int[4]>, ArrayView<int>>::value, "");
+
+namespace {
+
+template <typename SerializationBuffer>
+bool points_into(SerializationBuffer const& buffer, void const* ptr) {
+  auto* begin = static_cast<char const*>(static_cast<void const*>(buffer.data()));
+  auto* p = static_cast<char const*>(ptr);
+  return begin <= p and p < begin + buffer.capacity();
+}
+
+} // end anonymous namespace
+
+TEST_F(TestSimpleSerializationHandler, view_vector_double) {
+  std::vector<double> input{1.5, 2.5, 3.5, 4.5};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto view = SimpleSerializationHandler<>::deserialize_view<std::vector<double>>(buffer);
+  EXPECT_THAT(view, ElementsAre(1.5, 2.5, 3.5, 4.5));
+  EXPECT_TRUE(points_into(buffer, view.data()));
+  EXPECT_EQ(view.size_bytes(), sizeof(double) * input.size());
+}
+
+TEST_F(TestSimpleSerializationHandler, view_vector_empty) {
+  std::vector<int> input;
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto view = SimpleSerializationHandler<>::deserialize_view<std::vector<int>>(buffer);
+  EXPECT_TRUE(view.empty());
+  EXPECT_EQ(view.begin(), view.end());
+}
+
+TEST_F(TestSimpleSerializationHandler, view_string) {
+  std::string input = "hello world";
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto view = SimpleSerializationHandler<>::deserialize_view<std::string>(buffer);
+  EXPECT_EQ(view.size(), input.size());
+  EXPECT_TRUE(view == input);
+  EXPECT_EQ(view.to_string(), input);
+  EXPECT_TRUE(points_into(buffer, view.data()));
+}
+
+TEST_F(TestSimpleSerializationHandler, view_c_array) {
+  int input[4] = {1, 2, 3, 4};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  auto view = SimpleSerializationHandler<>::deserialize_view<int[4]>(buffer);
+  EXPECT_THAT(view, ElementsAre(1, 2, 3, 4));
+  EXPECT_TRUE(points_into(buffer, view.data()));
+}
+
+TEST_F(TestSimpleSerializationHandler, view_mixed_with_unpack) {
+  // Views and regular unpacks can be interleaved on the same archive
+  std::vector<double> values{1.0, 2.0, 3.0};
+  std::string name = "temperature";
+  int shape[2] = {3, 1};
+  auto buffer = SimpleSerializationHandler<>::serialize(values, shape, name, 42);
+  auto ar = SimpleSerializationHandler<>::make_unpacking_archive(buffer);
+  auto values_view = ar.unpack_next_item_as_view<std::vector<double>>();
+  auto shape_view = ar.unpack_next_item_as_view<int[2]>();
+  auto name_copy = ar.unpack_next_item_as<std::string>();
+  auto answer = ar.unpack_next_item_as<int>();
+  EXPECT_THAT(values_view, ElementsAre(1.0, 2.0, 3.0));
+  EXPECT_THAT(shape_view, ElementsAre(3, 1));
+  EXPECT_EQ(name_copy, name);
+  EXPECT_EQ(answer, 42);
+}
+
+TEST_F(TestSimpleSerializationHandler, view_pointer_reference) {
+  std::vector<int> input{1, 2, 3};
+  auto buffer = SimpleSerializationHandler<>::serialize(input, std::string("abc"));
+  char const* data = buffer.data();
+  auto ar = PointerReferenceSerializationHandler<>::make_unpacking_archive(data);
+  auto ints = ar.unpack_next_item_as_view<std::vector<int>>();
+  auto chars = ar.unpack_next_item_as_view<std::string>();
+  EXPECT_THAT(ints, ElementsAre(1, 2, 3));
+  EXPECT_TRUE(chars == std::string("abc"));
+  // Advanced exactly as far as a regular unpack would have
+  EXPECT_EQ(data, buffer.data() + buffer.capacity());
+}
+
+#ifndef DARMA_SERIALIZATION_NO_EXCEPTIONS
+TEST_F(TestSimpleSerializationHandler, view_misaligned_throws) {
+  // The packed layout puts the doubles right after the char and size prefix,
+  // nine bytes in
+  std::vector<double> values{1.0, 2.0};
+  auto buffer = SimpleSerializationHandler<>::serialize('x', values);
+  auto ar = SimpleSerializationHandler<>::make_unpacking_archive(buffer);
+  EXPECT_EQ(ar.unpack_next_item_as<char>(), 'x');
+  EXPECT_THROW(ar.unpack_next_item_as_view<std::vector<double>>(), std::runtime_error);
+  // With padding, the same data can be viewed
+  auto aligned = AlignedSerializationHandler<>::serialize('x', values);
+  auto aligned_ar = AlignedSerializationHandler<>::make_unpacking_archive(aligned);
+  EXPECT_EQ(aligned_ar.unpack_next_item_as<char>(), 'x');
+  EXPECT_THAT(aligned_ar.unpack_next_item_as_view<std::vector<double>>(),
+    ElementsAre(1.0, 2.0)
+  );
+}
+
+TEST_F(TestSimpleSerializationHandler, view_truncated_throws) {
+  std::vector<double> input{1.5, 2.5, 3.5, 4.5};
+  auto buffer = SimpleSerializationHandler<>::serialize(input);
+  ConstNonOwningSerializationBuffer truncated(buffer.data(), buffer.capacity() - 1);
+  EXPECT_THROW(
+    SimpleSerializationHandler<>::deserialize_view<std::vector<double>>(truncated),
+    std::runtime_error
+  );
+}
+#endif